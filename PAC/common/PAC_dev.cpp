@@ -1,3 +1,5 @@
+#include <climits>
+
 #include "PAC_dev.h"
 #include "tech_def.h"
 
@@ -5,6 +7,7 @@
 #include "lua_manager.h"
 #include "log.h"
 #include "PID.h"
+#include "subscription_mngr.h"
 
 #ifdef WIN_OS
 #pragma warning(push)
@@ -2266,6 +2269,11 @@ io_device* device_manager::add_io_device( int dev_type, int dev_sub_type,
 //-----------------------------------------------------------------------------
 void device_manager::clear_io_devices()
     {
+    //Ошибки удаляемых устройств.
+    G_ERRORS_MANAGER->remove_dev_errors();
+    //Подписки на изменения удаляемых устройств.
+    subscription_manager::on_devices_clear();
+
     for ( size_t idx = 0; idx < project_devices.size(); idx++ )
         {
         delete project_devices[ idx ];
@@ -2280,6 +2288,57 @@ void device_manager::clear_io_devices()
         }
 
     project_devices.clear();
+    errors.clear();
+    errors_valid = false;
+
+    states.clear();
+    changed_devices.clear();
+    is_changed.clear();
+    }
+//-----------------------------------------------------------------------------
+void device_manager::update_errors()
+    {
+    errors.assign( ( project_devices.size() + 31 ) / 32, 0 );
+
+    //Состояние новых устройств считается изменившимся.
+    states.resize( project_devices.size(), INT_MIN );
+    is_changed.resize( project_devices.size(), false );
+
+    for ( u_int i = 0; i < project_devices.size(); i++ )
+        {
+        auto dev = project_devices[ i ];
+        int state = dev->get_state();
+        if ( state != states[ i ] )
+            {
+            states[ i ] = state;
+            if ( !is_changed[ i ] )
+                {
+                is_changed[ i ] = true;
+                changed_devices.push_back( i );
+                }
+            }
+
+        if ( state < 0 )
+            {
+            auto err_par = dev->get_err_par();
+            int par = err_par ? int( ( *err_par )[ 1 ] ) : 0;
+            if ( !( par & base_error::P_IS_SUPPRESS ) )
+                {
+                errors[ i / 32 ] |= 1UL << i % 32;
+                }
+            }
+        }
+
+    errors_valid = true;
+    }
+//-----------------------------------------------------------------------------
+void device_manager::clear_changed_devices()
+    {
+    for ( auto i : changed_devices )
+        {
+        is_changed[ i ] = false;
+        }
+    changed_devices.clear();
     }
 //-----------------------------------------------------------------------------
 int device_manager::init_params()
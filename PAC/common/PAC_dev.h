@@ -5029,7 +5029,7 @@ class device_manager: public i_Lua_save_device
 
         device* get_stub_device()
             {
-            return dynamic_cast<device*>( dynamic_cast<valve*>( &stub ) );
+            return static_cast<valve*>( &stub );
             }
 
         int init_params();
@@ -5042,6 +5042,49 @@ class device_manager: public i_Lua_save_device
                 {
                 project_devices[ i ]->evaluate_io();
                 }
+
+            update_errors();
+            }
+
+        /// @brief Расчет признаков ошибок устройств.
+        ///
+        /// Выполняется раз в цикл (после опроса устройств). Признак
+        /// устанавливается для устройства в ошибке, если ошибка не подавлена.
+        /// Далее проверки устройств шагов выполняются по этим признакам.
+        void update_errors();
+
+        /// @brief Рассчитаны ли признаки ошибок устройств.
+        bool is_errors_valid() const
+            {
+            return errors_valid;
+            }
+
+        /// @brief Получение слова признаков ошибок устройств.
+        ///
+        /// @param idx - номер слова (бит слова - устройство с порядковым
+        /// номером idx * 32 + номер бита).
+        u_int_4 get_errors_word( u_int idx ) const
+            {
+            return idx < errors.size() ? errors[ idx ] : 0;
+            }
+
+        /// @brief Получение номеров устройств, состояние которых изменилось.
+        ///
+        /// Изменения определяются при расчете признаков ошибок
+        /// (@ref update_errors) и накапливаются до вызова
+        /// @ref clear_changed_devices.
+        const std::vector< u_int >& get_changed_devices() const
+            {
+            return changed_devices;
+            }
+
+        /// @brief Очистка номеров устройств с изменившимся состоянием.
+        void clear_changed_devices();
+
+        /// @brief Получение количества устройств.
+        u_int get_devices_count() const
+            {
+            return project_devices.size();
             }
 
 #ifdef __BORLANDC__
@@ -5078,6 +5121,13 @@ class device_manager: public i_Lua_save_device
 
         std::vector< device* > project_devices; ///< Все устройства.
 
+        std::vector< u_int_4 > errors;  ///< Признаки ошибок устройств.
+        bool errors_valid = false;
+
+        std::vector< int > states;  ///< Состояния устройств (@ref update_errors).
+        std::vector< u_int > changed_devices;   ///< Изменившиеся устройства.
+        std::vector< bool > is_changed;         ///< Есть ли в changed_devices.
+
         /// @brief Единственный экземпляр класса.
         static auto_smart_ptr < device_manager > instance;
 
@@ -0,0 +1,278 @@
+/// @file PAC_dev_lua_fast.cpp
+/// @brief Быстрые (без проверок tolua++) методы устройств для Lua.
+///
+/// Сгенерированные tolua++ обертки методов при каждом вызове проверяют тип
+/// объекта (с поиском по имени класса с учетом наследования) и параметры.
+/// Для наиболее часто вызываемых методов устройств в метатаблицы классов
+/// записываются функции, проверяющие тип одним сравнением метатаблицы
+/// объекта с метатаблицей класса. Если тип или параметры не совпадают,
+/// вызывается исходная обертка tolua++ (с выводом ошибки).
+
+#include "tolua++.h"
+
+#include "PAC_dev.h"
+#include "lua_manager.h"
+//-----------------------------------------------------------------------------
+namespace
+    {
+    /// @brief Получение объекта.
+    ///
+    /// upvalue 1 - метатаблица класса, upvalue 2 - обертка tolua++.
+    ///
+    /// @param params_cnt - количество параметров (без объекта).
+    ///
+    /// @return nullptr - тип объекта или количество параметров не совпадают.
+    template < class T > T* get_self( lua_State* L, int params_cnt )
+        {
+        if ( lua_gettop( L ) != params_cnt + 1 ) return nullptr;
+        if ( !lua_getmetatable( L, 1 ) ) return nullptr;
+
+        bool is_same_class = lua_rawequal( L, -1, lua_upvalueindex( 1 ) ) != 0;
+        lua_pop( L, 1 );
+        if ( !is_same_class ) return nullptr;
+
+        return *static_cast< T** >( lua_touserdata( L, 1 ) );
+        }
+
+    /// @brief Вызов обертки tolua++ с теми же параметрами.
+    int call_tolua( lua_State* L )
+        {
+        lua_pushvalue( L, lua_upvalueindex( 2 ) );
+        lua_insert( L, 1 );
+        lua_call( L, lua_gettop( L ) - 1, LUA_MULTRET );
+        return lua_gettop( L );
+        }
+
+    template < class T > int get_state( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        lua_pushnumber( L, ( lua_Number ) self->get_state() );
+        return 1;
+        }
+
+    template < class T > int get_value( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        lua_pushnumber( L, ( lua_Number ) self->get_value() );
+        return 1;
+        }
+
+    template < class T > int is_active( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        lua_pushboolean( L, self->is_active() );
+        return 1;
+        }
+
+    template < class T > int is_opened( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        lua_pushboolean( L, self->is_opened() );
+        return 1;
+        }
+
+    template < class T > int is_closed( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        lua_pushboolean( L, self->is_closed() );
+        return 1;
+        }
+
+    template < class T > int on( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        self->on();
+        return 0;
+        }
+
+    template < class T > int off( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        self->off();
+        return 0;
+        }
+
+    template < class T > int instant_off( lua_State* L )
+        {
+        T* self = get_self< T >( L, 0 );
+        if ( nullptr == self ) return call_tolua( L );
+
+        self->instant_off();
+        return 0;
+        }
+
+    template < class T > int set_state( lua_State* L )
+        {
+        T* self = get_self< T >( L, 1 );
+        if ( nullptr == self || LUA_TNUMBER != lua_type( L, 2 ) )
+            {
+            return call_tolua( L );
+            }
+
+        self->set_state( ( int ) lua_tonumber( L, 2 ) );
+        return 0;
+        }
+
+    template < class T > int set_value( lua_State* L )
+        {
+        T* self = get_self< T >( L, 1 );
+        if ( nullptr == self || LUA_TNUMBER != lua_type( L, 2 ) )
+            {
+            return call_tolua( L );
+            }
+
+        self->set_value( ( float ) lua_tonumber( L, 2 ) );
+        return 0;
+        }
+
+    struct method
+        {
+        const char* name;
+        lua_CFunction f;
+        };
+
+    /// @brief Запись быстрых методов в метатаблицу класса.
+    ///
+    /// Метод записывается, только если у класса (или его базовых классов)
+    /// есть соответствующая обертка tolua++.
+    void reg_methods( lua_State* L, const char* class_name,
+        const method* methods, size_t cnt )
+        {
+        luaL_getmetatable( L, class_name );
+        if ( !lua_istable( L, -1 ) )
+            {
+            lua_pop( L, 1 );
+            return;
+            }
+        int mt = lua_gettop( L );
+
+        for ( size_t i = 0; i < cnt; i++ )
+            {
+            //Поиск обертки по цепочке метатаблиц базовых классов.
+            lua_pushvalue( L, mt );
+            while ( true )
+                {
+                lua_pushstring( L, methods[ i ].name );
+                lua_rawget( L, -2 );
+                if ( !lua_isnil( L, -1 ) ) break;
+
+                lua_pop( L, 1 );
+                if ( !lua_getmetatable( L, -1 ) )
+                    {
+                    lua_pushnil( L );
+                    break;
+                    }
+                lua_remove( L, -2 );
+                }
+            lua_remove( L, -2 );
+
+            if ( !lua_iscfunction( L, -1 ) )
+                {
+                lua_pop( L, 1 );
+                continue;
+                }
+
+            lua_pushstring( L, methods[ i ].name );
+            lua_insert( L, -2 );
+            lua_pushvalue( L, mt );
+            lua_insert( L, -2 );
+            lua_pushcclosure( L, methods[ i ].f, 2 );
+            lua_rawset( L, mt );
+            }
+
+        lua_pop( L, 1 );
+        }
+
+    template < class T > void reg_DO_AO_methods( lua_State* L,
+        const char* class_name )
+        {
+        const method methods[] =
+            {
+                { "get_state", get_state< T > },
+                { "get_value", get_value< T > },
+                { "is_active", is_active< T > },
+                { "on", on< T > },
+                { "off", off< T > },
+                { "instant_off", instant_off< T > },
+                { "set_state", set_state< T > },
+                { "set_value", set_value< T > },
+            };
+        reg_methods( L, class_name, methods,
+            sizeof( methods ) / sizeof( methods[ 0 ] ) );
+        }
+    }
+//-----------------------------------------------------------------------------
+int tolua_PAC_dev_fast_open( lua_State* L )
+    {
+    const method DI_methods[] =
+        {
+            { "get_state", get_state< i_DI_device > },
+            { "is_active", is_active< i_DI_device > },
+        };
+    reg_methods( L, "i_DI_device", DI_methods,
+        sizeof( DI_methods ) / sizeof( DI_methods[ 0 ] ) );
+
+    const method DO_methods[] =
+        {
+            { "get_state", get_state< i_DO_device > },
+            { "is_active", is_active< i_DO_device > },
+            { "on", on< i_DO_device > },
+            { "off", off< i_DO_device > },
+            { "instant_off", instant_off< i_DO_device > },
+            { "set_state", set_state< i_DO_device > },
+        };
+    reg_methods( L, "i_DO_device", DO_methods,
+        sizeof( DO_methods ) / sizeof( DO_methods[ 0 ] ) );
+
+    const method AI_methods[] =
+        {
+            { "get_state", get_state< i_AI_device > },
+            { "get_value", get_value< i_AI_device > },
+        };
+    reg_methods( L, "i_AI_device", AI_methods,
+        sizeof( AI_methods ) / sizeof( AI_methods[ 0 ] ) );
+
+    const method AO_methods[] =
+        {
+            { "get_state", get_state< i_AO_device > },
+            { "get_value", get_value< i_AO_device > },
+            { "off", off< i_AO_device > },
+            { "set_value", set_value< i_AO_device > },
+        };
+    reg_methods( L, "i_AO_device", AO_methods,
+        sizeof( AO_methods ) / sizeof( AO_methods[ 0 ] ) );
+
+    reg_DO_AO_methods< i_DO_AO_device >( L, "i_DO_AO_device" );
+    reg_DO_AO_methods< device >( L, "device" );
+    reg_DO_AO_methods< signal_column >( L, "signal_column" );
+
+    const method valve_methods[] =
+        {
+            { "get_state", get_state< valve > },
+            { "is_opened", is_opened< valve > },
+            { "is_closed", is_closed< valve > },
+            { "on", on< valve > },
+            { "off", off< valve > },
+            { "instant_off", instant_off< valve > },
+            { "set_state", set_state< valve > },
+        };
+    reg_methods( L, "valve", valve_methods,
+        sizeof( valve_methods ) / sizeof( valve_methods[ 0 ] ) );
+
+    return 1;
+    }
+//-----------------------------------------------------------------------------
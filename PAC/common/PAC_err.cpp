@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "log.h"
+#include "alarm_history.h"
 
 #ifdef WIN_OS
 extern const char* WSA_Last_Err_Decode ();
@@ -96,6 +97,8 @@ void PAC_critical_errors_manager::set_global_error( ALARM_CLASS eclass,
 
         errors.emplace_back( eclass, p1, p2 );
         errors_id++;
+
+        G_ALARM_HISTORY->add( alarm_history::S_CRITICAL, 1, eclass, p1, p2, 0 );
         }
     }
 //-----------------------------------------------------------------------------
@@ -122,6 +125,8 @@ void PAC_critical_errors_manager::reset_global_error( ALARM_CLASS eclass,
         G_LOG->write_log( i_log::P_INFO );
 
         errors_id++;
+
+        G_ALARM_HISTORY->add( alarm_history::S_CRITICAL, 0, eclass, p1, p2, 0 );
         }
     }
 //-----------------------------------------------------------------------------
@@ -0,0 +1,219 @@
+#include "alarm_history.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+#ifdef LINUX_OS
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif // LINUX_OS
+
+#include "log.h"
+
+auto_smart_ptr < alarm_history > alarm_history::instance;
+//-----------------------------------------------------------------------------
+alarm_history* alarm_history::get_instance()
+    {
+    if ( instance.is_null() )
+        {
+        instance = new alarm_history();
+        }
+
+    return instance;
+    }
+//-----------------------------------------------------------------------------
+alarm_history::alarm_history() : hdr( nullptr ), records( nullptr ),
+    data( nullptr ), data_size( 0 ), is_dirty( false )
+    {
+    use_heap( C_DEFAULT_CAPACITY );
+    }
+//-----------------------------------------------------------------------------
+alarm_history::~alarm_history()
+    {
+    close();
+    }
+//-----------------------------------------------------------------------------
+void alarm_history::close()
+    {
+#ifdef LINUX_OS
+    if ( data )
+        {
+        sync();
+        munmap( data, data_size );
+        }
+#endif // LINUX_OS
+
+    data = nullptr;
+    data_size = 0;
+    hdr = nullptr;
+    records = nullptr;
+    heap_data.clear();
+    }
+//-----------------------------------------------------------------------------
+void alarm_history::use_heap( u_int capacity )
+    {
+    heap_data.assign( sizeof( header ) + capacity * sizeof( record ), 0 );
+    hdr = reinterpret_cast< header* >( heap_data.data() );
+    records = reinterpret_cast< record* >( heap_data.data() + sizeof( header ) );
+
+    hdr->signature = C_SIGNATURE;
+    hdr->version = C_VERSION;
+    hdr->record_size = sizeof( record );
+    hdr->capacity = capacity;
+    hdr->next_n = 0;
+    }
+//-----------------------------------------------------------------------------
+int alarm_history::init( const char* file_name, u_int capacity )
+    {
+    close();
+    if ( 0 == capacity ) capacity = C_DEFAULT_CAPACITY;
+
+#ifdef LINUX_OS
+    if ( file_name )
+        {
+        u_int size = sizeof( header ) + capacity * sizeof( record );
+        int f = open( file_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR );
+        if ( f < 0 )
+            {
+            G_LOG->error( "Alarm history - can't open file \"%s\" : %s.",
+                file_name, strerror( errno ) );
+            use_heap( capacity );
+            return 1;
+            }
+
+        struct stat st;
+        if ( fstat( f, &st ) < 0 || st.st_size != ( off_t ) size )
+            {
+            if ( ftruncate( f, size ) < 0 )
+                {
+                G_LOG->error( "Alarm history - can't resize file \"%s\" : %s.",
+                    file_name, strerror( errno ) );
+                ::close( f );
+                use_heap( capacity );
+                return 1;
+                }
+            }
+
+        void* res = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+            f, 0 );
+        ::close( f );
+        if ( MAP_FAILED == res )
+            {
+            G_LOG->error( "Alarm history - can't map file \"%s\" : %s.",
+                file_name, strerror( errno ) );
+            use_heap( capacity );
+            return 1;
+            }
+
+        data = static_cast< char* >( res );
+        data_size = size;
+        hdr = reinterpret_cast< header* >( data );
+        records = reinterpret_cast< record* >( data + sizeof( header ) );
+
+        if ( hdr->signature != C_SIGNATURE || hdr->version != C_VERSION ||
+            hdr->record_size != sizeof( record ) || hdr->capacity != capacity )
+            {
+            memset( data, 0, data_size );
+            hdr->signature = C_SIGNATURE;
+            hdr->version = C_VERSION;
+            hdr->record_size = sizeof( record );
+            hdr->capacity = capacity;
+            hdr->next_n = 0;
+            is_dirty = true;
+            sync();
+            }
+
+        return 0;
+        }
+#endif // LINUX_OS
+
+    use_heap( capacity );
+    return file_name ? 1 : 0;
+    }
+//-----------------------------------------------------------------------------
+void alarm_history::add( SOURCE source, u_char state, u_int alarm_class,
+    u_int alarm_subclass, u_int object_n, int value )
+    {
+    auto now = std::chrono::duration_cast< std::chrono::milliseconds >(
+        std::chrono::system_clock::now().time_since_epoch() ).count();
+
+    record& r = records[ hdr->next_n % hdr->capacity ];
+    r.time = static_cast< u_int_4 >( now / 1000 );
+    r.time_ms = static_cast< u_int_2 >( now % 1000 );
+    r.source = static_cast< u_char >( source );
+    r.state = state;
+    r.alarm_class = static_cast< u_int_2 >( alarm_class );
+    r.alarm_subclass = static_cast< u_int_2 >( alarm_subclass );
+    r.object_n = object_n;
+    r.value = value;
+
+    //Счетчик изменяется после записи события - при аварийном завершении
+    //в истории не будет частично записанного события.
+    hdr->next_n++;
+    is_dirty = true;
+    }
+//-----------------------------------------------------------------------------
+void alarm_history::sync()
+    {
+    if ( !is_dirty ) return;
+    is_dirty = false;
+
+#ifdef LINUX_OS
+    if ( data && msync( data, data_size, MS_SYNC ) < 0 )
+        {
+        G_LOG->error( "Alarm history - sync error : %s.", strerror( errno ) );
+        }
+#endif // LINUX_OS
+    }
+//-----------------------------------------------------------------------------
+u_int alarm_history::get_count() const
+    {
+    return hdr->next_n < hdr->capacity ? hdr->next_n : hdr->capacity;
+    }
+//-----------------------------------------------------------------------------
+const alarm_history::record* alarm_history::get_record( u_int idx ) const
+    {
+    u_int cnt = get_count();
+    if ( idx >= cnt ) return nullptr;
+
+    return &records[ ( hdr->next_n - cnt + idx ) % hdr->capacity ];
+    }
+//-----------------------------------------------------------------------------
+int alarm_history::save_as_Lua_str( char* buff, int max_size,
+    u_int_4 from_time, u_int_4 to_time ) const
+    {
+    //Максимальный размер одной записи.
+    const int MAX_RECORD_SIZE = 160;
+
+    int res = snprintf( buff, max_size, "alarm_history =\n  {\n" );
+    bool is_truncated = false;
+
+    u_int cnt = get_count();
+    for ( u_int i = 0; i < cnt; i++ )
+        {
+        auto r = get_record( i );
+        if ( r->time < from_time || ( to_time && r->time > to_time ) ) continue;
+
+        if ( res + MAX_RECORD_SIZE > max_size )
+            {
+            is_truncated = true;
+            break;
+            }
+
+        res += snprintf( buff + res, max_size - res,
+            "  { time = %u, ms = %u, source = %u, state = %u, class = %u, "
+            "subclass = %u, n = %u, value = %d },\n",
+            r->time, r->time_ms, r->source, r->state, r->alarm_class,
+            r->alarm_subclass, r->object_n, r->value );
+        }
+
+    res += snprintf( buff + res, max_size - res, "  is_truncated = %s,\n  }\n",
+        is_truncated ? "true" : "false" );
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
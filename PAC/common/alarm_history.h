@@ -0,0 +1,130 @@
+/// @file alarm_history.h
+/// @brief Сохраняемая история тревог.
+///
+/// Изменения состояний ошибок (@ref errors_manager) и критических ошибок
+/// PAC (@ref PAC_critical_errors_manager) записываются в кольцевой буфер
+/// двоичных записей фиксированного размера. Буфер отображается на файл
+/// (mmap), поэтому запись события - копирование в память без системных
+/// вызовов, а история сохраняется после перезапуска. Измененные страницы
+/// записываются в файл ядром (как и для @ref mapped_SRAM), синхронизация с
+/// ожиданием записи выполняется только при закрытии файла - вне основного
+/// цикла.
+///
+/// Без поддержки mmap (Windows) история хранится только в памяти.
+///
+/// Чтение - командой @ref device_communicator::CMD_GET_ALARM_HISTORY.
+
+#ifndef ALARM_HISTORY_H
+#define ALARM_HISTORY_H
+
+#include <vector>
+
+#include "smart_ptr.h"
+#include "dtime.h"
+//-----------------------------------------------------------------------------
+/// @brief История тревог.
+class alarm_history
+    {
+    public:
+        enum CONSTANTS
+            {
+            C_DEFAULT_CAPACITY = 4096,  ///< Количество записей по умолчанию.
+
+            C_SIGNATURE = 0x48524C41,   ///< "ALRH".
+            C_VERSION = 1,
+            };
+
+        /// @brief Источник события.
+        enum SOURCE
+            {
+            S_ERROR = 0,    ///< Ошибка устройства, объекта (@ref base_error).
+            S_CRITICAL,     ///< Критическая ошибка PAC.
+            };
+
+        /// @brief Событие (запись истории).
+        struct record
+            {
+            u_int_4 time;           ///< Время, с (UTC).
+            u_int_2 time_ms;        ///< Миллисекунды времени.
+            u_char  source;         ///< Источник события (@ref SOURCE).
+            u_char  state;          ///< Состояние тревоги.
+            u_int_2 alarm_class;    ///< Тип объекта, класс критической ошибки.
+            u_int_2 alarm_subclass; ///< Подкласс критической ошибки.
+            u_int_4 object_n;       ///< Номер устройства, объекта.
+            int_4   value;          ///< Значение (состояние устройства...).
+            };
+
+        /// @brief Получение единственного экземпляра класса.
+        static alarm_history* get_instance();
+
+        /// @brief Задание файла истории.
+        ///
+        /// Если файл создан с другим размером буфера (или поврежден),
+        /// история очищается.
+        ///
+        /// @param file_name - имя файла (nullptr - только в памяти).
+        /// @param capacity  - количество записей.
+        ///
+        /// @return 0 - ок, 1 - ошибка (история хранится только в памяти).
+        int init( const char* file_name, u_int capacity = C_DEFAULT_CAPACITY );
+
+        /// @brief Запись события.
+        void add( SOURCE source, u_char state, u_int alarm_class,
+            u_int alarm_subclass, u_int object_n, int value );
+
+        /// @brief Синхронизация измененной памяти с файлом с ожиданием
+        /// завершения записи.
+        void sync();
+
+        /// @brief Количество сохраненных записей.
+        u_int get_count() const;
+
+        /// @brief Получение записи.
+        ///
+        /// @param idx - номер записи (0 - самая старая).
+        const record* get_record( u_int idx ) const;
+
+        /// @brief Сохранение записей в виде таблицы Lua.
+        ///
+        /// @param from_time - начало интервала, с (UTC).
+        /// @param to_time   - конец интервала, с (UTC), 0 - без ограничения.
+        ///
+        /// @return количество записанных байт.
+        int save_as_Lua_str( char* buff, int max_size, u_int_4 from_time,
+            u_int_4 to_time ) const;
+
+        ~alarm_history();
+
+    private:
+        alarm_history();
+
+        struct header
+            {
+            u_int_4 signature;
+            u_int_2 version;
+            u_int_2 record_size;
+            u_int_4 capacity;
+            u_int_4 next_n;     ///< Количество записанных событий.
+            };
+
+        /// @brief Освобождение памяти (файла).
+        void close();
+
+        /// @brief Память в куче (без файла).
+        void use_heap( u_int capacity );
+
+        header* hdr;
+        record* records;
+
+        char* data;             ///< Отображенная память.
+        u_int data_size;
+        std::vector< char > heap_data;
+
+        bool is_dirty;
+
+        static auto_smart_ptr < alarm_history > instance;
+    };
+//-----------------------------------------------------------------------------
+#define G_ALARM_HISTORY alarm_history::get_instance()
+//-----------------------------------------------------------------------------
+#endif // ALARM_HISTORY_H
@@ -0,0 +1,215 @@
+#include <string.h>
+
+#include "cmctr_limiter.h"
+//-----------------------------------------------------------------------------
+u_int request_limiter::get_key( u_char srv_id, u_char cmd )
+    {
+    return ( srv_id << 8 ) | cmd;
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::update_services()
+    {
+    is_limited_service.assign( 256, false );
+    for ( const auto &item : limits )
+        {
+        is_limited_service[ item.first >> 8 ] = true;
+        }
+    for ( const auto &item : cache_times )
+        {
+        is_limited_service[ item.first >> 8 ] = true;
+        }
+    for ( const auto &item : client_limits )
+        {
+        is_limited_service[ item.first ] = true;
+        }
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::reset_buckets( u_int key )
+    {
+    for ( auto &client : clients )
+        {
+        client.second.buckets.erase( key );
+        }
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::set_rate_limit( u_char srv_id, u_char cmd, float rate,
+    u_int burst )
+    {
+    u_int key = get_key( srv_id, cmd );
+    if ( rate <= 0 )
+        {
+        limits.erase( key );
+        }
+    else
+        {
+        limits[ key ] = { rate, burst > 0 ? burst : 1 };
+        }
+
+    reset_buckets( key );
+    update_services();
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::set_client_rate_limit( u_char srv_id, float rate,
+    u_int burst, bool ( *is_counted_cmd )( u_char cmd ) )
+    {
+    if ( rate <= 0 )
+        {
+        client_limits.erase( srv_id );
+        }
+    else
+        {
+        client_limits[ srv_id ] =
+            { { rate, burst > 0 ? burst : 1 }, is_counted_cmd };
+        }
+
+    reset_buckets( C_CLIENT_KEY | ( srv_id << 8 ) );
+    update_services();
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::set_cache_time( u_char srv_id, u_char cmd,
+    u_int cache_time )
+    {
+    u_int key = get_key( srv_id, cmd );
+    if ( 0 == cache_time )
+        {
+        cache_times.erase( key );
+        }
+    else
+        {
+        cache_times[ key ] = cache_time;
+        }
+    update_services();
+    }
+//-----------------------------------------------------------------------------
+request_limiter::bucket& request_limiter::get_bucket( client_state &client,
+    u_int key, const limit &lim, u_int &retry_after )
+    {
+    auto res = client.buckets.insert( std::make_pair( key,
+        bucket{ ( float ) lim.burst, get_millisec() } ) );
+    bucket &b = res.first->second;
+
+    if ( !res.second )
+        {
+        u_long dt = get_delta_millisec( b.last_time );
+        b.last_time = get_millisec();
+        b.tokens += dt * lim.rate / MSEC_IN_SEC;
+        if ( b.tokens > lim.burst ) b.tokens = ( float ) lim.burst;
+        }
+
+    if ( b.tokens < 1 )
+        {
+        u_int wait_time = ( u_int ) ( ( 1 - b.tokens ) * MSEC_IN_SEC /
+            lim.rate ) + 1;
+        if ( wait_time > retry_after ) retry_after = wait_time;
+        }
+
+    return b;
+    }
+//-----------------------------------------------------------------------------
+request_limiter::RESULT request_limiter::check( int skt, u_char srv_id,
+    const u_char *data, u_int len, u_int &retry_after )
+    {
+    retry_after = 0;
+    if ( !is_limited_service[ srv_id ] || 0 == len ) return CHECK_OK;
+
+    client_state &client = clients[ skt ];
+    u_int key = get_key( srv_id, data[ 0 ] );
+
+    //Повторный запрос - передаем прошлый ответ, если он еще актуален.
+    auto cache_time = cache_times.find( key );
+    bool is_cacheable = cache_time != cache_times.end();
+    if ( is_cacheable && client.is_response_valid &&
+        client.last_request_key == key &&
+        client.last_request.size() == len &&
+        0 == memcmp( client.last_request.data(), data, len ) &&
+        get_delta_millisec( client.response_time ) < cache_time->second )
+        {
+        return CHECK_CACHED;
+        }
+
+    //Токен расходуется, только если он есть во всех ведрах запроса.
+    bucket *cmd_bucket = nullptr;
+    auto lim = limits.find( key );
+    if ( lim != limits.end() )
+        {
+        cmd_bucket = &get_bucket( client, key, lim->second, retry_after );
+        }
+
+    bucket *client_bucket = nullptr;
+    auto client_lim = client_limits.find( srv_id );
+    if ( client_lim != client_limits.end() &&
+        ( !client_lim->second.is_counted_cmd ||
+        client_lim->second.is_counted_cmd( data[ 0 ] ) ) )
+        {
+        client_bucket = &get_bucket( client, C_CLIENT_KEY | ( srv_id << 8 ),
+            client_lim->second.lim, retry_after );
+        }
+
+    if ( retry_after > 0 )
+        {
+        return CHECK_BUSY;
+        }
+    if ( cmd_bucket ) cmd_bucket->tokens -= 1;
+    if ( client_bucket ) client_bucket->tokens -= 1;
+
+    client.last_request_key = key;
+    client.is_cacheable = is_cacheable;
+    client.is_response_valid = false;
+    if ( is_cacheable )
+        {
+        client.last_request.assign( data, data + len );
+        }
+    else
+        {
+        client.last_request.clear();
+        }
+
+    return CHECK_OK;
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::save_response( int skt, const u_char *data, u_int len )
+    {
+    auto it = clients.find( skt );
+    if ( it == clients.end() || !it->second.is_cacheable ) return;
+
+    client_state &client = it->second;
+    client.last_response.assign( data, data + len );
+    client.is_response_valid = true;
+    client.response_time = get_millisec();
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::append_response( int skt, const u_char *data,
+    u_int len )
+    {
+    auto it = clients.find( skt );
+    if ( it == clients.end() || !it->second.is_response_valid ) return;
+
+    it->second.last_response.insert( it->second.last_response.end(),
+        data, data + len );
+    }
+//-----------------------------------------------------------------------------
+const u_char* request_limiter::get_cached_response( int skt,
+    u_int &size ) const
+    {
+    size = 0;
+    auto it = clients.find( skt );
+    if ( it == clients.end() || !it->second.is_response_valid ) return nullptr;
+
+    size = static_cast<u_int>( it->second.last_response.size() );
+    return it->second.last_response.data();
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::remove_client( int skt )
+    {
+    clients.erase( skt );
+    }
+//-----------------------------------------------------------------------------
+void request_limiter::clear()
+    {
+    limits.clear();
+    client_limits.clear();
+    cache_times.clear();
+    clients.clear();
+    update_services();
+    }
+//-----------------------------------------------------------------------------
@@ -0,0 +1,167 @@
+/// @file cmctr_limiter.h
+/// @brief Ограничение частоты запросов клиентов коммуникатора.
+///
+/// Ограничения задаются для отдельных команд сервисов, запросы которых
+/// начинаются с байта команды (сервис устройств), а также для всех
+/// (отобранных фильтром) команд сервиса одного клиента. Для каждого клиента
+/// (сокета) и каждого ограничения ведется "ведро токенов": запрос расходует
+/// токен, токены пополняются с заданной частотой до заданного максимума. Если
+/// токенов нет, запрос не выполняется, клиенту сразу же возвращается ошибка
+/// "занято" с временем, через которое можно повторить запрос. Это защищает цикл управления от некорректно настроенных
+/// клиентов (например, опрашивающих описание устройств без паузы).
+///
+/// Кроме того, для выбранных команд чтения ответ запоминается: если клиент
+/// повторяет точно такой же запрос (подряд и в течение заданного времени), то
+/// ему передается сохраненный ответ без повторного выполнения команды.
+
+#ifndef CMCTR_LIMITER_H
+#define CMCTR_LIMITER_H
+
+#include <map>
+#include <vector>
+
+#include "dtime.h"
+//-----------------------------------------------------------------------------
+/// @brief Ограничитель частоты запросов.
+class request_limiter
+    {
+    public:
+        enum RESULT
+            {
+            CHECK_OK = 0,       ///< Запрос необходимо выполнить.
+            CHECK_CACHED,       ///< Повторный запрос - можно передать прошлый ответ.
+            CHECK_BUSY,         ///< Превышена частота запросов.
+            };
+
+        /// @brief Задание ограничения частоты запросов.
+        ///
+        /// @param srv_id - номер сервиса.
+        /// @param cmd    - команда (первый байт данных запроса).
+        /// @param rate   - допустимая частота запросов, 1/с (0 - без
+        /// ограничения).
+        /// @param burst  - максимальное количество запросов подряд.
+        void set_rate_limit( u_char srv_id, u_char cmd, float rate,
+            u_int burst );
+
+        /// @brief Задание общего ограничения частоты запросов клиента к
+        /// сервису.
+        ///
+        /// Учитываются запросы с командами, для которых is_counted_cmd
+        /// возвращает true (nullptr - все запросы). Запрос выполняется, если
+        /// есть токены и в общем ведре клиента, и в ведре команды.
+        ///
+        /// @param srv_id         - номер сервиса.
+        /// @param rate           - допустимая частота запросов, 1/с (0 - без
+        /// ограничения).
+        /// @param burst          - максимальное количество запросов подряд.
+        /// @param is_counted_cmd - фильтр учитываемых команд.
+        void set_client_rate_limit( u_char srv_id, float rate, u_int burst,
+            bool ( *is_counted_cmd )( u_char cmd ) = nullptr );
+
+        /// @brief Задание времени хранения ответа на команду чтения.
+        ///
+        /// @param srv_id     - номер сервиса.
+        /// @param cmd        - команда (первый байт данных запроса).
+        /// @param cache_time - время хранения ответа, мс (0 - не хранить).
+        void set_cache_time( u_char srv_id, u_char cmd, u_int cache_time );
+
+        /// @brief Проверка запроса клиента.
+        ///
+        /// Проверка должна выполняться до вызова сервиса, так как ответ
+        /// записывается поверх запроса. Запросы к сервисам без ограничений
+        /// выполняются всегда.
+        ///
+        /// @param skt                 - сокет клиента.
+        /// @param srv_id              - номер сервиса.
+        /// @param data                - данные запроса.
+        /// @param len                 - размер данных запроса.
+        /// @param retry_after [ out ] - для @ref CHECK_BUSY: через сколько мс
+        /// можно повторить запрос.
+        ///
+        /// @return результат проверки (@ref RESULT).
+        RESULT check( int skt, u_char srv_id, const u_char *data, u_int len,
+            u_int &retry_after );
+
+        /// @brief Сохранение ответа на последний проверенный запрос клиента.
+        ///
+        /// Ответ сохраняется только для команд с заданным временем хранения.
+        void save_response( int skt, const u_char *data, u_int len );
+
+        /// @brief Добавление данных к сохраненному ответу (для ответа из
+        /// нескольких сегментов).
+        void append_response( int skt, const u_char *data, u_int len );
+
+        /// @brief Получение сохраненного ответа клиенту.
+        ///
+        /// @param size [ out ] - размер ответа.
+        ///
+        /// @return nullptr - ответа нет.
+        const u_char* get_cached_response( int skt, u_int &size ) const;
+
+        /// @brief Удаление состояния клиента (при закрытии сокета).
+        void remove_client( int skt );
+
+        /// @brief Удаление всех ограничений и состояний клиентов.
+        void clear();
+
+    private:
+        struct limit
+            {
+            float rate;     ///< Частота пополнения, 1/с.
+            u_int burst;    ///< Емкость ведра.
+            };
+
+        struct client_limit
+            {
+            limit lim;
+            bool ( *is_counted_cmd )( u_char cmd );
+            };
+
+        /// Признак ключа общего ведра клиента (в отличие от ведра команды).
+        static const u_int C_CLIENT_KEY = 0x10000;
+
+        struct bucket
+            {
+            float  tokens;
+            u_long last_time;   ///< Время последнего пополнения, мс.
+            };
+
+        struct client_state
+            {
+            std::map< u_int, bucket > buckets;
+
+            std::vector< u_char > last_request;
+            u_int  last_request_key = 0;
+            bool   is_cacheable = false;    ///< Ответ на запрос сохраняется.
+
+            std::vector< u_char > last_response;
+            bool   is_response_valid = false;
+            u_long response_time = 0;       ///< Время получения ответа, мс.
+            };
+
+        static u_int get_key( u_char srv_id, u_char cmd );
+
+        /// @brief Обновление признаков сервисов с ограничениями.
+        void update_services();
+
+        /// @brief Получение пополненного ведра токенов клиента.
+        ///
+        /// Если токенов нет, то в retry_after записывается (с учетом уже
+        /// записанного значения) время ожидания, мс.
+        bucket& get_bucket( client_state &client, u_int key,
+            const limit &lim, u_int &retry_after );
+
+        /// @brief Удаление ведер с заданным ключом у всех клиентов.
+        void reset_buckets( u_int key );
+
+        std::map< u_int, limit > limits;
+        std::map< u_char, client_limit > client_limits;
+        std::map< u_int, u_int > cache_times;
+        std::map< int, client_state > clients;
+
+        /// Признаки сервисов с ограничениями (по номеру сервиса).
+        std::vector< bool > is_limited_service =
+            std::vector< bool >( 256, false );
+    };
+//-----------------------------------------------------------------------------
+#endif // CMCTR_LIMITER_H
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "cmctr_metrics.h"
+
+#include "log.h"
+
+auto_smart_ptr < cmctr_metrics > cmctr_metrics::instance;
+
+const u_long request_stat::HIST_BOUNDS[ C_HIST_SIZE - 1 ] =
+    { 100, 500, 1000, 5000, 10000, 50000, 100000 };
+//-----------------------------------------------------------------------------
+request_stat::request_stat()
+    {
+    clear();
+    }
+//-----------------------------------------------------------------------------
+void request_stat::add( u_long handler_time, u_long queue_delay,
+    u_long in_size, u_long raw_size, u_long out_size )
+    {
+    requests_cnt++;
+
+    handler_time_all += handler_time;
+    if ( handler_time > handler_time_max ) handler_time_max = handler_time;
+
+    int idx = 0;
+    while ( idx < C_HIST_SIZE - 1 && handler_time >= HIST_BOUNDS[ idx ] )
+        {
+        idx++;
+        }
+    handler_hist[ idx ]++;
+
+    queue_delay_all += queue_delay;
+    if ( queue_delay > queue_delay_max ) queue_delay_max = queue_delay;
+
+    in_bytes += in_size;
+    raw_bytes += raw_size;
+    out_bytes += out_size;
+    }
+//-----------------------------------------------------------------------------
+void request_stat::clear()
+    {
+    requests_cnt = 0;
+    handler_time_all = 0;
+    handler_time_max = 0;
+    memset( handler_hist, 0, sizeof( handler_hist ) );
+    queue_delay_all = 0;
+    queue_delay_max = 0;
+    in_bytes = 0;
+    raw_bytes = 0;
+    out_bytes = 0;
+    cached_cnt = 0;
+    throttled_cnt = 0;
+    }
+//-----------------------------------------------------------------------------
+int request_stat::save_as_Lua_str( char *buff, int max_size ) const
+    {
+    u_long cnt = requests_cnt ? requests_cnt : 1;
+
+    int res = snprintf( buff, max_size,
+        "{ cnt = %lu, time_avg = %lu, time_max = %lu, "
+        "queue_avg = %lu, queue_max = %lu, "
+        "in = %llu, raw = %llu, out = %llu, cached = %lu, throttled = %lu, "
+        "hist = { ",
+        requests_cnt, handler_time_all / cnt, handler_time_max,
+        queue_delay_all / cnt, queue_delay_max,
+        in_bytes, raw_bytes, out_bytes, cached_cnt, throttled_cnt );
+
+    for ( int i = 0; i < C_HIST_SIZE && res < max_size; i++ )
+        {
+        res += snprintf( buff + res, max_size - res, "%lu, ",
+            handler_hist[ i ] );
+        }
+    if ( res < max_size )
+        {
+        res += snprintf( buff + res, max_size - res, "} }" );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+cmctr_metrics* cmctr_metrics::get_instance()
+    {
+    if ( instance.is_null() )
+        {
+        instance = new cmctr_metrics();
+        }
+
+    return instance;
+    }
+//-----------------------------------------------------------------------------
+cmctr_metrics::cmctr_metrics() : current_srv_id( 0 ), current_queue_delay( 0 ),
+    current_start_time( 0 ), current_raw_delta( 0 )
+    {
+    print_last_h = get_time().tm_hour;
+    }
+//-----------------------------------------------------------------------------
+void cmctr_metrics::start_request( u_int srv_id, u_long queue_delay )
+    {
+    current_srv_id = srv_id;
+    current_queue_delay = queue_delay;
+    current_start_time = get_microsec();
+    current_raw_delta = 0;
+    }
+//-----------------------------------------------------------------------------
+void cmctr_metrics::end_request( u_long in_size, u_long out_size )
+    {
+    long raw_size = static_cast< long >( out_size ) + current_raw_delta;
+    services[ current_srv_id ].add( get_delta_microsec( current_start_time ),
+        current_queue_delay, in_size, raw_size > 0 ? raw_size : 0, out_size );
+    current_queue_delay = 0;
+    current_raw_delta = 0;
+
+#ifdef TEST_SPEED
+    //Раз в час выводим статистику в лог (отладочные сообщения, как и
+    //"Network performance" обмена с узлами).
+    int hour = get_time().tm_hour;
+    if ( hour != print_last_h )
+        {
+        print_last_h = hour;
+        print_to_log();
+        }
+#endif // TEST_SPEED
+    }
+//-----------------------------------------------------------------------------
+void cmctr_metrics::add_command( u_int cmd, u_long handler_time,
+    u_long raw_size, u_long out_size )
+    {
+    commands[ cmd ].add( handler_time, current_queue_delay, 0, raw_size,
+        out_size );
+    current_raw_delta += static_cast< long >( raw_size ) -
+        static_cast< long >( out_size );
+    }
+//-----------------------------------------------------------------------------
+void cmctr_metrics::add_limited_request( u_int srv_id, bool is_cached )
+    {
+    request_stat &s = services[ srv_id ];
+    if ( is_cached )
+        {
+        s.cached_cnt++;
+        }
+    else
+        {
+        s.throttled_cnt++;
+        }
+    }
+//-----------------------------------------------------------------------------
+const request_stat* cmctr_metrics::get_service_stat( u_int srv_id ) const
+    {
+    auto it = services.find( srv_id );
+    return it != services.end() ? &it->second : nullptr;
+    }
+//-----------------------------------------------------------------------------
+const request_stat* cmctr_metrics::get_command_stat( u_int cmd ) const
+    {
+    auto it = commands.find( cmd );
+    return it != commands.end() ? &it->second : nullptr;
+    }
+//-----------------------------------------------------------------------------
+int cmctr_metrics::save_as_Lua_str( char *buff, int max_size ) const
+    {
+    int res = snprintf( buff, max_size, "metrics =\n\t{\n\thist_bounds = { " );
+    for ( int i = 0; i < request_stat::C_HIST_SIZE - 1 && res < max_size; i++ )
+        {
+        res += snprintf( buff + res, max_size - res, "%lu, ",
+            request_stat::HIST_BOUNDS[ i ] );
+        }
+
+    const std::map< u_int, request_stat >* groups[] = { &services, &commands };
+    const char* names[] = { "services", "commands" };
+    for ( int g = 0; g < 2; g++ )
+        {
+        if ( res < max_size )
+            {
+            res += snprintf( buff + res, max_size - res, "},\n\t%s =\n\t\t{\n",
+                names[ g ] );
+            }
+        for ( const auto &item : *groups[ g ] )
+            {
+            if ( res >= max_size ) break;
+
+            res += snprintf( buff + res, max_size - res, "\t\t[ %u ] = ",
+                item.first );
+            if ( res < max_size )
+                {
+                res += item.second.save_as_Lua_str( buff + res,
+                    max_size - res );
+                }
+            if ( res < max_size )
+                {
+                res += snprintf( buff + res, max_size - res, ",\n" );
+                }
+            }
+        if ( res < max_size )
+            {
+            res += snprintf( buff + res, max_size - res, "\t\t" );
+            }
+        }
+
+    if ( res < max_size )
+        {
+        res += snprintf( buff + res, max_size - res, "}\n\t}\n" );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
+void cmctr_metrics::print_to_log() const
+    {
+    for ( const auto &item : services )
+        {
+        const request_stat &s = item.second;
+        u_long cnt = s.requests_cnt ? s.requests_cnt : 1;
+        G_LOG->debug( "Network performance : service %u : requests = %lu, "
+            "handler avg = %lu, max = %lu, queue avg = %lu, max = %lu (us), "
+            "in = %llu, raw = %llu, out = %llu (b), cached = %lu, "
+            "throttled = %lu.",
+            item.first, s.requests_cnt,
+            s.handler_time_all / cnt, s.handler_time_max,
+            s.queue_delay_all / cnt, s.queue_delay_max,
+            s.in_bytes, s.raw_bytes, s.out_bytes, s.cached_cnt,
+            s.throttled_cnt );
+        }
+
+    for ( const auto &item : commands )
+        {
+        const request_stat &s = item.second;
+        u_long cnt = s.requests_cnt ? s.requests_cnt : 1;
+        G_LOG->debug( "Network performance : command %u : requests = %lu, "
+            "handler avg = %lu, max = %lu (us), raw = %llu, "
+            "compressed = %llu (b).",
+            item.first, s.requests_cnt,
+            s.handler_time_all / cnt, s.handler_time_max,
+            s.raw_bytes, s.out_bytes );
+        }
+    }
+//-----------------------------------------------------------------------------
+void cmctr_metrics::clear()
+    {
+    services.clear();
+    commands.clear();
+    }
+//-----------------------------------------------------------------------------
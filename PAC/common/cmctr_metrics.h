@@ -0,0 +1,149 @@
+/// @file cmctr_metrics.h
+/// @brief Статистика обработки запросов коммуникатором.
+///
+/// Для каждого сервиса (@ref tcp_communicator::services) и каждой команды
+/// сервиса устройств (@ref device_communicator::CMD) накапливаются:
+/// количество запросов, гистограмма времени обработки, размер данных до и
+/// после сжатия и время ожидания запроса в очереди (от обнаружения данных на
+/// сокете до начала обработки). По этим данным можно определить, что является
+/// узким местом - формирование ответа, сжатие или сеть.
+///
+/// Статистика доступна через команду
+/// @ref device_communicator::CMD_GET_CMCTR_METRICS и раз в час выводится в
+/// лог.
+
+#ifndef CMCTR_METRICS_H
+#define CMCTR_METRICS_H
+
+#include <map>
+
+#include "smart_ptr.h"
+#include "dtime.h"
+//-----------------------------------------------------------------------------
+/// @brief Статистика обработки запросов одного вида.
+struct request_stat
+    {
+    enum CONSTANTS
+        {
+        C_HIST_SIZE = 8,    ///< Количество интервалов гистограммы.
+        };
+
+    /// Верхние границы интервалов гистограммы, мкс (последний - без границы).
+    static const u_long HIST_BOUNDS[ C_HIST_SIZE - 1 ];
+
+    u_long requests_cnt;                ///< Количество запросов.
+
+    u_long handler_time_all;            ///< Суммарное время обработки, мкс.
+    u_long handler_time_max;            ///< Максимальное время обработки, мкс.
+    u_long handler_hist[ C_HIST_SIZE ]; ///< Гистограмма времени обработки.
+
+    u_long queue_delay_all;             ///< Суммарное время ожидания, мкс.
+    u_long queue_delay_max;             ///< Максимальное время ожидания, мкс.
+
+    unsigned long long in_bytes;        ///< Размер полученных данных.
+    unsigned long long raw_bytes;       ///< Размер ответа до сжатия.
+    unsigned long long out_bytes;       ///< Размер переданного ответа.
+
+    u_long cached_cnt;      ///< Количество ответов из сохраненных.
+    u_long throttled_cnt;   ///< Количество отклоненных запросов ("занято").
+
+    request_stat();
+
+    /// @brief Учет очередного запроса.
+    ///
+    /// @param handler_time - время обработки, мкс.
+    /// @param queue_delay  - время ожидания в очереди, мкс.
+    /// @param in_size      - размер запроса.
+    /// @param raw_size     - размер ответа до сжатия.
+    /// @param out_size     - размер переданного ответа.
+    void add( u_long handler_time, u_long queue_delay, u_long in_size,
+        u_long raw_size, u_long out_size );
+
+    void clear();
+
+    /// @brief Сохранение в виде таблицы Lua.
+    ///
+    /// @return количество записанных байт.
+    int save_as_Lua_str( char *buff, int max_size ) const;
+    };
+//-----------------------------------------------------------------------------
+/// @brief Статистика коммуникатора по сервисам и командам.
+class cmctr_metrics
+    {
+    public:
+        /// @brief Получение единственного экземпляра класса.
+        static cmctr_metrics* get_instance();
+
+        /// @brief Начало обработки запроса сервиса.
+        ///
+        /// @param srv_id      - номер сервиса.
+        /// @param queue_delay - время ожидания запроса в очереди, мкс.
+        void start_request( u_int srv_id, u_long queue_delay );
+
+        /// @brief Завершение обработки запроса сервиса.
+        ///
+        /// Размер ответа до сжатия определяется по командам, выполненным
+        /// при обработке запроса (@ref add_command).
+        ///
+        /// @param in_size  - размер запроса.
+        /// @param out_size - размер переданного ответа.
+        void end_request( u_long in_size, u_long out_size );
+
+        /// @brief Учет выполненной команды сервиса устройств.
+        ///
+        /// Время ожидания берется из текущего запроса сервиса.
+        ///
+        /// @param cmd          - команда.
+        /// @param handler_time - время формирования ответа (без сжатия), мкс.
+        /// @param raw_size     - размер ответа до сжатия.
+        /// @param out_size     - размер ответа после сжатия.
+        void add_command( u_int cmd, u_long handler_time, u_long raw_size,
+            u_long out_size );
+
+        /// @brief Учет запроса, не переданного сервису из-за ограничения
+        /// частоты запросов (@ref request_limiter).
+        ///
+        /// @param srv_id    - номер сервиса.
+        /// @param is_cached - передан сохраненный ответ (иначе - отклонен).
+        void add_limited_request( u_int srv_id, bool is_cached );
+
+        /// @brief Получение статистики сервиса.
+        ///
+        /// @return nullptr - по данному сервису запросов не было.
+        const request_stat* get_service_stat( u_int srv_id ) const;
+
+        /// @brief Получение статистики команды.
+        ///
+        /// @return nullptr - данная команда не выполнялась.
+        const request_stat* get_command_stat( u_int cmd ) const;
+
+        /// @brief Сохранение статистики в виде скрипта Lua.
+        ///
+        /// @return количество записанных байт.
+        int save_as_Lua_str( char *buff, int max_size ) const;
+
+        /// @brief Вывод статистики в лог (уровень P_DEBUG).
+        void print_to_log() const;
+
+        /// @brief Сброс статистики.
+        void clear();
+
+    private:
+        cmctr_metrics();
+
+        std::map< u_int, request_stat > services;
+        std::map< u_int, request_stat > commands;
+
+        u_int  current_srv_id;
+        u_long current_queue_delay;
+        u_long current_start_time;
+        long   current_raw_delta;   ///< Разница размеров ответа до/после сжатия.
+
+        int print_last_h;      ///< Час последнего вывода в лог.
+
+        static auto_smart_ptr < cmctr_metrics > instance;
+    };
+//-----------------------------------------------------------------------------
+#define G_CMMCTR_METRICS cmctr_metrics::get_instance()
+//-----------------------------------------------------------------------------
+#endif // CMCTR_METRICS_H
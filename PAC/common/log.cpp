@@ -1,5 +1,8 @@
 #include "log.h"
 #include <stdarg.h>
+#include <stdio.h>
+
+#include "dtime.h"
 
 #if defined  WIN_OS
 #include "w_log.h"
@@ -35,6 +38,153 @@ log_mngr::~log_mngr()
     lg = nullptr;
     }
 //-----------------------------------------------------------------------------
+void log_mngr::set_deferred( unsigned long budget )
+    {
+    get_log();
+
+    auto d_log = dynamic_cast< deferred_log* >( instance->lg );
+    if ( nullptr == d_log )
+        {
+        d_log = new deferred_log( instance->lg );
+        instance->lg = d_log;
+        }
+    d_log->set_budget( budget );
+    }
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+deferred_log::deferred_log( i_log* sink ) : sink( sink ),
+    ring( C_RING_SIZE ), head( 0 ), tail( 0 ), queued_cnt( 0 ),
+    budget( C_DEFAULT_BUDGET ), dropped_cnt( 0 ), reported_dropped_cnt( 0 )
+    {
+    }
+//-----------------------------------------------------------------------------
+deferred_log::~deferred_log()
+    {
+    flush();
+    delete sink;
+    sink = nullptr;
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::write_log( PRIORITIES priority )
+    {
+    std::time_t t = std::time( nullptr );
+
+    if ( priority <= P_CRIT )
+        {
+        flush();
+
+        strncpy( sink->msg, msg, C_BUFF_SIZE - 1 );
+        sink->msg[ C_BUFF_SIZE - 1 ] = 0;
+        sink->msg_time = t;
+        sink->write_log( priority );
+        sink->msg_time = 0;
+        return;
+        }
+
+    //Сообщение сохраняется полностью (как при записи в журнал сразу).
+    size_t len = strnlen( msg, C_BUFF_SIZE - 1 );
+    unsigned short size = static_cast< unsigned short >( len );
+    unsigned char p = static_cast< unsigned char >( priority );
+
+    //Сообщение записывается только целиком.
+    if ( head - tail + sizeof( p ) + sizeof( size ) + sizeof( t ) + size >
+        ring.size() )
+        {
+        dropped_cnt++;
+        return;
+        }
+
+    ring_write( &p, sizeof( p ) );
+    ring_write( &size, sizeof( size ) );
+    ring_write( &t, sizeof( t ) );
+    ring_write( msg, size );
+    queued_cnt++;
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::ring_write( const void* src, unsigned int size )
+    {
+    unsigned int pos = head % ring.size();
+    unsigned int first = size < ring.size() - pos ? size : ring.size() - pos;
+    memcpy( ring.data() + pos, src, first );
+    memcpy( ring.data(), static_cast< const char* >( src ) + first,
+        size - first );
+    head += size;
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::ring_read( void* dst, unsigned int size )
+    {
+    unsigned int pos = tail % ring.size();
+    unsigned int first = size < ring.size() - pos ? size : ring.size() - pos;
+    memcpy( dst, ring.data() + pos, first );
+    memcpy( static_cast< char* >( dst ) + first, ring.data(), size - first );
+    tail += size;
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::write_next()
+    {
+    unsigned char p = 0;
+    unsigned short size = 0;
+    ring_read( &p, sizeof( p ) );
+    ring_read( &size, sizeof( size ) );
+    ring_read( &sink->msg_time, sizeof( sink->msg_time ) );
+    ring_read( sink->msg, size );
+    sink->msg[ size ] = 0;
+    queued_cnt--;
+
+    sink->write_log( static_cast< PRIORITIES >( p ) );
+    sink->msg_time = 0;
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::write_dropped_count()
+    {
+    //Отброшенные сообщения следуют за уже записанными в буфер, поэтому
+    //их количество выводится после записи буфера.
+    if ( 0 == queued_cnt && dropped_cnt != reported_dropped_cnt )
+        {
+        snprintf( sink->msg, C_BUFF_SIZE, "Log buffer overflow - %lu "
+            "messages dropped.", dropped_cnt - reported_dropped_cnt );
+        sink->write_log( P_WARNING );
+        reported_dropped_cnt = dropped_cnt;
+        }
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::evaluate()
+    {
+    unsigned long start_time = get_microsec();
+    while ( queued_cnt > 0 )
+        {
+        write_next();
+        if ( get_delta_microsec( start_time ) >= budget ) break;
+        }
+
+    write_dropped_count();
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::flush()
+    {
+    while ( queued_cnt > 0 )
+        {
+        write_next();
+        }
+
+    write_dropped_count();
+    }
+//-----------------------------------------------------------------------------
+void deferred_log::set_budget( unsigned long new_budget )
+    {
+    budget = new_budget;
+    }
+//-----------------------------------------------------------------------------
+unsigned long deferred_log::get_dropped_count() const
+    {
+    return dropped_cnt;
+    }
+//-----------------------------------------------------------------------------
+unsigned int deferred_log::get_queued_count() const
+    {
+    return queued_cnt;
+    }
+//-----------------------------------------------------------------------------
 void i_log::write_log( PRIORITIES priority, const char* debug_message )
     {
     strncpy( msg, debug_message, C_BUFF_SIZE - 1 );
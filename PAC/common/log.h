@@ -12,6 +12,8 @@
 #define LOG_H
 
 #include <string.h>
+#include <ctime>
+#include <vector>
 
 #include "smart_ptr.h"
 
@@ -37,6 +39,9 @@ class i_log
 
     char msg[ C_BUFF_SIZE ];
 
+    /// Время возникновения сообщения из @ref msg (0 - текущее время).
+    std::time_t msg_time = 0;
+
     enum PRIORITIES
         {
         P_EMERG, 	// System is unusable
@@ -65,6 +70,16 @@ class i_log
     void alert(const char* info_message, ...);
     void emergency(const char* info_message, ...);
 
+    /// @brief Запись отложенных сообщений (вызывается в основном цикле).
+    virtual void evaluate()
+        {
+        }
+
+    /// @brief Запись всех отложенных сообщений.
+    virtual void flush()
+        {
+        }
+
     protected:
 
     i_log()
@@ -73,11 +88,88 @@ class i_log
         }
     };
 //-----------------------------------------------------------------------------
+/// @brief Отложенная запись в журнал.
+///
+/// Сообщения копируются в кольцевой буфер вместе со временем их
+/// возникновения, а записываются в журнал (вывод на консоль, syslog) позже
+/// в основном цикле (@ref evaluate) в пределах заданного времени. При
+/// заполнении буфера сообщения отбрасываются с подсчетом их количества.
+/// Таким образом большое количество сообщений не увеличивает время цикла.
+///
+/// Сообщения с приоритетом @ref P_CRIT и выше записываются сразу (вместе с
+/// предшествующими им отложенными сообщениями) - они не должны теряться при
+/// аварийном завершении.
+class deferred_log: public i_log
+    {
+    public:
+        enum CONSTANTS
+            {
+            C_RING_SIZE = 64 * 1024,    ///< Размер буфера, байт.
+            C_DEFAULT_BUDGET = 1000,    ///< Время записи по умолчанию, мкс.
+            };
+
+        /// @param sink - журнал для записи сообщений (удаляется вместе с
+        /// объектом).
+        deferred_log( i_log* sink );
+
+        virtual ~deferred_log();
+
+        using i_log::write_log;
+
+        /// @brief Запись сообщения из @ref msg в буфер (критических - в
+        /// журнал).
+        void write_log( PRIORITIES priority ) override;
+
+        /// @brief Запись отложенных сообщений в пределах времени шага.
+        void evaluate() override;
+
+        /// @brief Запись всех отложенных сообщений.
+        void flush() override;
+
+        /// @brief Задание максимального времени записи в цикле, мкс.
+        void set_budget( unsigned long budget );
+
+        /// @brief Количество отброшенных сообщений.
+        unsigned long get_dropped_count() const;
+
+        /// @brief Количество отложенных сообщений.
+        unsigned int get_queued_count() const;
+
+    private:
+        /// @brief Запись очередного сообщения из буфера в журнал.
+        void write_next();
+
+        /// @brief Запись в журнал количества отброшенных сообщений.
+        void write_dropped_count();
+
+        void ring_write( const void* src, unsigned int size );
+
+        void ring_read( void* dst, unsigned int size );
+
+        i_log* sink;
+
+        std::vector< char > ring;
+        unsigned int head;  ///< Позиция записи (без учета размера буфера).
+        unsigned int tail;  ///< Позиция чтения (без учета размера буфера).
+        unsigned int queued_cnt;
+
+        unsigned long budget;
+        unsigned long dropped_cnt;
+        unsigned long reported_dropped_cnt;
+    };
+//-----------------------------------------------------------------------------
 class log_mngr
     {
     public:
         static i_log* get_log();
 
+        /// @brief Включение отложенной записи в журнал
+        /// (@ref deferred_log).
+        ///
+        /// @param budget - максимальное время записи в цикле, мкс.
+        static void set_deferred( unsigned long budget =
+            deferred_log::C_DEFAULT_BUDGET );
+
         ~log_mngr();
 
     protected:
@@ -112,6 +112,10 @@ int operation::switch_off()
     {
     if ( current_state != IDLE )
         {        
+        owner->set_evaluated_operations_changed();
+        is_first_goto_next_state = true;
+        was_fail = false;
+
         states[ current_state ]->finalize();
         current_state = IDLE;
         states[ IDLE ]->init();
@@ -131,6 +135,7 @@ int operation::start( int new_run_step )
     switch ( current_state )
         {
         case IDLE:
+            owner->set_evaluated_operations_changed();
             states[ IDLE ]->finalize();
             if ( states[ STARTING ]->is_empty() ) current_state = RUN;
             else current_state = STARTING;
@@ -285,6 +290,13 @@ void operation::evaluate()
         }
     }
 //-----------------------------------------------------------------------------
+bool operation::is_evaluation_needed() const
+    {
+    if ( current_state != IDLE ) return true;
+
+    return !states[ IDLE ]->is_empty() || states[ IDLE ]->has_active_steps();
+    }
+//-----------------------------------------------------------------------------
 int operation::process_auto_switch_on()
     {
     auto unit = owner->owner;
@@ -381,6 +393,9 @@ void operation::finalize()
             }
 
         current_state = IDLE;
+        owner->set_evaluated_operations_changed();
+        is_first_goto_next_state = true;
+        was_fail = false;
         }
     }
 //-----------------------------------------------------------------------------
@@ -446,6 +461,8 @@ u_long operation::get_active_step_set_time() const
 //-----------------------------------------------------------------------------
 void operation::to_step( unsigned int new_step, unsigned long cooperative_time /*= 0 */)
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         states[ current_state ]->to_step( new_step, cooperative_time );
@@ -454,6 +471,8 @@ void operation::to_step( unsigned int new_step, unsigned long cooperative_time /
 //-----------------------------------------------------------------------------
 void operation::to_next_step()
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         states[ current_state ]->to_next_step();
@@ -462,6 +481,8 @@ void operation::to_next_step()
 //-----------------------------------------------------------------------------
 void operation::turn_off_active_step()
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         states[ current_state ]->turn_off_active_step();
@@ -471,6 +492,8 @@ void operation::turn_off_active_step()
 step* operation::add_step( const char* step_name, int next_step_n,
                           unsigned int step_duration_par_n, state_idx s_idx /*= RUN */)
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         return states[ s_idx ]->add_step( step_name, next_step_n,
@@ -482,6 +505,8 @@ step* operation::add_step( const char* step_name, int next_step_n,
 //-----------------------------------------------------------------------------
 int operation::on_extra_step( int step_idx )
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         states[ current_state ]->on_extra_step( step_idx );
@@ -492,6 +517,8 @@ int operation::on_extra_step( int step_idx )
 //-----------------------------------------------------------------------------
 int operation::off_extra_step( int step_idx )
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         states[ current_state ]->off_extra_step( step_idx );
@@ -517,6 +544,8 @@ bool operation::is_active_extra_step( int step_idx ) const
 //-----------------------------------------------------------------------------
 int operation::switch_active_extra_step( int off_step, int on_step )
     {
+    owner->set_evaluated_operations_changed();
+
     if ( current_state >= 0 && current_state < STATES_MAX )
         {
         states[ current_state ]->switch_active_extra_step( off_step, on_step );
@@ -575,71 +604,54 @@ void action::finalize()
         return;
         }
 
-    for ( u_int i = 0; i < devices.size(); i++ )
+    for ( auto dev : get_all_devices() )
         {
-        for ( u_int j = 0; j < devices[ i ].size(); j++ )
-            {
-            for ( u_int k = 0; k < devices[ i ][ j ].size(); k++ )
-                {
 #ifdef DEBUG_NO_IO_MODULES
-                auto dev = devices[ i ][ j ][ k ];
-                auto type = dev->get_type();
-                if ( type != device::DT_DI && type != device::DT_AI )
-                    {
-                    dev->off();
-                    }
+        auto type = dev->get_type();
+        if ( type != device::DT_DI && type != device::DT_AI )
+            {
+            dev->off();
+            }
 #else
-                devices[ i ][ j ][ k ]->off();
+        dev->off();
 #endif // DEBUG_NO_IO_MODULES
-                }
-            }
         }
     }
 //-----------------------------------------------------------------------------
 bool action::is_empty() const
     {
-    for ( u_int i = 0; i < devices.size(); i++ )
-        {
-        if ( !devices[ i ].empty() )
-            {
-            for ( u_int j = 0; j < devices[ i ].size(); j++ )
-                {
-                if ( !devices[ i ][ j ].empty() ) return false;
-                }
-            }
-        }
-
-    return true;
+    return get_all_devices().empty();
     }
 //-----------------------------------------------------------------------------
 int action::check_devices( char* err_description, int size ) const
     {
+    //Описание формируется, только если есть устройства в ошибке.
+    if ( !is_any_device_error() )
+        {
+        err_description[ 0 ] = '\0';
+        return 0;
+        }
+
     char *out = err_description;
     auto written_size = 0;
     auto free_size = size - 1;
 
-    for ( auto &group : devices )
+    for ( auto dev : get_all_devices() )
         {
-        for ( auto &subgroup : group )
+        if ( dev->get_state() < 0 )
             {
-            for ( auto dev : subgroup )
+            int par = int( ( *dev->get_err_par() )[ 1 ] );
+
+            if ( !( par & base_error::P_IS_SUPPRESS ) )
                 {
-                if ( dev->get_state() < 0 )
+                auto res = fmt::format_to_n(
+                    out, free_size, "'{}', ", dev->get_name() );
+                free_size -= res.size;
+                written_size += res.size;
+                out = res.out;
+                if ( free_size < 0 )
                     {
-                    int par = int( ( *dev->get_err_par() )[ 1 ] );
-
-                    if ( !( par & base_error::P_IS_SUPPRESS ) )
-                        {
-                        auto res = fmt::format_to_n(
-                            out, free_size, "'{}', ", dev->get_name() );
-                        free_size -= res.size;
-                        written_size += res.size;
-                        out = res.out;
-                        if ( free_size < 0 )
-                            {
-                            break;
-                            }
-                        }
+                    break;
                     }
                 }
             }
@@ -668,6 +680,110 @@ int action::check_devices( char* err_description, int size ) const
 
     return 0;
     }
+//-----------------------------------------------------------------------------
+void action::compile() const
+    {
+    flat_devices.clear();
+    subgroups_offsets.clear();
+    groups_offsets.clear();
+
+    for ( auto& group : devices )
+        {
+        groups_offsets.push_back( subgroups_offsets.size() );
+        for ( auto& subgroup : group )
+            {
+            subgroups_offsets.push_back( flat_devices.size() );
+            flat_devices.insert( flat_devices.end(),
+                subgroup.begin(), subgroup.end() );
+            }
+        }
+    groups_offsets.push_back( subgroups_offsets.size() );
+    subgroups_offsets.push_back( flat_devices.size() );
+
+    errors_mask.clear();
+    has_unregistered_devices = false;
+    for ( auto dev : flat_devices )
+        {
+        u_int n = dev->get_serial_n();
+        if ( G_DEVICE_MANAGER()->get_device( n ) != dev )
+            {
+            has_unregistered_devices = true;
+            continue;
+            }
+
+        u_int word_n = n / 32;
+        u_int_4 bit = 1UL << n % 32;
+        auto it = std::find_if( errors_mask.begin(), errors_mask.end(),
+            [ word_n ]( const std::pair< u_int, u_int_4 >& m )
+                {
+                return m.first == word_n;
+                } );
+        if ( it != errors_mask.end() )
+            {
+            it->second |= bit;
+            }
+        else
+            {
+            errors_mask.emplace_back( word_n, bit );
+            }
+        }
+
+    is_compiled = true;
+    }
+//-----------------------------------------------------------------------------
+bool action::is_any_device_error() const
+    {
+    if ( !is_compiled ) compile();
+    if ( flat_devices.empty() ) return false;
+
+    if ( has_unregistered_devices || !G_DEVICE_MANAGER()->is_errors_valid() )
+        {
+        return true;
+        }
+
+    for ( auto& m : errors_mask )
+        {
+        if ( G_DEVICE_MANAGER()->get_errors_word( m.first ) & m.second )
+            {
+            return true;
+            }
+        }
+
+    return false;
+    }
+//-----------------------------------------------------------------------------
+size_t action::get_groups_count() const
+    {
+    if ( !is_compiled ) compile();
+
+    return groups_offsets.size() - 1;
+    }
+//-----------------------------------------------------------------------------
+size_t action::get_subgroups_count( u_int group ) const
+    {
+    if ( !is_compiled ) compile();
+
+    if ( group + 1 >= groups_offsets.size() ) return 0;
+
+    return groups_offsets[ group + 1 ] - groups_offsets[ group ];
+    }
+//-----------------------------------------------------------------------------
+action::devices_span action::get_subgroup( u_int group, u_int subgroup ) const
+    {
+    if ( subgroup >= get_subgroups_count( group ) ) return devices_span();
+
+    size_t idx = groups_offsets[ group ] + subgroup;
+    size_t start = subgroups_offsets[ idx ];
+    return devices_span( flat_devices.data() + start,
+        subgroups_offsets[ idx + 1 ] - start );
+    }
+//-----------------------------------------------------------------------------
+action::devices_span action::get_all_devices() const
+    {
+    if ( !is_compiled ) compile();
+
+    return devices_span( flat_devices.data(), flat_devices.size() );
+    }
 //----------------------------------------------------------------------------
 void action::add_dev( device *dev, u_int group /*= 0 */, u_int subgroup /*= 0 */ )
     {
@@ -688,6 +804,8 @@ void action::add_dev( device *dev, u_int group /*= 0 */, u_int subgroup /*= 0 */
         }
 
     devices[ group ][ subgroup ].push_back( dev );
+    is_compiled = false;
+    on_devices_changed();
     }
 //-----------------------------------------------------------------------------
 int action::set_int_property( const char* name, size_t idx, int value )
@@ -703,6 +821,16 @@ int action::set_int_property( const char* name, size_t idx, int value )
 void action::clear_dev()
     {
     devices.clear();
+    is_compiled = false;
+    on_devices_changed();
+    }
+//-----------------------------------------------------------------------------
+void action::on_devices_changed() const
+    {
+    if ( owner_state && owner_state->get_owner() )
+        {
+        owner_state->get_owner()->set_evaluated_operations_changed();
+        }
     }
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -717,10 +845,9 @@ void on_action::evaluate()
         return;
         }
 
-    auto& devs = devices[ MAIN_GROUP ][ MAIN_SUBGROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    for ( auto dev : get_subgroup( MAIN_GROUP, MAIN_SUBGROUP ) )
         {
-        devs[ i ]->on();
+        dev->on();
         }
     }
 //-----------------------------------------------------------------------------
@@ -741,8 +868,8 @@ void delay_on_action::evaluate()
         return;
         }
 
-    auto& dev_groups = devices[ MAIN_GROUP ];
-    for ( u_int idx = 0; idx < dev_groups.size(); idx++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int idx = 0; idx < groups_cnt; idx++ )
         {
         int param_idx = par_idx.size() > idx ? par_idx[ idx ] : 0;
         if ( param_idx > 0 )
@@ -754,10 +881,9 @@ void delay_on_action::evaluate()
                 }
             }
 
-        auto& devs = devices[ MAIN_GROUP ][ idx ];
-        for ( u_int i = 0; i < devs.size(); i++ )
+        for ( auto dev : get_subgroup( MAIN_GROUP, idx ) )
             {
-            devs[ i ]->on();
+            dev->on();
             }
         }
     }
@@ -770,10 +896,9 @@ void on_reverse_action::evaluate()
         return;
         }
 
-    auto &devs = devices[ MAIN_GROUP ][ MAIN_SUBGROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    for ( auto dev : get_subgroup( MAIN_GROUP, MAIN_SUBGROUP ) )
         {
-        devs[ i ]->set_state( 2 );
+        dev->set_state( 2 );
         }
     }
 //-----------------------------------------------------------------------------
@@ -785,12 +910,11 @@ void off_action::evaluate()
         return;
         }
 
-    auto &devs = devices[ MAIN_GROUP ][ MAIN_SUBGROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    for ( auto dev : get_subgroup( MAIN_GROUP, MAIN_SUBGROUP ) )
         {
-        if ( devs[ i ]->get_type() == device::DT_V )
+        if ( dev->get_type() == device::DT_V )
             {
-            valve* v = (valve*)devs[ i ];
+            valve* v = (valve*)dev;
             if ( !v->is_wash_seat_active() )
                 {
                 v->off();
@@ -798,7 +922,7 @@ void off_action::evaluate()
             }
         else
             {
-            devs[ i ]->off();
+            dev->off();
             }
         }
     }
@@ -821,8 +945,8 @@ void delay_off_action::evaluate()
         return;
         }
 
-    auto& dev_groups = devices[ MAIN_GROUP ];
-    for ( u_int idx = 0; idx < dev_groups.size(); idx++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int idx = 0; idx < groups_cnt; idx++ )
         {
         int param_idx = par_idx.size() > idx ? par_idx[ idx ] : 0;
         int new_state = 0;
@@ -835,10 +959,9 @@ void delay_off_action::evaluate()
                 }
             }
 
-        auto& devs = devices[ MAIN_GROUP ][ idx ];
-        for ( u_int i = 0; i < devs.size(); i++ )
+        for ( auto dev : get_subgroup( MAIN_GROUP, idx ) )
             {
-            devs[ i ]->set_state( new_state );
+            dev->set_state( new_state );
             }
         }
     }
@@ -852,8 +975,7 @@ int required_DI_action::check( char* reason, int max_len ) const
         return 0;
         }
 
-    auto &devs = devices[ MAIN_GROUP ][ MAIN_SUBGROUP ];
-    for ( auto d : devs )
+    for ( auto d : get_subgroup( MAIN_GROUP, MAIN_SUBGROUP ) )
         {
         if ( !d->is_active() )
             {
@@ -903,7 +1025,8 @@ step::step( std::string name, operation_state *owner,
     actions.push_back( new inverted_DI_DO_action() );
     actions.push_back( new AI_AO_action() );
     actions.push_back( new wash_action() );
-    actions.push_back( new enable_step_by_signal() );
+    enable_action = new enable_step_by_signal();
+    actions.push_back( enable_action );
     actions.push_back( new delay_on_action() );
     actions.push_back( new delay_off_action() );
           
@@ -915,6 +1038,11 @@ step::step( std::string name, operation_state *owner,
         {
         actions.push_back( new jump_if_action( "Переход в шаг по условию" ) );
         }
+
+    for ( auto a : actions )
+        {
+        a->set_owner( owner );
+        }
     }
 //-----------------------------------------------------------------------------
 step::~step()
@@ -1056,15 +1184,16 @@ int DI_DO_action::check( char* reason, int max_len ) const
         return 0;
         }
 
-    auto &devs = devices[ MAIN_GROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
-        if ( devs[ i ].empty() )
+        auto devs = get_subgroup( MAIN_GROUP, i );
+        if ( devs.empty() )
             {
             continue;
             }
 
-        auto d_i_device = devs[ i ][ 0 ];
+        auto d_i_device = devs[ 0 ];
         if ( d_i_device->get_type() != device::DT_DI &&
             d_i_device->get_type() != device::DT_SB &&
             d_i_device->get_type() != device::DT_GS &&
@@ -1090,16 +1219,16 @@ void DI_DO_action::evaluate()
         return;
         }
 
-    auto &devs = devices[ MAIN_GROUP ];
-
-    for ( u_int i = 0; i < devs.size(); i++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
-        if ( devs[ i ].empty() )
+        auto devs = get_subgroup( MAIN_GROUP, i );
+        if ( devs.empty() )
             {
             continue;
             }
 
-        evaluate_DO( devs[ i ] );
+        evaluate_DO( devs );
         }
     }
 //-----------------------------------------------------------------------------
@@ -1110,35 +1239,31 @@ void DI_DO_action::finalize()
         return;
         }
 
-    auto& devs = devices[ MAIN_GROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
-        if ( devs[ i ].empty() )
-            {
-            continue;
-            }
-
-        for ( u_int j = 1; j < devs[ i ].size(); j++ )
+        auto devs = get_subgroup( MAIN_GROUP, i );
+        for ( u_int j = 1; j < devs.size(); j++ )
             {
-            devs[ i ][ j ]->off();
+            devs[ j ]->off();
             }
         }    
     }
 //-----------------------------------------------------------------------------
-void DI_DO_action::evaluate_DO( std::vector< device* > devices )
+void DI_DO_action::evaluate_DO( const devices_span& devs )
     {
-    if ( devices[ 0 ]->is_active() )
+    if ( devs[ 0 ]->is_active() )
         {
-        for ( u_int j = 1; j < devices.size(); j++ )
+        for ( u_int j = 1; j < devs.size(); j++ )
             {
-            devices[ j ]->on();
+            devs[ j ]->on();
             }
         }
     else
         {
-        for ( u_int j = 1; j < devices.size(); j++ )
+        for ( u_int j = 1; j < devs.size(); j++ )
             {
-            devices[ j ]->off();
+            devs[ j ]->off();
             }
         }
     }
@@ -1149,16 +1274,16 @@ inverted_DI_DO_action::inverted_DI_DO_action():
     {
     }
 //-----------------------------------------------------------------------------
-void inverted_DI_DO_action::evaluate_DO( std::vector< device* > devices )
+void inverted_DI_DO_action::evaluate_DO( const devices_span& devs )
     {
     int new_state = 0;
-    if ( !devices[ 0 ]->is_active() )
+    if ( !devs[ 0 ]->is_active() )
         {
         new_state = 1;
         }
-    for ( u_int j = 1; j < devices.size(); j++ )
+    for ( u_int j = 1; j < devs.size(); j++ )
         {
-        devices[ j ]->set_state( new_state );
+        devs[ j ]->set_state( new_state );
         }
     }
 //-----------------------------------------------------------------------------
@@ -1175,15 +1300,16 @@ int AI_AO_action::check( char* reason, int max_len ) const
         return 0;
         }
 
-    auto& devs = devices[ MAIN_GROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
-        if ( devs[ i ].empty() )
+        auto devs = get_subgroup( MAIN_GROUP, i );
+        if ( devs.empty() )
             {
             continue;
             }
 
-        auto do_device = devs[ i ][ 0 ];
+        auto do_device = devs[ 0 ];
         if ( do_device->get_type() != device::DT_AI &&
             do_device->get_type() != device::DT_PT &&
             do_device->get_type() != device::DT_LT &&
@@ -1210,18 +1336,13 @@ void AI_AO_action::evaluate()
         return;
         }
 
-    auto &devs = devices[ MAIN_GROUP ];
-
-    for ( u_int i = 0; i < devs.size(); i++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
-        if ( devs[ i ].empty() )
-            {
-            continue;
-            }
-
-        for ( u_int j = 1; j < devs[ i ].size(); j++ )
+        auto devs = get_subgroup( MAIN_GROUP, i );
+        for ( u_int j = 1; j < devs.size(); j++ )
             {
-            devs[ i ][ j ]->set_value( devs[ i ][ 0 ]->get_value() );
+            devs[ j ]->set_value( devs[ 0 ]->get_value() );
             }
         }
     }
@@ -1233,17 +1354,13 @@ void AI_AO_action::finalize()
         return;
         }
 
-    auto& devs = devices[ MAIN_GROUP ];
-    for ( u_int i = 0; i < devs.size(); i++ )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
-        if ( devs[ i ].empty() )
-            {
-            continue;
-            }
-
-        for ( u_int j = 1; j < devs[ i ].size(); j++ )
+        auto devs = get_subgroup( MAIN_GROUP, i );
+        for ( u_int j = 1; j < devs.size(); j++ )
             {
-            devs[ i ][ j ]->off();
+            devs[ j ]->off();
             }
         }
     }
@@ -1440,6 +1557,7 @@ void open_seat_action::add_dev( device *dev, u_int group, u_int seat_type )
         }
 
     seat_group[ 0 ][ group ].push_back( dev );
+    on_devices_changed();
     }
 //-----------------------------------------------------------------------------
 void open_seat_action::print( const char* prefix /*= "" */,
@@ -1504,8 +1622,8 @@ bool open_seat_action::is_empty() const
     return false;
     }
 //-----------------------------------------------------------------------------
-void open_seat_action::switch_off( std::vector< std::vector< device* > > devices,
-    bool is_check )
+void open_seat_action::switch_off(
+    const std::vector< std::vector< device* > >& devices, bool is_check )
     {
     for ( u_int i = 0; i < devices.size(); i++ )
         {
@@ -1513,7 +1631,7 @@ void open_seat_action::switch_off( std::vector< std::vector< device* > > devices
         }
     };
 //-----------------------------------------------------------------------------
-void open_seat_action::switch_off_group( std::vector< device* > group,
+void open_seat_action::switch_off_group( const std::vector< device* >& group,
     bool is_check )
     {
     for ( u_int i = 0; i < group.size(); i++ )
@@ -1540,7 +1658,7 @@ void open_seat_action::switch_off_group( std::vector< device* > group,
         }
     };
 //-----------------------------------------------------------------------------
-void open_seat_action::switch_on_group( std::vector< device* > group,
+void open_seat_action::switch_on_group( const std::vector< device* >& group,
     valve::VALVE_STATE st )
     {
     for ( u_int i = 0; i < group.size(); i++ )
@@ -1568,20 +1686,25 @@ void wash_action::evaluate()
         return;
         }
 
-    for ( u_int idx = 0; idx < devices.size(); idx++ )
+    auto groups_cnt = get_groups_count();
+    for ( u_int idx = 0; idx < groups_cnt; idx++ )
         {
-        auto &devs = devices[ idx ];
+        auto DO_devs = get_subgroup( idx, G_DO );
+        auto DI_devs = get_subgroup( idx, G_DI );
+        auto dev_devs = get_subgroup( idx, G_DEV );
+        auto rev_devs = get_subgroup( idx, G_REV_DEV );
+        auto freq_devs = get_subgroup( idx, G_PUMP_FREQ );
 
         //Подаем сигналы "ОК".
-        for ( u_int i = 0; i < devs[ G_DO ].size(); i++ )
+        for ( u_int i = 0; i < DO_devs.size(); i++ )
             {
-            devs[ G_DO ][ i ]->on();
+            DO_devs[ i ]->on();
             }
 
         int new_state = 0;
 
         // Если нет сигналов, то устройства включаем.
-        if ( devs[ G_DI ].empty() )
+        if ( DI_devs.empty() )
             {
             new_state = 1;
             }
@@ -1589,9 +1712,9 @@ void wash_action::evaluate()
             {
             // В зависимости от сигнала запроса включения устройств выключаем
             // устройства.
-            for ( u_int i = 0; i < devs[ G_DI ].size(); i++ )
+            for ( u_int i = 0; i < DI_devs.size(); i++ )
                 {
-                if ( devs[ G_DI ][ i ]->is_active() )
+                if ( DI_devs[ i ]->is_active() )
                     {
                     new_state = 1;
                     break;
@@ -1600,9 +1723,9 @@ void wash_action::evaluate()
             }
 
         float new_val = -1;
-        if ( !devs[ G_PUMP_FREQ ].empty() )
+        if ( !freq_devs.empty() )
             {
-            new_val = devs[ G_PUMP_FREQ ][ 0 ]->get_value();
+            new_val = freq_devs[ 0 ]->get_value();
             }
         else
             {
@@ -1614,9 +1737,9 @@ void wash_action::evaluate()
             }
 
         //Включаем или выключаем устройства.
-        for ( u_int i = 0; i < devs[ G_DEV ].size(); i++ )
+        for ( u_int i = 0; i < dev_devs.size(); i++ )
             {
-            auto dev = devs[ G_DEV ][ i ];
+            auto dev = dev_devs[ i ];
             dev->set_state( new_state );
 
             auto type = dev->get_type();
@@ -1627,9 +1750,9 @@ void wash_action::evaluate()
                 dev->set_value( new_state > 0 ? new_val : 0 );
                 }
             }
-        for ( u_int i = 0; i < devs[ G_REV_DEV ].size(); i++ )
+        for ( u_int i = 0; i < rev_devs.size(); i++ )
             {
-            auto dev = devs[ G_REV_DEV ][ i ];
+            auto dev = rev_devs[ i ];
             dev->set_state( new_state > 0 ? 2 : 0 );
 
             if ( new_val != -1 && dev->get_type() == device::DT_M )
@@ -1641,17 +1764,17 @@ void wash_action::evaluate()
         bool is_dev_error = false;
         // Чуть раньше подали управляющий сигнал. Сейчас проверяем
         // состояния устройств (насосов, клапанов).
-        for ( u_int i = 0; i < devs[ G_DEV ].size(); i++ )
+        for ( u_int i = 0; i < dev_devs.size(); i++ )
             {
-            if ( devs[ G_DEV ][ i ]->get_state() == -1 )
+            if ( dev_devs[ i ]->get_state() == -1 )
                 {
                 is_dev_error = true;
                 break;
                 }
             }
-        for ( u_int i = 0; i < devs[ G_REV_DEV ].size(); i++ )
+        for ( u_int i = 0; i < rev_devs.size(); i++ )
             {
-            if ( devs[ G_REV_DEV ][ i ]->get_state() == -1 )
+            if ( rev_devs[ i ]->get_state() == -1 )
                 {
                 is_dev_error = true;
                 break;
@@ -1661,9 +1784,9 @@ void wash_action::evaluate()
         // сигналы "ОК".
         if ( is_dev_error )
             {
-            for ( u_int i = 0; i < devs[ G_DO ].size(); i++ )
+            for ( u_int i = 0; i < DO_devs.size(); i++ )
                 {
-                devs[ G_DO ][ i ]->off();
+                DO_devs[ i ]->off();
                 }
             }
         }
@@ -1701,21 +1824,24 @@ void wash_action::finalize()
         return;
         }
 
-    for ( u_int idx = 0; idx < devices.size(); idx++ )
+    auto groups_cnt = get_groups_count();
+    for ( u_int idx = 0; idx < groups_cnt; idx++ )
         {
-        auto& devs = devices[ idx ];
+        auto DO_devs = get_subgroup( idx, G_DO );
+        auto dev_devs = get_subgroup( idx, G_DEV );
+        auto rev_devs = get_subgroup( idx, G_REV_DEV );
 
-        for ( u_int i = 0; i < devs[ G_DO ].size(); i++ )
+        for ( u_int i = 0; i < DO_devs.size(); i++ )
             {
-            devs[ G_DO ][ i ]->off();
+            DO_devs[ i ]->off();
             }
-        for ( u_int i = 0; i < devs[ G_DEV ].size(); i++ )
+        for ( u_int i = 0; i < dev_devs.size(); i++ )
             {
-            devs[ G_DEV ][ i ]->off();            
+            dev_devs[ i ]->off();            
             }
-        for ( u_int i = 0; i < devs[ G_REV_DEV ].size(); i++ )
+        for ( u_int i = 0; i < rev_devs.size(); i++ )
             {
-            devs[ G_REV_DEV ][ i ]->off();
+            rev_devs[ i ]->off();
             }    
         }
     }
@@ -1734,12 +1860,13 @@ bool jump_if_action::is_jump( int& next )
         return false;
         }
 
-    for ( size_t idx = 0; idx < devices.size(); idx++ )
+    auto groups_cnt = get_groups_count();
+    for ( u_int idx = 0; idx < groups_cnt; idx++ )
         {
         if ( idx < next_n.size() ) next = next_n[ idx ];
    
-        auto res = check( devices[ idx ][ G_ON_DEVICES ], true ) &&
-            check( devices[ idx ][ G_OFF_DEVICES ], false );
+        auto res = check( get_subgroup( idx, G_ON_DEVICES ), true ) &&
+            check( get_subgroup( idx, G_OFF_DEVICES ), false );
 
         if ( res ) return true;
         }
@@ -1748,14 +1875,15 @@ bool jump_if_action::is_jump( int& next )
     }
 //-----------------------------------------------------------------------------
 bool jump_if_action::check(
-    const std::vector< device* >& checked_devices, bool check_is_opened ) const
+    const devices_span& checked_devices, bool check_is_opened ) const
     {
     for ( auto dev : checked_devices )
         {
         auto type = dev->get_type();
         if ( type == device::DT_V )
             {
-            auto v = dynamic_cast<valve*>( dev );
+            //Все устройства типа DT_V - клапаны.
+            auto v = static_cast<valve*>( dev );
             if ( check_is_opened && !v->is_opened() ||
                 !check_is_opened && !v->is_closed() ) return false;
             }
@@ -1836,11 +1964,11 @@ bool enable_step_by_signal::is_any_group_active() const
         return false;
         }
 
-    auto& main_group = devices[ MAIN_GROUP ];
-    for( auto& group : main_group )
+    auto groups_cnt = get_subgroups_count( MAIN_GROUP );
+    for ( u_int i = 0; i < groups_cnt; i++ )
         {
         auto is_group_ok = true;
-        for( auto& dev : group )
+        for( auto dev : get_subgroup( MAIN_GROUP, i ) )
             {
             if ( !dev->is_active() )
                 {
@@ -1989,9 +2117,9 @@ void operation_state::evaluate()
             {
             steps[ step_n ]->evaluate();
 
-            auto enable_action = dynamic_cast<enable_step_by_signal*>(
-                ( *steps[ step_n ] )[ step::A_ENABLE_STEP_BY_SIGNAL ] );
-            if ( enable_action && !enable_action->is_empty() &&
+            auto enable_action =
+                steps[ step_n ]->get_enable_step_by_signal_action();
+            if ( !enable_action->is_empty() &&
                 !enable_action->is_any_group_active() &&
                 enable_action->should_turn_off() )
                 {
@@ -2003,10 +2131,9 @@ void operation_state::evaluate()
         {
         if ( !is_active_extra_step( idx + 1 ) )
             {
-            auto step = steps[ idx ];
-            auto enable_action = dynamic_cast<enable_step_by_signal*>(
-                ( *step )[ step::A_ENABLE_STEP_BY_SIGNAL ] );
-            if ( enable_action && enable_action->is_any_group_active() )
+            auto enable_action =
+                steps[ idx ]->get_enable_step_by_signal_action();
+            if ( enable_action->is_any_group_active() )
                 {
                 on_extra_step( idx + 1 );
                 }
@@ -2510,6 +2637,7 @@ bool operation_state::is_active_extra_step( int step_idx ) const
 operation* operation_manager::add_operation( const char* name )
     {
     operations.push_back( new operation( name, this, (int)operations.size() + 1 ) );
+    is_evaluated_operations_changed = true;
 
     return operations[ operations.size() - 1 ];
     }
@@ -2546,6 +2674,29 @@ void operation_manager::print()
         }
     }
 //-----------------------------------------------------------------------------
+u_int operation_manager::get_next_evaluated_operation( u_int n )
+    {
+    if ( is_evaluated_operations_changed )
+        {
+        is_evaluated_operations_changed = false;
+
+        evaluated_operations.clear();
+        for ( u_int i = 0; i < operations.size(); i++ )
+            {
+            if ( operations[ i ]->is_evaluation_needed() )
+                {
+                evaluated_operations.push_back( i + 1 );
+                }
+            }
+        }
+
+    auto next = std::upper_bound( evaluated_operations.begin(),
+        evaluated_operations.end(), n );
+    if ( next == evaluated_operations.end() ) return 0;
+
+    return *next;
+    }
+//-----------------------------------------------------------------------------
 operation_manager::operation_manager( i_tech_object *owner ):
     owner( owner )    
     {
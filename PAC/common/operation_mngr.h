@@ -143,15 +143,110 @@ class action
         /// @brief Очистка устройств действия.
         virtual void clear_dev();
 
+        /// @brief Задание состояния операции, которому принадлежит действие.
+        void set_owner( operation_state* new_owner )
+            {
+            owner_state = new_owner;
+            }
+
+        /// @brief Непрерывный участок устройств действия (подгруппа или все
+        /// устройства).
+        class devices_span
+            {
+            public:
+                devices_span( device* const* first = nullptr, size_t cnt = 0 ) :
+                    first( first ), cnt( cnt )
+                    {
+                    }
+
+                device* const* begin() const
+                    {
+                    return first;
+                    }
+
+                device* const* end() const
+                    {
+                    return first + cnt;
+                    }
+
+                size_t size() const
+                    {
+                    return cnt;
+                    }
+
+                bool empty() const
+                    {
+                    return 0 == cnt;
+                    }
+
+                device* operator[] ( size_t idx ) const
+                    {
+                    return first[ idx ];
+                    }
+
+            private:
+                device* const* first;
+                size_t cnt;
+            };
+
     protected:
+        /// @brief Количество групп.
+        size_t get_groups_count() const;
+
+        /// @brief Количество подгрупп группы.
+        size_t get_subgroups_count( u_int group ) const;
+
+        /// @brief Устройства подгруппы.
+        devices_span get_subgroup( u_int group, u_int subgroup ) const;
+
+        /// @brief Все устройства действия.
+        devices_span get_all_devices() const;
+
+        /// @brief Пометка об изменении состава устройств.
+        ///
+        /// От наличия устройств зависит, выполняется ли операция в простое
+        /// (@ref operation::is_evaluation_needed).
+        void on_devices_changed() const;
+
         u_int subgropups_cnt;
 
-        // Устройства.
-        std::vector < std::vector< std::vector< device* > > > devices;
         std::string name;                           ///< Имя действия.
 
         const saved_params_float *par = nullptr;    ///< Параметры действия.
         std::vector< int >        par_idx;  ///< Индексы параметров действия.
+
+    private:
+        /// @brief Компиляция устройств в непрерывный массив.
+        ///
+        /// Выполняется при первом обращении к устройствам после изменения
+        /// их состава (обычно - после описания шагов при инициализации).
+        void compile() const;
+
+        /// @brief Есть ли устройства в ошибке (по рассчитанным в цикле
+        /// признакам ошибок устройств, см. @ref device_manager::update_errors).
+        ///
+        /// @return true - есть ошибки или признаки неприменимы (не
+        /// рассчитаны, есть незарегистрированные устройства).
+        bool is_any_device_error() const;
+
+        /// Устройства (группы, подгруппы) в порядке добавления.
+        std::vector < std::vector< std::vector< device* > > > devices;
+
+        /// Скомпилированные устройства: все подгруппы подряд.
+        mutable std::vector< device* > flat_devices;
+        /// Начала подгрупп в flat_devices (последний элемент - конец).
+        mutable std::vector< size_t > subgroups_offsets;
+        /// Первые подгруппы групп в subgroups_offsets (последний
+        /// элемент - конец).
+        mutable std::vector< size_t > groups_offsets;
+        mutable bool is_compiled = false;
+
+        /// Маска устройств в признаках ошибок: номер слова и биты.
+        mutable std::vector< std::pair< u_int, u_int_4 > > errors_mask;
+        /// Есть устройства, отсутствующие в менеджере устройств.
+        mutable bool has_unregistered_devices = false;
+
+        operation_state* owner_state = nullptr;
     };
 //-----------------------------------------------------------------------------
 /// <summary>
@@ -277,13 +372,14 @@ class open_seat_action: public action
         bool is_mode;             ///< Является ли шагом операции.
         operation_state* owner;
 
-        void switch_off( std::vector< std::vector< device* > > devices,
+        void switch_off( const std::vector< std::vector< device* > >& devices,
             bool is_check = false );
 
-        void switch_off_group( std::vector< device* > group,
+        void switch_off_group( const std::vector< device* >& group,
             bool is_check = false );
 
-        void switch_on_group( std::vector< device* > group, valve::VALVE_STATE st );
+        void switch_on_group( const std::vector< device* >& group,
+            valve::VALVE_STATE st );
     };
 //-----------------------------------------------------------------------------
 /// <summary>
@@ -301,7 +397,7 @@ class DI_DO_action: public action
         void finalize() override;
 
     protected:
-        virtual void evaluate_DO( std::vector< device* > devices );
+        virtual void evaluate_DO( const devices_span& devs );
     };
 //-----------------------------------------------------------------------------
 /// <summary>
@@ -313,7 +409,7 @@ class inverted_DI_DO_action : public DI_DO_action
         inverted_DI_DO_action();
 
     protected:
-        void evaluate_DO( std::vector< device* > devices ) override;
+        void evaluate_DO( const devices_span& devs ) override;
     };
 //-----------------------------------------------------------------------------
 /// <summary>
@@ -407,7 +503,7 @@ class jump_if_action : public action
         void print( const char* prefix = "", bool new_line = true ) const override;
 
     private:
-        bool check( const std::vector< device* > &checked_devices,
+        bool check( const devices_span& checked_devices,
             bool check_is_opened ) const;
 
         enum GROUPS
@@ -511,6 +607,15 @@ class step
 
         int check_devices( char* err_dev_name, int str_len );
 
+        /// @brief Получение действия "включение шага по сигналу".
+        ///
+        /// Аналогично ( *this )[ A_ENABLE_STEP_BY_SIGNAL ], но без
+        /// приведения типа (используется при расчете состояния каждый цикл).
+        enable_step_by_signal* get_enable_step_by_signal_action() const
+            {
+            return enable_action;
+            }
+
         const char* get_name() const
             {
             return name.c_str();
@@ -523,6 +628,9 @@ class step
     private:
         std::vector< action* > actions; ///< Действия.
         action action_stub;             ///< Фиктивное действие.
+
+        /// Действие "включение шага по сигналу" (из actions).
+        enable_step_by_signal* enable_action = nullptr;
         u_int_4 start_time;             ///< Время старта шага.
 
         bool is_mode;     ///< Выполняется ли все время во время операции.
@@ -585,6 +693,11 @@ class operation_state
             dx_step_time = 0;
             }
 
+        operation_manager* get_owner() const
+            {
+            return owner;
+            }
+
         /// @brief Переход к заданному шагу.
         ///
         /// @param new_step - номер шага (с единицы).
@@ -622,6 +735,12 @@ class operation_state
 
         bool is_goto_next_state( int& next_state ) const;
 
+        /// @brief Есть ли активные (в том числе дополнительные) шаги.
+        bool has_active_steps() const
+            {
+            return active_step_n >= 0 || !active_steps.empty();
+            }
+
     private:
         std::string name;
         std::vector< step* > steps;
@@ -705,6 +824,13 @@ class operation
 
         void evaluate();
 
+        /// @brief Нужно ли выполнять операцию в цикле.
+        ///
+        /// Операция в простое не выполняется, если у состояния простоя
+        /// нет действий (ожидания сигналов автовключения, включения шагов
+        /// по сигналу и т.д.) и активных шагов.
+        bool is_evaluation_needed() const;
+
         void finalize();
 
         int check_steps_params( char* err_dev_name, int str_len );
@@ -948,6 +1074,24 @@ class operation_manager
         /// @brief Отладочный вывод объекта в консоль.
         void print();
 
+        /// @brief Получение следующей по номеру выполняемой в цикле операции
+        /// (см. @ref operation::is_evaluation_needed).
+        ///
+        /// @param n - номер предыдущей операции (0 - получение первой).
+        ///
+        /// @return номер операции (с единицы), 0 - больше нет выполняемых
+        /// операций.
+        u_int get_next_evaluated_operation( u_int n );
+
+        /// @brief Пометка об изменении списка выполняемых операций.
+        ///
+        /// Вызывается операциями при смене состояния и шагов. Список
+        /// обновляется при следующем обращении к нему.
+        void set_evaluated_operations_changed()
+            {
+            is_evaluated_operations_changed = true;
+            }
+
         void off_mode( int mode ) const
             {
             owner->set_mode( mode, 0 );
@@ -967,6 +1111,10 @@ class operation_manager
 
     private:
         std::vector< operation* > operations; ///< Операции.
+
+        /// Номера выполняемых в цикле операций (по возрастанию).
+        std::vector< u_int > evaluated_operations;
+        bool is_evaluated_operations_changed = true;
         
         ///< Операция-заглушка.
         operation oper_stub{ "Операция-заглушка", this, -1 };
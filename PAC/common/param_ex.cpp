@@ -16,8 +16,104 @@ char params_manager::is_init = 0;
 #include "g_errors.h"
 
 #include "log.h"
+#include "dtime.h"
 //-----------------------------------------------------------------------------
-params_manager::params_manager(): par( 0 ), project_id( 0 )
+namespace
+    {
+    /// @brief Обработка байта контрольной суммой (побитно).
+    ///
+    /// Байт обрабатывается как знаковый (char), для совместимости с ранее
+    /// рассчитанными контрольными суммами.
+    u_int_2 CRC_byte( u_int_2 CRC, char b )
+        {
+        CRC = CRC ^ b;
+        for ( int idx = 0; idx <= 7; idx++ )
+            {
+            char flag = CRC & 1;
+            CRC = CRC >> 1;
+            if ( flag ) CRC = CRC ^ 0x0A001;
+            }
+
+        return CRC;
+        }
+
+    /// @brief Таблицы для расчета контрольной суммы по 4 байта.
+    ///
+    /// Расчет линеен относительно начального значения и данных, поэтому
+    /// результат - сумма (xor) вкладов начального значения и каждого из
+    /// байт, вклады рассчитываются заранее побитным методом.
+    struct CRC_tables
+        {
+        u_int_2 state_lo[ 256 ];    ///< Вклад младшего байта значения.
+        u_int_2 state_hi[ 256 ];    ///< Вклад старшего байта значения.
+        u_int_2 data[ 4 ][ 256 ];   ///< Вклад байта данных по позиции.
+
+        /// Вклад значения при обработке блока из нулевых байт.
+        u_int_2 block_lo[ 256 ];
+        u_int_2 block_hi[ 256 ];
+
+        CRC_tables()
+            {
+            for ( int i = 0; i < 256; i++ )
+                {
+                u_int_2 lo = i;
+                u_int_2 hi = i << 8;
+                for ( int j = 0; j < params_manager::C_CRC_BLOCK_SIZE; j++ )
+                    {
+                    lo = CRC_byte( lo, 0 );
+                    hi = CRC_byte( hi, 0 );
+                    if ( 3 == j )
+                        {
+                        state_lo[ i ] = lo;
+                        state_hi[ i ] = hi;
+                        }
+                    }
+                block_lo[ i ] = lo;
+                block_hi[ i ] = hi;
+
+                for ( int pos = 0; pos < 4; pos++ )
+                    {
+                    u_int_2 CRC = 0;
+                    for ( int j = 0; j < 4; j++ )
+                        {
+                        CRC = CRC_byte( CRC, j == pos ? ( char ) i : 0 );
+                        }
+                    data[ pos ][ i ] = CRC;
+                    }
+                }
+            }
+
+        /// @brief Расчет контрольной суммы блока (начальное значение - 0).
+        u_int_2 solve_block( const char* buff ) const
+            {
+            const u_char* p = reinterpret_cast< const u_char* >( buff );
+            u_int_2 CRC = 0;
+            for ( int i = 0; i < params_manager::C_CRC_BLOCK_SIZE; i += 4 )
+                {
+                CRC = state_lo[ CRC & 0xFF ] ^ state_hi[ CRC >> 8 ] ^
+                    data[ 0 ][ p[ i ] ] ^ data[ 1 ][ p[ i + 1 ] ] ^
+                    data[ 2 ][ p[ i + 2 ] ] ^ data[ 3 ][ p[ i + 3 ] ];
+                }
+
+            return CRC;
+            }
+        };
+    }
+//-----------------------------------------------------------------------------
+//Контрольные суммы считаются по целым блокам.
+static_assert( params_manager::C_TOTAL_PARAMS_SIZE %
+    params_manager::C_CRC_BLOCK_SIZE == 0,
+    "C_TOTAL_PARAMS_SIZE must be a multiple of C_CRC_BLOCK_SIZE" );
+
+static const u_int DIRTY_BLOCKS_CNT =
+    ( params_manager::C_TOTAL_PARAMS_SIZE +
+    params_manager::C_DIRTY_BLOCK_SIZE - 1 ) / params_manager::C_DIRTY_BLOCK_SIZE;
+//-----------------------------------------------------------------------------
+params_manager::params_manager(): par( 0 ), project_id( 0 ),
+    CRC_changed_blocks( C_CRC_BLOCKS_CNT, false ),
+    is_blocks_CRC_valid( false ), flush_interval( C_DEFAULT_FLUSH_INTERVAL ),
+    last_flush_time( get_millisec() ), dirty_blocks( DIRTY_BLOCKS_CNT, false ),
+    dirty_first( DIRTY_BLOCKS_CNT ), dirty_last( 0 )
     {
     last_idx = 0;
     CRC_mem = NV_memory_manager::get_instance()->get_memory_block(
@@ -31,40 +127,26 @@ params_manager::params_manager(): par( 0 ), project_id( 0 )
 //-----------------------------------------------------------------------------
 u_int_2 params_manager::solve_CRC()
     {
-    int     idx;
-    char    Flag;
+    static const CRC_tables tables;
 
     u_int_2 CRC = 65535;
-    unsigned int datlen = C_TOTAL_PARAMS_SIZE;
-    int bufidx = 0;
-
-    while ( datlen > 0 )
+    for ( int i = 0; i < C_CRC_BLOCKS_CNT; i++ )
         {
-        CRC = CRC ^ params[ bufidx ];
-        for ( idx = 0; idx <= 7; idx++ )
+        int pos = i * C_CRC_BLOCK_SIZE;
+        if ( !is_blocks_CRC_valid || CRC_changed_blocks[ i ] )
             {
-            Flag = CRC & 1;
-            CRC = CRC >> 1;
-            if ( Flag ) CRC = CRC ^ 0x0A001;
+            CRC_changed_blocks[ i ] = false;
+            blocks_CRC[ i ] = tables.solve_block( params + pos );
             }
-        datlen--;
-        bufidx++;
+
+        CRC = tables.block_lo[ CRC & 0xFF ] ^ tables.block_hi[ CRC >> 8 ] ^
+            blocks_CRC[ i ];
         }
+    is_blocks_CRC_valid = true;
+
     char* p = ( char* ) &project_id;
-    CRC = CRC ^ p[ 0 ];
-    for ( idx = 0; idx <= 7; idx++ )
-        {
-        Flag = CRC & 1;
-        CRC = CRC >> 1;
-        if ( Flag ) CRC = CRC ^ 0x0A001;
-        }
-    CRC = CRC ^ p[ 1 ];
-    for ( idx = 0; idx <= 7; idx++ )
-        {
-        Flag = CRC & 1;
-        CRC = CRC >> 1;
-        if ( Flag ) CRC = CRC ^ 0x0A001;
-        }
+    CRC = CRC_byte( CRC, p[ 0 ] );
+    CRC = CRC_byte( CRC, p[ 1 ] );
 
     return CRC;
     }
@@ -81,6 +163,7 @@ int params_manager::init( unsigned int project_id )
 
     memset( params, 0, C_TOTAL_PARAMS_SIZE );
     params_mem->read( params, C_TOTAL_PARAMS_SIZE, 0 );
+    is_blocks_CRC_valid = false;
 
     return 0;
     }
@@ -157,10 +240,120 @@ void params_manager::save( int start_pos, int count )
     {
     if ( 0 == count )
         {
+        start_pos = 0;
         count = C_TOTAL_PARAMS_SIZE;
         }
 
-    params_mem->write( params + start_pos, count, start_pos );
+    if ( start_pos >= 0 && count > 0 &&
+        start_pos + count <= C_TOTAL_PARAMS_SIZE )
+        {
+        u_int first = start_pos / C_CRC_BLOCK_SIZE;
+        u_int last = ( start_pos + count - 1 ) / C_CRC_BLOCK_SIZE;
+        for ( u_int i = first; i <= last; i++ )
+            {
+            CRC_changed_blocks[ i ] = true;
+            }
+        }
+
+    if ( 0 == flush_interval )
+        {
+        params_mem->write( params + start_pos, count, start_pos );
+        return;
+        }
+
+    if ( start_pos < 0 || count < 0 ||
+        start_pos + count > C_TOTAL_PARAMS_SIZE ) return;
+
+    u_int first = start_pos / C_DIRTY_BLOCK_SIZE;
+    u_int last = ( start_pos + count - 1 ) / C_DIRTY_BLOCK_SIZE;
+    for ( u_int i = first; i <= last; i++ )
+        {
+        dirty_blocks[ i ] = true;
+        }
+    if ( first < dirty_first ) dirty_first = first;
+    if ( last > dirty_last ) dirty_last = last;
+    }
+//-----------------------------------------------------------------------------
+void params_manager::set_flush_interval( u_long interval )
+    {
+    flush_interval = interval;
+    if ( 0 == flush_interval )
+        {
+        flush();
+        }
+    }
+//-----------------------------------------------------------------------------
+void params_manager::evaluate()
+    {
+    if ( dirty_first > dirty_last ) return;
+
+    if ( get_delta_millisec( last_flush_time ) >= flush_interval )
+        {
+        flush();
+        }
+    }
+//-----------------------------------------------------------------------------
+u_int params_manager::flush()
+    {
+    last_flush_time = get_millisec();
+    if ( dirty_first > dirty_last ) return 0;
+
+    u_int writes_cnt = 0;
+    if ( get_dirty_ranges_count() > C_MAX_FLUSH_WRITES )
+        {
+        //Много разрозненных изменений - одна запись общего диапазона.
+        write_blocks( dirty_first, dirty_last + 1 );
+        writes_cnt = 1;
+        }
+    else
+        {
+        u_int i = dirty_first;
+        while ( i <= dirty_last )
+            {
+            if ( !dirty_blocks[ i ] )
+                {
+                i++;
+                continue;
+                }
+
+            u_int start_block = i;
+            while ( i <= dirty_last && dirty_blocks[ i ] ) i++;
+            write_blocks( start_block, i );
+            writes_cnt++;
+            }
+        }
+
+    for ( u_int i = dirty_first; i <= dirty_last; i++ )
+        {
+        dirty_blocks[ i ] = false;
+        }
+    dirty_first = DIRTY_BLOCKS_CNT;
+    dirty_last = 0;
+
+    return writes_cnt;
+    }
+//-----------------------------------------------------------------------------
+u_int params_manager::get_dirty_ranges_count() const
+    {
+    u_int cnt = 0;
+    for ( u_int i = dirty_first; i <= dirty_last; i++ )
+        {
+        if ( dirty_blocks[ i ] && ( i == dirty_first || !dirty_blocks[ i - 1 ] ) )
+            {
+            cnt++;
+            }
+        }
+
+    return cnt;
+    }
+//-----------------------------------------------------------------------------
+void params_manager::write_blocks( u_int start_block, u_int end_block )
+    {
+    u_int start_pos = start_block * C_DIRTY_BLOCK_SIZE;
+    u_int end_pos = end_block * C_DIRTY_BLOCK_SIZE;
+    if ( end_pos > C_TOTAL_PARAMS_SIZE ) end_pos = C_TOTAL_PARAMS_SIZE;
+
+    params_mem->write( params + start_pos, end_pos - start_pos, start_pos );
     }
 //-----------------------------------------------------------------------------
 char* params_manager::get_params_data( int size, int &start_pos )
@@ -198,6 +391,9 @@ params_manager* params_manager::get_instance()
 //-----------------------------------------------------------------------------
 params_manager::~params_manager()
     {
+    //Записываем отложенные изменения.
+    if ( params_mem ) flush();
+
     if ( CRC_mem )
         {
         delete params_mem;
@@ -258,6 +454,69 @@ int params_manager::restore_params_from_server_backup( char *backup_str )
     return res;
     }
 //-----------------------------------------------------------------------------
+static u_int_2 solve_bin_backup_CRC( const char* data, int size )
+    {
+    u_int_2 CRC = 65535;
+    for ( int i = 0; i < size; i++ )
+        {
+        CRC = CRC_byte( CRC, data[ i ] );
+        }
+
+    return CRC;
+    }
+//-----------------------------------------------------------------------------
+int params_manager::save_params_as_bin( char* buff, int max_size )
+    {
+    if ( max_size < C_BIN_BACKUP_HEADER_SIZE + 2 ) return 0;
+
+    u_int_4 signature = C_BIN_BACKUP_SIGNATURE;
+    u_int_2 version = C_BIN_BACKUP_VERSION;
+    memcpy( buff, &signature, sizeof( signature ) );
+    memcpy( buff + sizeof( signature ), &version, sizeof( version ) );
+    int res = C_BIN_BACKUP_HEADER_SIZE;
+
+    int size = G_TECH_OBJECT_MNGR()->save_params_as_bin( buff + res,
+        max_size - res - 2 );
+    if ( size < 0 ) return 0;
+    res += size;
+
+    u_int_2 CRC = solve_bin_backup_CRC( buff, res );
+    memcpy( buff + res, &CRC, sizeof( CRC ) );
+
+    return res + sizeof( CRC );
+    }
+//-----------------------------------------------------------------------------
+int params_manager::restore_params_from_bin( const char* data, int size )
+    {
+    if ( size < C_BIN_BACKUP_HEADER_SIZE + 2 ) return 1;
+
+    u_int_4 signature = 0;
+    u_int_2 version = 0;
+    u_int_2 CRC = 0;
+    memcpy( &signature, data, sizeof( signature ) );
+    memcpy( &version, data + sizeof( signature ), sizeof( version ) );
+    memcpy( &CRC, data + size - 2, sizeof( CRC ) );
+    if ( signature != C_BIN_BACKUP_SIGNATURE ||
+        version != C_BIN_BACKUP_VERSION ||
+        CRC != solve_bin_backup_CRC( data, size - 2 ) )
+        {
+        G_LOG->error( "Binary params backup is incorrect (signature, "
+            "version or CRC)." );
+        return 1;
+        }
+
+    int res = G_TECH_OBJECT_MNGR()->restore_params_from_bin(
+        data + C_BIN_BACKUP_HEADER_SIZE, size - C_BIN_BACKUP_HEADER_SIZE - 2 );
+    if ( 0 == res )
+        {
+        par[ 0 ][ P_IS_RESET_PARAMS ] = 0;
+        par->save_all();
+        flush();
+        }
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 int params_test::make_test()
     {
@@ -26,6 +26,8 @@
 #include <math.h>
 #include <string.h>
 
+#include <vector>
+
 #include "base_mem.h"
 #include "g_device.h"
 #include "log.h"
@@ -63,7 +65,19 @@ class params_manager
             C_SYS_MEM_SIZE    = 10,          ///< Память для хранения CRC и т.д.
 
             C_CRC_OFFSET      = 0,
-            C_LAST_IDX_OFFSET = 4
+            C_LAST_IDX_OFFSET = 4,
+
+            /// Размер блока, которыми отмечаются измененные параметры.
+            C_DIRTY_BLOCK_SIZE = 64,
+            /// Максимальное количество операций записи при сбросе изменений,
+            /// при большем количестве записывается один общий диапазон.
+            C_MAX_FLUSH_WRITES = 16,
+            /// Интервал отложенной записи по умолчанию, мс.
+            C_DEFAULT_FLUSH_INTERVAL = 1000,
+
+            /// Размер блока, для которого запоминается контрольная сумма.
+            C_CRC_BLOCK_SIZE = 64,
+            C_CRC_BLOCKS_CNT = C_TOTAL_PARAMS_SIZE / C_CRC_BLOCK_SIZE,
             };
 
         /// @brief Возвращает единственный экземпляр класса для работы с
@@ -104,13 +118,36 @@ class params_manager
 
         /// @brief Запись параметров в EEPROM.
         ///
-        /// Запись параметров из массива параметров в EEPROM.
+        /// Запись параметров из массива параметров в EEPROM. При ненулевом
+        /// интервале отложенной записи (@ref set_flush_interval) измененные
+        /// байты только отмечаются, а запись выполняется позже
+        /// (@ref evaluate, @ref flush) - объединенными диапазонами.
         ///
         /// @param start_pos - номер индекса, с которого начать запись
         /// параметров (для записи только одного параметра).
         /// @param count - количество записываемых байт.
         void save( int start_pos = 0, int count = 0 );
 
+        /// @brief Задание интервала отложенной записи параметров, мс.
+        ///
+        /// @param interval - интервал, мс (0 - запись при каждом сохранении).
+        void set_flush_interval( u_long interval );
+
+        /// @brief Запись отложенных изменений по истечении интервала.
+        ///
+        /// Вызывается в основном цикле.
+        void evaluate();
+
+        /// @brief Запись всех отложенных изменений.
+        ///
+        /// Вызывается также при завершении работы.
+        ///
+        /// @return количество выполненных операций записи.
+        u_int flush();
+
+        /// @brief Количество непрерывных диапазонов отложенных изменений.
+        u_int get_dirty_ranges_count() const;
+
         /// @brief Получение указателя на блок данных параметров.
         ///
         /// @param size      - размер блока данных в байтах.
@@ -136,7 +173,39 @@ class params_manager
 
         int restore_params_from_server_backup( char *backup_str );
 
-        // Высчитывание контрольной суммы.
+        enum BIN_BACKUP
+            {
+            C_BIN_BACKUP_SIGNATURE = 0x4B425050,    ///< "PPBK".
+            C_BIN_BACKUP_VERSION = 1,
+            /// Заголовок: сигнатура (4 байта), версия (2 байта).
+            C_BIN_BACKUP_HEADER_SIZE = 6,
+            };
+
+        /// @brief Сохранение параметров объектов в двоичном виде.
+        ///
+        /// Формат: заголовок (@ref C_BIN_BACKUP_HEADER_SIZE), наборы
+        /// параметров объектов (@ref tech_object_manager::save_params_as_bin),
+        /// контрольная сумма (2 байта) всех предыдущих байт.
+        ///
+        /// @return количество записанных байт (0 - недостаточно места).
+        int save_params_as_bin( char* buff, int max_size );
+
+        /// @brief Восстановление параметров объектов из двоичного вида
+        /// (@ref save_params_as_bin).
+        ///
+        /// Значения копируются в память параметров, затем записываются в
+        /// энергонезависимую память одной операцией.
+        ///
+        /// @return 0 - ок, 1 - ошибка формата или контрольной суммы (параметры
+        /// не изменяются).
+        int restore_params_from_bin( const char* data, int size );
+
+        /// @brief Высчитывание контрольной суммы.
+        ///
+        /// Контрольная сумма запоминается для каждого блока параметров
+        /// (@ref C_CRC_BLOCK_SIZE) и пересчитывается только для блоков,
+        /// отмеченных при сохранении (@ref save) или чтении (@ref init)
+        /// параметров. Изменения без сохранения не учитываются.
         u_int_2 solve_CRC();
 
         void reset_params_size();
@@ -167,6 +236,22 @@ class params_manager
 
         memory_range *params_mem; ///< Память параметров.
         memory_range *CRC_mem;    ///< Память контрольной суммы.
+
+        /// @brief Запись блоков [ start_block, end_block ).
+        void write_blocks( u_int start_block, u_int end_block );
+
+        u_int_2 blocks_CRC[ C_CRC_BLOCKS_CNT ]; ///< Контрольные суммы блоков.
+        /// Блоки, сохраненные после расчета контрольных сумм.
+        std::vector< bool > CRC_changed_blocks;
+        bool is_blocks_CRC_valid;
+
+        u_long flush_interval;  ///< Интервал отложенной записи, мс.
+        u_long last_flush_time; ///< Время последней записи, мс.
+
+        /// Измененные (не записанные) блоки параметров.
+        std::vector< bool > dirty_blocks;
+        u_int dirty_first;  ///< Первый измененный блок.
+        u_int dirty_last;   ///< Последний измененный блок.
     };
 //-----------------------------------------------------------------------------
 /// @brief Работа с массивом параметров.
@@ -245,6 +330,32 @@ template < class type, bool is_float > class parameters
             return count;
             }
 
+        /// @brief Запись значений в буфер в двоичном виде.
+        ///
+        /// @param buff     - буфер.
+        /// @param max_size - размер буфера.
+        ///
+        /// @return количество записанных байт (0 - недостаточно места).
+        u_int save_bin( char* buff, u_int max_size ) const
+            {
+            u_int size = count * sizeof( type );
+            if ( size > max_size ) return 0;
+
+            memcpy( buff, values, size );
+            return size;
+            }
+
+        /// @brief Задание значений из буфера в двоичном виде.
+        ///
+        /// Лишние значения буфера игнорируются.
+        ///
+        /// @param buff - буфер.
+        /// @param cnt  - количество значений в буфере.
+        void set_bin( const char* buff, u_int cnt )
+            {
+            memcpy( values, buff, ( cnt < count ? cnt : count ) * sizeof( type ) );
+            }
+
         parameters( int count, const char* name, i_params_owner* owner ) :
             parameters( count, name, 0, owner )
             {
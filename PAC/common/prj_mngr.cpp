@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
 #include <cxxopts.hpp>
 
@@ -13,12 +14,15 @@
 #include "param_ex.h"
 
 #include "lua_manager.h"
+#include "lua_gc_mngr.h"
+#include "lua_hot_reload.h"
 
 #include "tech_def.h"
 
 #include "log.h"
 
 #include "g_errors.h"
+#include "g_device.h"
 
 #ifdef WIN_OS
 #include "w_mem.h"
@@ -34,6 +38,9 @@ int project_manager::proc_main_params( int argc, const char* argv[] )
     {
     if ( !argc || !argv || !argv[ 0 ] ) return 2;
 
+    //Ограничения по умолчанию, далее их можно изменить параметрами.
+    device_communicator::set_default_limits();
+
     //-Работа с параметрами командной строки.
     cxxopts::Options options( argv[ 0 ], "Main control program" );
 
@@ -46,6 +53,14 @@ int project_manager::proc_main_params( int argc, const char* argv[] )
         ( "sys_path", "Sys path", cxxopts::value<std::string>() )
         ( "path", "Path", cxxopts::value<std::string>() )
         ( "extra_paths", "Extra paths", cxxopts::value<std::string>() )
+        ( "no_bytecode_cache", "Do not use Lua bytecode cache" )
+        ( "cycle_time_ms", "Main cycle time for Lua GC budget, ms", cxxopts::value<int>() )
+        ( "lua_mem_limit", "Lua memory limit (full GC when exceeded), KB", cxxopts::value<int>() )
+        ( "hot_reload_us", "Lua hot reload step time budget, us", cxxopts::value<int>() )
+        ( "save_delay_ms", "Params write-behind delay (0 - off), ms", cxxopts::value<int>() )
+        ( "client_limit", "Client read rate limit <rate>:<burst>", cxxopts::value<std::string>() )
+        ( "cmd_limit", "Read command rate limit <cmd>:<rate>:<burst>", cxxopts::value<std::vector<std::string>>() )
+        ( "cmd_cache", "Read command cache time <cmd>:<ms>", cxxopts::value<std::vector<std::string>>() )
         ( "sleep_time_ms", "Sleep time, ms", cxxopts::value<int>()->default_value( "2" ) );
 
     options.positional_help( "<script>" );
@@ -100,6 +115,85 @@ int project_manager::proc_main_params( int argc, const char* argv[] )
         auto& extra_paths_str = result[ "extra_paths" ].as<std::string>();
         init_extra_paths( extra_paths_str.c_str() );
         }
+    if ( result.count( "no_bytecode_cache" ) )
+        {
+        lua_manager::switch_off_bytecode_cache();
+        }
+    if ( result.count( "cycle_time_ms" ) )
+        {
+        int cycle_time = result[ "cycle_time_ms" ].as<int>();
+        if ( cycle_time > 0 ) G_LUA_GC_MANAGER->set_cycle_time( cycle_time );
+        }
+    if ( result.count( "lua_mem_limit" ) )
+        {
+        int mem_limit = result[ "lua_mem_limit" ].as<int>();
+        if ( mem_limit > 0 ) G_LUA_GC_MANAGER->set_memory_limit( mem_limit );
+        }
+    if ( result.count( "hot_reload_us" ) )
+        {
+        int budget = result[ "hot_reload_us" ].as<int>();
+        if ( budget > 0 ) G_LUA_HOT_RELOAD->set_budget( budget );
+        }
+    if ( result.count( "save_delay_ms" ) )
+        {
+        int interval = result[ "save_delay_ms" ].as<int>();
+        if ( interval >= 0 )
+            {
+            params_manager::get_instance()->set_flush_interval( interval );
+            }
+        }
+    if ( result.count( "client_limit" ) )
+        {
+        auto& item = result[ "client_limit" ].as<std::string>();
+        float rate = 0;
+        u_int burst = 1;
+        if ( sscanf( item.c_str(), "%f:%u", &rate, &burst ) < 1 )
+            {
+            G_LOG->warning( "Wrong \"client_limit\" value \"%s\".",
+                item.c_str() );
+            }
+        else
+            {
+            tcp_communicator::get_limiter().set_client_rate_limit(
+                device_communicator::C_SERVICE_N, rate, burst,
+                device_communicator::is_read_cmd );
+            }
+        }
+    if ( result.count( "cmd_limit" ) )
+        {
+        for ( auto& item : result[ "cmd_limit" ].as<std::vector<std::string>>() )
+            {
+            int cmd = 0;
+            float rate = 0;
+            u_int burst = 1;
+            if ( sscanf( item.c_str(), "%d:%f:%u", &cmd, &rate, &burst ) < 2 ||
+                cmd < 0 || cmd > 0xFF || !device_communicator::is_read_cmd( cmd ) )
+                {
+                G_LOG->warning( "Wrong \"cmd_limit\" value \"%s\" "
+                    "(only read commands can be limited).", item.c_str() );
+                continue;
+                }
+            tcp_communicator::get_limiter().set_rate_limit(
+                device_communicator::C_SERVICE_N, cmd, rate, burst );
+            }
+        }
+    if ( result.count( "cmd_cache" ) )
+        {
+        for ( auto& item : result[ "cmd_cache" ].as<std::vector<std::string>>() )
+            {
+            int cmd = 0;
+            u_int cache_time = 0;
+            if ( sscanf( item.c_str(), "%d:%u", &cmd, &cache_time ) < 2 ||
+                cmd < 0 || cmd > 0xFF || !device_communicator::is_read_cmd( cmd ) )
+                {
+                G_LOG->warning( "Wrong \"cmd_cache\" value \"%s\" "
+                    "(only read commands can be cached).", item.c_str() );
+                continue;
+                }
+            tcp_communicator::get_limiter().set_cache_time(
+                device_communicator::C_SERVICE_N, cmd, cache_time );
+            }
+        }
     main_script = result[ "script" ].as<std::string>();
     sleep_time_ms = result[ "sleep_time_ms" ].as<int>();
 
@@ -0,0 +1,436 @@
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "subscription_mngr.h"
+
+#include "PAC_dev.h"
+#include "tcp_cmctr.h"
+#include "log.h"
+
+auto_smart_ptr < subscription_manager > subscription_manager::instance;
+//-----------------------------------------------------------------------------
+subscription_manager* subscription_manager::get_instance()
+    {
+    if ( instance.is_null() )
+        {
+        instance = new subscription_manager();
+        }
+
+    return instance;
+    }
+//-----------------------------------------------------------------------------
+bool subscription_manager::is_match( const char *pattern, const char *name )
+    {
+    const char *star = nullptr;
+    const char *name_after_star = nullptr;
+
+    while ( *name )
+        {
+        if ( *pattern == '?' || *pattern == *name )
+            {
+            pattern++;
+            name++;
+            }
+        else if ( *pattern == '*' )
+            {
+            star = pattern++;
+            name_after_star = name;
+            }
+        else if ( star )
+            {
+            pattern = star + 1;
+            name = ++name_after_star;
+            }
+        else
+            {
+            return false;
+            }
+        }
+
+    while ( *pattern == '*' ) pattern++;
+
+    return *pattern == '\0';
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::subscribe( int skt, const char *pattern,
+    int dev_type, u_int min_interval, float deadband )
+    {
+    if ( subscriptions.size() >= C_MAX_SUBSCRIPTIONS )
+        {
+        G_LOG->warning( "Subscription for s%d rejected - too many "
+            "subscriptions (%d).", skt, C_MAX_SUBSCRIPTIONS );
+        return -1;
+        }
+
+    if ( nullptr == pattern || '\0' == pattern[ 0 ] ) pattern = "*";
+
+    //Номер подписки передается в пакете как u_int_2.
+    do
+        {
+        last_id = last_id % C_MAX_ID + 1;
+        } while ( get_subscription( last_id ) );
+
+    subscription s;
+    s.id = last_id;
+    s.socket = skt;
+    s.min_interval = min_interval;
+    s.deadband = deadband < 0 ? -deadband : deadband;
+    s.last_push_time = get_millisec();
+    s.next_pos = 0;
+    s.is_pending = true;    //Первая передача - все устройства.
+    s.is_cancelled = false;
+
+    auto dev_cnt = G_DEVICE_MANAGER()->get_device_count();
+    for ( u_int i = 0; i < dev_cnt; i++ )
+        {
+        auto dev = G_DEVICE_MANAGER()->get_device( i );
+        if ( C_ANY_TYPE != dev_type && dev->get_type() != dev_type ) continue;
+        if ( !is_match( pattern, dev->get_name() ) ) continue;
+
+        //Номер устройства в пакете передается как u_int_2.
+        if ( s.devices.size() >= C_MAX_DEVICES )
+            {
+            G_LOG->warning( "Subscription %d for s%d: pattern \"%s\" - too "
+                "many devices, only first %d are used.", s.id, skt, pattern,
+                C_MAX_DEVICES );
+            break;
+            }
+
+        s.devices.push_back( { i, 0, 0.f, false } );
+        }
+
+    subscriptions.push_back( s );
+
+    if ( G_DEBUG )
+        {
+        G_LOG->debug( "Subscription %d for s%d: pattern \"%s\", type %d, "
+            "%zu devices.", s.id, skt, pattern, dev_type, s.devices.size() );
+        }
+
+    return s.id;
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::unsubscribe( int skt, int id )
+    {
+    for ( auto it = subscriptions.begin(); it != subscriptions.end(); ++it )
+        {
+        if ( it->id == id && it->socket == skt )
+            {
+            subscriptions.erase( it );
+            return 0;
+            }
+        }
+
+    return 1;
+    }
+//-----------------------------------------------------------------------------
+void subscription_manager::remove_client( int skt )
+    {
+    subscriptions.erase( std::remove_if( subscriptions.begin(),
+        subscriptions.end(),
+        [ skt ]( const subscription &s ) { return s.socket == skt; } ),
+        subscriptions.end() );
+    }
+//-----------------------------------------------------------------------------
+void subscription_manager::clear()
+    {
+    subscriptions.clear();
+    }
+//-----------------------------------------------------------------------------
+size_t subscription_manager::get_subscriptions_count() const
+    {
+    return subscriptions.size();
+    }
+//-----------------------------------------------------------------------------
+subscription_manager::subscription* subscription_manager::get_subscription(
+    int id )
+    {
+    for ( auto &s : subscriptions )
+        {
+        if ( s.id == id ) return &s;
+        }
+
+    return nullptr;
+    }
+//-----------------------------------------------------------------------------
+const subscription_manager::subscription*
+subscription_manager::get_subscription( int id ) const
+    {
+    for ( auto &s : subscriptions )
+        {
+        if ( s.id == id ) return &s;
+        }
+
+    return nullptr;
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::get_devices_count( int id ) const
+    {
+    auto s = get_subscription( id );
+    if ( !s ) return -1;
+
+    return static_cast<int>( s->devices.size() );
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::save_devices( int id, char *buff, int max_size ) const
+    {
+    auto s = get_subscription( id );
+    if ( !s ) return 0;
+
+    int res = snprintf( buff, max_size, "sub_id=%d; devices={", id );
+    for ( const auto &item : s->devices )
+        {
+        if ( res >= max_size ) break;
+
+        auto dev = G_DEVICE_MANAGER()->get_device( item.dev_n );
+        res += snprintf( buff + res, max_size - res, "'%s',", dev->get_name() );
+        }
+    if ( res < max_size )
+        {
+        res += snprintf( buff + res, max_size - res, "}\n" );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::save_changes( int id, u_char *buff, int max_size )
+    {
+    auto s = get_subscription( id );
+    if ( !s ) return 0;
+
+    u_int checked_cnt = 0;
+    int res = save_changes( *s, buff, max_size, checked_cnt );
+    commit_changes( *s, buff, res, checked_cnt );
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::save_changes( const subscription &s, u_char *buff,
+    int max_size, u_int &checked_cnt ) const
+    {
+    checked_cnt = 0;
+    if ( max_size < C_HEADER_SIZE ) return 0;
+
+    u_int_2 count = 0;
+    int res = C_HEADER_SIZE;
+    u_int dev_cnt = s.devices.size();
+
+    //Проверка начинается с устройства, на котором остановилась предыдущая
+    //передача, - изменения не теряются при заполнении пакета.
+    for ( ; checked_cnt < dev_cnt && res + C_RECORD_SIZE <= max_size;
+        checked_cnt++ )
+        {
+        u_int i = ( s.next_pos + checked_cnt ) % dev_cnt;
+        auto &item = s.devices[ i ];
+        auto dev = G_DEVICE_MANAGER()->get_device( item.dev_n );
+
+        int_4 state = dev->get_state();
+        float value = dev->get_value();
+
+        if ( item.is_sent && state == item.state &&
+            fabs( value - item.value ) <= s.deadband )
+            {
+            continue;
+            }
+
+        u_int_2 idx = static_cast<u_int_2>( i );
+        memcpy( buff + res, &idx, sizeof( idx ) );
+        memcpy( buff + res + 2, &state, sizeof( state ) );
+        memcpy( buff + res + 6, &value, sizeof( value ) );
+        res += C_RECORD_SIZE;
+        count++;
+        }
+
+    if ( 0 == count ) return 0;
+
+    u_int_2 sub_id = static_cast<u_int_2>( s.id );
+    memcpy( buff, &sub_id, sizeof( sub_id ) );
+    memcpy( buff + 2, &count, sizeof( count ) );
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+void subscription_manager::commit_changes( subscription &s, const u_char *buff,
+    int size, u_int checked_cnt )
+    {
+    for ( int pos = C_HEADER_SIZE; pos + C_RECORD_SIZE <= size;
+        pos += C_RECORD_SIZE )
+        {
+        u_int_2 idx = 0;
+        memcpy( &idx, buff + pos, sizeof( idx ) );
+
+        auto &item = s.devices[ idx ];
+        memcpy( &item.state, buff + pos + 2, sizeof( item.state ) );
+        memcpy( &item.value, buff + pos + 6, sizeof( item.value ) );
+        item.is_sent = true;
+        }
+
+    u_int dev_cnt = s.devices.size();
+    s.is_pending = checked_cnt < dev_cnt;
+    if ( dev_cnt > 0 ) s.next_pos = ( s.next_pos + checked_cnt ) % dev_cnt;
+    }
+//-----------------------------------------------------------------------------
+int subscription_manager::push_cancel( const subscription &s )
+    {
+    u_char buff[ C_HEADER_SIZE ] = { 0 };
+    u_int_2 sub_id = static_cast<u_int_2>( s.id );
+    memcpy( buff, &sub_id, sizeof( sub_id ) );
+
+    return G_CMMCTR->push_data( s.socket, buff, sizeof( buff ) );
+    }
+//-----------------------------------------------------------------------------
+void subscription_manager::evaluate()
+    {
+    if ( subscriptions.empty() ) return;
+
+    static u_char buff[ tcp_communicator::C_MAX_PUSH_SIZE ];
+
+    for ( u_int i = 0; i < subscriptions.size(); )
+        {
+        auto &s = subscriptions[ i ];
+        //При ошибке передачи подписка может быть удалена.
+        int skt = s.socket;
+        if ( s.is_cancelled )
+            {
+            int res = push_cancel( s );
+            if ( res < 0 )
+                {
+                remove_client( skt );
+                }
+            else if ( 0 == res )
+                {
+                subscriptions.erase( subscriptions.begin() + i );
+                }
+            else
+                {
+                i++; //Сокет занят - повторяем в следующем цикле.
+                }
+            continue;
+            }
+
+        if ( !s.is_pending &&
+            get_delta_millisec( s.last_push_time ) < s.min_interval )
+            {
+            i++;
+            continue;
+            }
+
+        u_int checked_cnt = 0;
+        int size = save_changes( s, buff, sizeof( buff ), checked_cnt );
+        int res = size > 0 ? G_CMMCTR->push_data( skt, buff, size ) : 0;
+        if ( res < 0 )
+            {
+            //Сокет закрыт при ошибке передачи, подписки клиента удалены
+            //через on_socket_close(). Если сокет не найден - удаляем здесь.
+            remove_client( skt );
+            continue;
+            }
+
+        //Если сокет занят, изменения не сохраняются и передаются в
+        //следующем цикле.
+        if ( 0 == res )
+            {
+            s.last_push_time = get_millisec();
+            commit_changes( s, buff, size, checked_cnt );
+            }
+
+        i++;
+        }
+    }
+//-----------------------------------------------------------------------------
+void subscription_manager::on_socket_close( int skt )
+    {
+    if ( instance.is_null() ) return;
+
+    instance->remove_client( skt );
+    }
+//-----------------------------------------------------------------------------
+void subscription_manager::on_devices_clear()
+    {
+    if ( instance.is_null() ) return;
+
+    for ( auto &s : instance->subscriptions )
+        {
+        s.devices.clear();
+        s.next_pos = 0;
+        s.is_cancelled = true;
+        }
+    }
+//-----------------------------------------------------------------------------
+long subscription_manager::subscription_service( long len, u_char *data,
+    u_char *outdata )
+    {
+    if ( len < 1 ) return 0;
+
+    const int MAX_ANSWER_SIZE = tcp_communicator::BUFSIZE - 10;
+    int skt = G_CMMCTR->get_active_socket();
+    long answer_size = 0;
+
+    switch ( data[ 0 ] )
+        {
+        case CMD_SUBSCRIBE:
+            {
+            const int PATTERN_POS = 8;
+            if ( len < PATTERN_POS )
+                {
+                answer_size = sprintf( ( char* ) outdata, "sub_id=-1\n" ) + 1;
+                break;
+                }
+
+            u_int_2 min_interval = 0;
+            float deadband = 0;
+            memcpy( &min_interval, data + 1, sizeof( min_interval ) );
+            memcpy( &deadband, data + 3, sizeof( deadband ) );
+            int dev_type = data[ 7 ];
+
+            char pattern[ device::C_MAX_NAME + 1 ] = "";
+            if ( len > PATTERN_POS )
+                {
+                int pattern_len = len - PATTERN_POS;
+                if ( pattern_len > device::C_MAX_NAME )
+                    {
+                    pattern_len = device::C_MAX_NAME;
+                    }
+                memcpy( pattern, data + PATTERN_POS, pattern_len );
+                pattern[ pattern_len ] = 0;
+                }
+
+            int id = G_SUBSCRIPTION_MANAGER->subscribe( skt, pattern, dev_type,
+                min_interval, deadband );
+            if ( id < 0 )
+                {
+                answer_size = sprintf( ( char* ) outdata, "sub_id=-1\n" ) + 1;
+                break;
+                }
+
+            answer_size = G_SUBSCRIPTION_MANAGER->save_devices( id,
+                ( char* ) outdata, MAX_ANSWER_SIZE );
+            answer_size++; // Учитываем завершающий \0.
+            break;
+            }
+
+        case CMD_UNSUBSCRIBE:
+            {
+            u_int_2 id = 0;
+            if ( len >= 3 ) memcpy( &id, data + 1, sizeof( id ) );
+
+            outdata[ 0 ] = G_SUBSCRIPTION_MANAGER->unsubscribe( skt, id );
+            outdata[ 1 ] = 0;
+            answer_size = 2;
+            break;
+            }
+
+        case CMD_UNSUBSCRIBE_ALL:
+            G_SUBSCRIPTION_MANAGER->remove_client( skt );
+
+            outdata[ 0 ] = 0;
+            outdata[ 1 ] = 0;
+            answer_size = 2;
+            break;
+        }
+
+    return answer_size;
+    }
+//-----------------------------------------------------------------------------
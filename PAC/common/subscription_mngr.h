@@ -0,0 +1,199 @@
+/// @file subscription_mngr.h
+/// @brief Подписка клиентов на изменения состояния устройств PAC.
+///
+/// Клиент (например, HMI) регистрирует набор устройств (по шаблону имени и/или
+/// типу) и минимальный интервал передачи. После каждого цикла PAC передает
+/// клиенту без запроса только изменившиеся устройства. Это заменяет
+/// периодический опрос @ref device_communicator::CMD_GET_DEVICES_STATES.
+///
+/// @par Формат запроса подписки (@ref subscription_manager::CMD_SUBSCRIBE):
+/// @code
+/// data[ 0 ]      - CMD_SUBSCRIBE.
+/// data[ 1..2 ]   - минимальный интервал передачи, мс (u_int_2).
+/// data[ 3..6 ]   - зона нечувствительности для аналоговых значений (float).
+/// data[ 7 ]      - тип устройств (device::DEVICE_TYPE), 0xFF - любой.
+/// data[ 8.. ]    - шаблон имени ('*', '?'), завершающийся \0.
+/// @endcode
+///
+/// @par Формат передаваемого пакета изменений:
+/// @code
+/// u_int_2 id;    - номер подписки.
+/// u_int_2 count; - количество записей.
+/// count * { u_int_2 idx; int_4 state; float value; }
+/// @endcode
+/// Здесь idx - порядковый номер устройства в списке, возвращенном в ответ на
+/// запрос подписки.
+///
+/// Если изменения не помещаются в один пакет, оставшиеся устройства
+/// передаются в следующем цикле (без учета минимального интервала).
+///
+/// Пакет с count = 0 означает отмену подписки - список устройств PAC
+/// изменился (перезагрузка описания проекта), клиенту необходимо
+/// подписаться заново.
+
+#ifndef SUBSCRIPTION_MNGR_H
+#define SUBSCRIPTION_MNGR_H
+
+#include <vector>
+
+#include "smart_ptr.h"
+#include "dtime.h"
+
+class device;
+//-----------------------------------------------------------------------------
+/// @brief Менеджер подписок на изменения состояния устройств.
+class subscription_manager
+    {
+    public:
+        enum CMD
+            {
+            CMD_SUBSCRIBE = 1,   ///< Создание подписки.
+            CMD_UNSUBSCRIBE,     ///< Удаление подписки.
+            CMD_UNSUBSCRIBE_ALL, ///< Удаление всех подписок клиента.
+            };
+
+        enum CONSTANTS
+            {
+            C_SERVICE_N = 2,            ///< Номер сервиса коммуникатора.
+
+            C_MAX_SUBSCRIPTIONS = 64,   ///< Максимальное количество подписок.
+            C_MAX_ID = 0xFFFF,          ///< Максимальный номер подписки.
+            C_MAX_DEVICES = 0x10000,    ///< Максимальное количество устройств подписки.
+            C_ANY_TYPE = 0xFF,          ///< Любой тип устройства.
+
+            C_HEADER_SIZE = 4,          ///< Размер заголовка пакета.
+            C_RECORD_SIZE = 10,         ///< Размер записи об устройстве.
+            };
+
+        /// @brief Получение единственного экземпляра класса.
+        static subscription_manager* get_instance();
+
+        /// @brief Сервис для работы с подписками.
+        static long subscription_service( long len, u_char *data,
+            u_char *outdata );
+
+        /// @brief Обработка закрытия сокета клиента.
+        static void on_socket_close( int skt );
+
+        /// @brief Обработка удаления устройств (перезагрузка описания
+        /// проекта).
+        ///
+        /// Номера устройств подписок становятся недействительными, поэтому
+        /// подписки отменяются (клиенту передается пакет отмены).
+        static void on_devices_clear();
+
+        /// @brief Передача изменений клиентам.
+        ///
+        /// Вызывается один раз за цикл, после обработки устройств.
+        void evaluate();
+
+        /// @brief Создание подписки.
+        ///
+        /// @param skt          - сокет клиента.
+        /// @param pattern      - шаблон имени устройств ('*', '?').
+        /// @param dev_type     - тип устройств (@ref C_ANY_TYPE - любой).
+        /// @param min_interval - минимальный интервал передачи, мс.
+        /// @param deadband     - зона нечувствительности значения.
+        ///
+        /// @return -1   - ошибка (превышено количество подписок).
+        /// @return >= 0 - номер подписки.
+        int subscribe( int skt, const char *pattern, int dev_type,
+            u_int min_interval, float deadband );
+
+        /// @brief Удаление подписки.
+        ///
+        /// @return 0 - ок.
+        /// @return 1 - подписка не найдена.
+        int unsubscribe( int skt, int id );
+
+        /// @brief Удаление всех подписок клиента.
+        void remove_client( int skt );
+
+        /// @brief Получение количества подписок.
+        size_t get_subscriptions_count() const;
+
+        /// @brief Получение количества устройств подписки.
+        ///
+        /// @return -1   - подписка не найдена.
+        /// @return >= 0 - количество устройств.
+        int get_devices_count( int id ) const;
+
+        /// @brief Сохранение списка устройств подписки в виде скрипта Lua.
+        ///
+        /// @return размер записанных данных.
+        int save_devices( int id, char *buff, int max_size ) const;
+
+        /// @brief Формирование пакета изменений подписки.
+        ///
+        /// Состояния записанных в пакет устройств считаются переданными.
+        ///
+        /// @param id           - номер подписки.
+        /// @param buff [ out ] - буфер для записи пакета.
+        /// @param max_size     - размер буфера.
+        ///
+        /// @return 0   - изменений нет.
+        /// @return > 0 - размер пакета.
+        int save_changes( int id, u_char *buff, int max_size );
+
+        /// @brief Проверка соответствия имени шаблону.
+        ///
+        /// Поддерживаются символы '*' (любая последовательность) и '?'
+        /// (любой символ).
+        static bool is_match( const char *pattern, const char *name );
+
+        /// @brief Удаление всех подписок.
+        void clear();
+
+    private:
+        /// @brief Последнее переданное состояние устройства.
+        struct dev_state
+            {
+            u_int dev_n;    ///< Номер устройства в менеджере устройств.
+            int   state;
+            float value;
+            bool  is_sent;  ///< Состояние передавалось клиенту.
+            };
+
+        struct subscription
+            {
+            int    id;
+            int    socket;
+            u_int  min_interval;
+            float  deadband;
+            u_long last_push_time;
+            u_int  next_pos;        ///< Устройство, с которого начинается пакет.
+            bool   is_pending;      ///< Не все изменения поместились в пакет.
+            bool   is_cancelled;    ///< Подписка отменена (удалены устройства).
+
+            std::vector< dev_state > devices;
+            };
+
+        subscription* get_subscription( int id );
+        const subscription* get_subscription( int id ) const;
+
+        /// @brief Формирование пакета изменений без изменения сохраненных
+        /// состояний.
+        ///
+        /// @param checked_cnt [ out ] - количество проверенных устройств.
+        int save_changes( const subscription &s, u_char *buff, int max_size,
+            u_int &checked_cnt ) const;
+
+        /// @brief Сохранение состояний устройств переданного пакета.
+        void commit_changes( subscription &s, const u_char *buff, int size,
+            u_int checked_cnt );
+
+        /// @brief Передача пакета отмены подписки.
+        ///
+        /// @return результат @ref tcp_communicator::push_data.
+        int push_cancel( const subscription &s );
+
+        std::vector< subscription > subscriptions;
+
+        int last_id = 0;
+
+        static auto_smart_ptr < subscription_manager > instance;
+    };
+//-----------------------------------------------------------------------------
+#define G_SUBSCRIPTION_MANAGER subscription_manager::get_instance()
+//-----------------------------------------------------------------------------
+#endif // SUBSCRIPTION_MNGR_H
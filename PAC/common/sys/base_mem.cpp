@@ -118,8 +118,8 @@ NV_memory_manager::NV_memory_manager() : PAC_NVRAM( 0 ),
 #endif // WIN_OS
 
 #if defined LINUX_OS && defined PAC_PC
-    PAC_NVRAM  = new SRAM( "./nvram.txt", EEPROM_SIZE, 0, NVRAM_SIZE - 1 );
-    PAC_EEPROM = new SRAM( "./nvram.txt", EEPROM_SIZE, NVRAM_SIZE, EEPROM_SIZE - 1 );
+    PAC_NVRAM  = new mapped_SRAM( "./nvram.txt", EEPROM_SIZE, 0, NVRAM_SIZE - 1 );
+    PAC_EEPROM = new mapped_SRAM( "./nvram.txt", EEPROM_SIZE, NVRAM_SIZE, EEPROM_SIZE - 1 );
 #endif
 
 #if defined LINUX_OS && defined PAC_WAGO_750_860
@@ -134,8 +134,8 @@ NV_memory_manager::NV_memory_manager() : PAC_NVRAM( 0 ),
 
 #if defined LINUX_OS && defined PAC_PLCNEXT
 #ifdef PAC_PLCNEXT_ALONE
-    PAC_NVRAM  = new SRAM( "./nvram.txt", EEPROM_SIZE, 0, NVRAM_SIZE - 1 );
-    PAC_EEPROM = new SRAM( "./nvram.txt", EEPROM_SIZE, NVRAM_SIZE, EEPROM_SIZE - 1 );
+    PAC_NVRAM  = new mapped_SRAM( "./nvram.txt", EEPROM_SIZE, 0, NVRAM_SIZE - 1 );
+    PAC_EEPROM = new mapped_SRAM( "./nvram.txt", EEPROM_SIZE, NVRAM_SIZE, EEPROM_SIZE - 1 );
 #else
     PAC_NVRAM  = new eeprom_PLCnext( EEPROM_SIZE, 0, NVRAM_SIZE - 1 );
     PAC_EEPROM = new eeprom_PLCnext( EEPROM_SIZE, NVRAM_SIZE, EEPROM_SIZE - 1 );
@@ -114,6 +114,12 @@ class memory_range: public i_memory
     {
     friend class NV_memory_manager;
 
+    // Friendly класс предназначен только для тестирования
+    // и не должен использоваться в других целях
+#ifdef PTUSA_TEST
+    friend class test_params_manager;
+#endif
+
     public:
         /// @brief Метод интерфейса @ref i_memory.
         u_int get_size() const
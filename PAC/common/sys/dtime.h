@@ -46,6 +46,21 @@ u_long get_millisec();
 /// @return Разность времени в миллисекундах.
 u_long get_delta_millisec( u_long time1 );
 //-----------------------------------------------------------------------------
+/// @brief Получение времени в микросекундах.
+///
+/// Используется для измерения коротких интервалов (сбор статистики).
+/// Переполнение происходит значительно чаще, чем у @ref get_millisec, поэтому
+/// для вычисления разности времени использовать @ref get_delta_microsec.
+///
+/// @return Время с момента запуска программы в микросекундах.
+u_long get_microsec();
+//-----------------------------------------------------------------------------
+/// @brief Получение разности времени в микросекундах.
+///
+/// @param time1     - начальное время.
+/// @return Разность времени в микросекундах.
+u_long get_delta_microsec( u_long time1 );
+//-----------------------------------------------------------------------------
 /// @brief Ожидание заданное время.
 ///
 /// @param ms - время ожидания, мс.
@@ -2,8 +2,12 @@
 #error You must define OS!
 #endif
 
+#include <string.h>
+#include <algorithm>
+
 #include "tcp_cmctr.h"
 #include "tcp_client.h"
+#include "cmctr_metrics.h"
 
 #ifdef WIN_OS
 #include "w_tcp_cmctr.h"
@@ -16,11 +20,15 @@
 auto_smart_ptr < tcp_communicator > tcp_communicator::instance = 0;
 int tcp_communicator::port = 10000;
 int tcp_communicator::port_modbus = 10502;
+bool tcp_communicator::use_zerocopy = true;
+u_int tcp_communicator::zerocopy_min_size = C_ZEROCOPY_MIN_SIZE;
+request_limiter tcp_communicator::limiter;
 #ifdef PTUSA_TEST
 bool tcp_communicator::is_init = false;
 #endif //PTUSA_TEST
 //------------------------------------------------------------------------------
-tcp_communicator::tcp_communicator(): in_buffer_count( 0 ), pidx( 0 ), net_id( 0 )
+tcp_communicator::tcp_communicator(): in_buffer_count( 0 ), pidx( 0 ), net_id( 0 ),
+    active_socket( -1 ), ready_time( 0 )
     {
     max_cycles          = 10;
     glob_cmctr_ok       = 1;
@@ -43,6 +51,140 @@ tcp_communicator::srv_ptr tcp_communicator::reg_service( u_char srv_id,
         }
     }
 //------------------------------------------------------------------------------
+void tcp_communicator::reg_close_handler( close_ptr fk )
+    {
+    if ( fk && std::find( close_handlers.begin(), close_handlers.end(), fk ) ==
+        close_handlers.end() )
+        {
+        close_handlers.push_back( fk );
+        }
+    }
+//------------------------------------------------------------------------------
+void tcp_communicator::on_client_close( int skt )
+    {
+    limiter.remove_client( skt );
+
+    for ( auto fk : close_handlers )
+        {
+        fk( skt );
+        }
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator::push_data( int skt, const u_char *data, u_int len )
+    {
+    if ( len > C_MAX_PUSH_SIZE || len + 5 > BUFSIZE )
+        {
+        return -1;
+        }
+
+    buf[ 0 ] = 's';
+    buf[ 1 ] = FRAME_PUSH;
+    buf[ 2 ] = 0;
+    buf[ 3 ] = ( len >> 8 ) & 0xFF;
+    buf[ 4 ] = len & 0xFF;
+    memcpy( buf + 5, data, len );
+
+    return send_to_client( skt, buf, len + 5 );
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator::send_to_client( int /*skt*/, u_char* /*data*/,
+    int /*len*/ )
+    {
+    return -1;
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator::add_response_segment( const u_char *data, u_int size )
+    {
+    if ( active_socket < 0 || segments.size() >= C_MAX_SEGMENTS ) return 1;
+
+    segments.push_back( { data, size } );
+    return 0;
+    }
+//------------------------------------------------------------------------------
+u_int tcp_communicator::get_segments_size() const
+    {
+    u_int size = 0;
+    for ( const auto &s : segments )
+        {
+        size += s.size;
+        }
+
+    return size;
+    }
+//------------------------------------------------------------------------------
+long tcp_communicator::exec_service( int skt )
+    {
+    u_char srv_id = buf[ 1 ];
+    u_int len = buf[ 4 ] * 256 + buf[ 5 ];
+    segments.clear();
+
+    u_int retry_after = 0;
+    long res = 0;
+    switch ( limiter.check( skt, srv_id, buf + 6, len, retry_after ) )
+        {
+        case request_limiter::CHECK_BUSY:
+            G_CMMCTR_METRICS->add_limited_request( srv_id, false );
+            _BusyAkn( retry_after );
+            return 0;
+
+        case request_limiter::CHECK_CACHED:
+            {
+            //Сохраненный ответ может включать сегменты и быть больше буфера,
+            //поэтому он передается сегментом (без копирования в буфер).
+            u_int size = 0;
+            const u_char *data = limiter.get_cached_response( skt, size );
+            segments.push_back( { data, size } );
+            res = size;
+
+            G_CMMCTR_METRICS->add_limited_request( srv_id, true );
+            break;
+            }
+
+        case request_limiter::CHECK_OK:
+            active_socket = skt;
+            G_CMMCTR_METRICS->start_request( srv_id,
+                get_delta_microsec( ready_time ) );
+            res = services[ srv_id ]( len, buf + 6, buf + 5 );
+            G_CMMCTR_METRICS->end_request( len, res );
+            active_socket = -1;
+
+            limiter.save_response( skt, buf + 5, res - get_segments_size() );
+            for ( const auto &s : segments )
+                {
+                limiter.append_response( skt, s.data, s.size );
+                }
+            break;
+        }
+
+    if ( res == 0 )
+        {
+        _AknOK();
+        }
+    else
+        {
+        _AknData( res );
+        //В буфере только данные, записанные сервисом, без сегментов.
+        in_buffer_count -= get_segments_size();
+        }
+
+    return res;
+    }
+//------------------------------------------------------------------------------
+void tcp_communicator::_BusyAkn( u_int retry_after )
+    {
+    if ( retry_after > 0xFFFF ) retry_after = 0xFFFF;
+
+    buf[ 0 ] = net_id;
+    buf[ 1 ] = AKN_ERR;
+    buf[ 2 ] = pidx;
+    buf[ 3 ] = 0;
+    buf[ 4 ] = 3;
+    buf[ 5 ] = ERR_BUSY;
+    buf[ 6 ] = ( retry_after >> 8 ) & 0xFF;
+    buf[ 7 ] = retry_after & 0xFF;
+    in_buffer_count = 8;
+    }
+//------------------------------------------------------------------------------
 void tcp_communicator::_ErrorAkn( u_char error )
     {
     buf[ 0 ] = net_id;
@@ -16,8 +16,10 @@
 
 #include <stdio.h>
 #include <map>
+#include <vector>
 
 #include "smart_ptr.h"
+#include "cmctr_limiter.h"
 
 class tcp_client;
 
@@ -35,6 +37,10 @@ class tcp_communicator
         typedef long int srv_proc( long int, u_char *, u_char * );
         typedef srv_proc *srv_ptr;
 
+        /// @brief Определение функции обработки закрытия сокета клиента.
+        typedef void close_proc( int );
+        typedef close_proc *close_ptr;
+
         /// @brief Получение единственного экземпляра класса для работы с
         /// коммуникатором.
         ///
@@ -58,6 +64,78 @@ class tcp_communicator
         /// @param fk     - указатель на объект выделенного блока памяти.
         virtual srv_ptr reg_service( u_char srv_id, srv_ptr fk );
 
+        /// @brief Добавление функции, вызываемой при закрытии сокета клиента.
+        ///
+        /// Используется сервисами, хранящими состояние для отдельных
+        /// клиентов (например, подписки на изменения устройств).
+        ///
+        /// @param fk - указатель на функцию.
+        virtual void reg_close_handler( close_ptr fk );
+
+        /// @brief Получение сокета клиента, запрос которого обрабатывается
+        /// в данный момент.
+        ///
+        /// @return -1   - нет обрабатываемого запроса.
+        /// @return >= 0 - сокет клиента.
+        int get_active_socket() const
+            {
+            return active_socket;
+            }
+
+        /// @brief Передача клиенту данных без запроса с его стороны.
+        ///
+        /// Данные передаются в кадре @ref FRAME_PUSH.
+        ///
+        /// @param skt  - сокет клиента.
+        /// @param data - данные.
+        /// @param len  - размер данных.
+        ///
+        /// @return < 0 - ошибка передачи.
+        /// @return 0   - ок.
+        /// @return 1   - сокет занят, данные не переданы (передачу следует
+        /// повторить позже).
+        int push_data( int skt, const u_char *data, u_int len );
+
+        /// @brief Добавление к ответу сегмента данных, передаваемого без
+        /// копирования в буфер коммуникатора.
+        ///
+        /// Вызывается сервисом при обработке запроса. Сегменты передаются
+        /// после данных, записанных сервисом в буфер ответа, а их размер
+        /// должен входить в возвращаемый сервисом размер ответа. Данные
+        /// сегмента должны оставаться неизменными до завершения передачи
+        /// (до следующего запроса).
+        ///
+        /// @param data - данные.
+        /// @param size - размер данных.
+        ///
+        /// @return 0 - ок.
+        /// @return 1 - нет обрабатываемого запроса, данные необходимо
+        /// скопировать в буфер ответа.
+        int add_response_segment( const u_char *data, u_int size );
+
+        /// @brief Включение передачи больших ответов без копирования в
+        /// буфер ядра (MSG_ZEROCOPY, только Linux).
+        ///
+        /// Используется только для сокетов, для которых ядро поддерживает
+        /// такую передачу. Действует для новых соединений.
+        ///
+        /// @param is_on    - признак включения.
+        /// @param min_size - минимальный размер ответа для такой передачи.
+        static void set_zerocopy( bool is_on,
+            u_int min_size = C_ZEROCOPY_MIN_SIZE )
+            {
+            use_zerocopy = is_on;
+            zerocopy_min_size = min_size;
+            }
+
+        /// @brief Получение ограничителя частоты запросов клиентов.
+        ///
+        /// Ограничения можно задавать до создания коммуникатора.
+        static request_limiter& get_limiter()
+            {
+            return limiter;
+            }
+
         /// @brief Получение сетевого имени PAC.
         ///
         /// @return - сетевое имя PAC на русском языке.
@@ -93,12 +171,20 @@ class tcp_communicator
 
             TC_MAX_HOST_NAME      = 70,
             TC_MAX_SERVICE_NUMBER = 16,
+
+            C_MAX_PUSH_SIZE = 0xFFFF,      ///< Максимальный размер данных кадра без запроса.
+
+            C_MAX_SEGMENTS = 8,            ///< Максимальное количество сегментов ответа.
+            C_ZEROCOPY_MIN_SIZE = 16 * 1024, ///< Минимальный размер ответа для MSG_ZEROCOPY.
             };
 
     protected:
         static int port;                  ///< Порт.
         static int port_modbus;
 
+        static bool  use_zerocopy;      ///< Передача без копирования в ядро.
+        static u_int zerocopy_min_size; ///< Минимальный размер для нее.
+
         tcp_communicator();
 
         //ERRORS DEFINITION
@@ -108,6 +194,8 @@ class tcp_communicator
             ERR_WRONG_SERVICE = 3,
             ERR_TRANSMIT      = 4,
             ERR_WRONG_CMD     = 5,
+            ERR_BUSY          = 6, ///< Превышена частота запросов (только
+                                   ///< при заданных ограничениях).
             };
 
         //COMMANDS DEFINITION
@@ -117,6 +205,7 @@ class tcp_communicator
             AKN_ERR      = 7,
             AKN_DATA     = 8,
             AKN_OK       = 12,
+            FRAME_PUSH   = 13, ///< Данные, передаваемые PAC без запроса.
             };
 
         static auto_smart_ptr < tcp_communicator > instance;///< Экземпляр класса.
@@ -137,7 +226,58 @@ class tcp_communicator
 
         std::map<int, tcp_client*> *clients;
 
+        int active_socket;      ///< Сокет обрабатываемого запроса.
+        u_long ready_time;      ///< Время обнаружения данных на сокетах, мкс.
+
+        /// Функции, вызываемые при закрытии сокета клиента.
+        std::vector< close_ptr > close_handlers;
+
+        /// @brief Отправка данных клиенту.
+        ///
+        /// @param skt  - сокет клиента.
+        /// @param data - данные.
+        /// @param len  - размер данных.
+        ///
+        /// Передача не должна блокировать основной цикл.
+        ///
+        /// @return < 0 - ошибка передачи.
+        /// @return 0   - ок.
+        /// @return 1   - сокет занят, данные не переданы.
+        virtual int send_to_client( int skt, u_char *data, int len );
+
+        /// @brief Оповещение сервисов о закрытии сокета клиента.
+        void on_client_close( int skt );
+
+        static request_limiter limiter; ///< Ограничитель частоты запросов.
+
+        /// @brief Сегмент ответа, передаваемый без копирования в буфер.
+        struct segment
+            {
+            const u_char *data;
+            u_int size;
+            };
+        std::vector< segment > segments; ///< Сегменты текущего ответа.
+
+        /// @brief Получение общего размера сегментов ответа.
+        u_int get_segments_size() const;
+
+        /// @brief Выполнение запроса к сервису (кадр @ref FRAME_SINGLE).
+        ///
+        /// Запрос находится в буфере @ref buf, туда же записывается ответ с
+        /// заголовком. Учитываются ограничения частоты запросов клиента и
+        /// собирается статистика.
+        ///
+        /// @param skt - сокет клиента.
+        ///
+        /// @return размер данных ответа (без заголовка).
+        long exec_service( int skt );
+
         void _ErrorAkn( u_char error );
+
+        /// @brief Ответ "занято" (@ref ERR_BUSY).
+        ///
+        /// @param retry_after - через сколько мс можно повторить запрос.
+        void _BusyAkn( u_int retry_after );
         void _AknData( u_long len );
         void _AknOK();
     };
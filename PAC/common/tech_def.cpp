@@ -7,11 +7,24 @@
 #include "lua_manager.h"
 
 #include "g_errors.h"
+
+#include "log.h"
 //-----------------------------------------------------------------------------
 auto_smart_ptr < tech_object_manager > tech_object_manager::instance;
 
 char i_tech_object::white_spaces[ 256 ] = "";
 //-----------------------------------------------------------------------------
+/// Имена необязательных функций объекта (tech_object::LUA_HOOK).
+static const char* LUA_HOOKS_NAMES[ tech_object::LH_CNT ] =
+    {
+    "check_on_start",
+    "check_on_pause",
+    "check_on_stop",
+    "check_on_mode",
+    "user_check_operation_on",
+    "get_run_step_after_pause",
+    };
+//-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 tech_object::tech_object( const char* new_name, u_int number, u_int type,
     const char *name_Lua,
@@ -29,6 +42,8 @@ tech_object::tech_object( const char* new_name, u_int number, u_int type,
         type( type ),
         cmd( 0 ),
         operations_count( operations_count ),
+        lua_hooks( 0 ),
+        lua_hooks_version( 0 ),
         operations_manager( 0 )
     {
     u_int state_size_in_int4 = operations_count / 32; // Размер состояния в double word.
@@ -323,9 +338,12 @@ int tech_object::check_on_mode( u_int operation, char* reason, int max_len )
 //-----------------------------------------------------------------------------
 int tech_object::evaluate()
     {
-    for ( u_int i = 0; i < operations_count; i++ )
+    //Выполняются только операции, которым есть что делать (операции в
+    //простое без действий пропускаются).
+    for ( u_int idx = operations_manager->get_next_evaluated_operation( 0 );
+        idx > 0 && idx <= operations_count;
+        idx = operations_manager->get_next_evaluated_operation( idx ) )
         {
-        int idx = i + 1;
         auto op = ( *operations_manager )[ idx ];
         op->evaluate();
 
@@ -393,17 +411,7 @@ int tech_object::lua_check_function( const char* function_name,
     const char* comment, u_int mode, bool show_error )
     {
     //Проверка на наличии функции function_name
-    lua_getfield( lua_manager::get_instance()->get_Lua(), LUA_GLOBALSINDEX,
-        name_Lua );
-    if ( lua_isnoneornil( lua_manager::get_instance()->get_Lua(), -1 ) )
-        {
-        lua_remove( lua_manager::get_instance()->get_Lua(), -1 );
-        return 0;
-        }
-    lua_getfield( lua_manager::get_instance()->get_Lua(), -1, function_name );
-    lua_remove( lua_manager::get_instance()->get_Lua(), -2 );
-
-    if ( lua_isfunction( lua_manager::get_instance()->get_Lua(), -1 ) )
+    if ( G_LUA_MANAGER->is_exist_lua_function( name_Lua, function_name ) )
         {
         return lua_manager::get_instance()->int_2_exec_lua_method( name_Lua,
             function_name, mode, show_error ? 1 : 0, comment );
@@ -412,13 +420,46 @@ int tech_object::lua_check_function( const char* function_name,
     return 0;
     }
 //-----------------------------------------------------------------------------
+int tech_object::lua_check_function( LUA_HOOK hook, const char* comment,
+    u_int mode, bool show_error )
+    {
+    if ( !is_lua_hook_exist( hook ) ) return 0;
+
+    return lua_manager::get_instance()->int_2_exec_lua_method( name_Lua,
+        LUA_HOOKS_NAMES[ hook ], mode, show_error ? 1 : 0, comment );
+    }
+//-----------------------------------------------------------------------------
+bool tech_object::is_lua_hook_exist( LUA_HOOK hook ) const
+    {
+    if ( lua_hooks_version != G_LUA_MANAGER->get_functions_cache_version() )
+        {
+        update_lua_hooks();
+        }
+
+    return ( lua_hooks & ( 1u << hook ) ) != 0;
+    }
+//-----------------------------------------------------------------------------
+void tech_object::update_lua_hooks() const
+    {
+    lua_hooks = 0;
+    for ( int i = 0; i < LH_CNT; i++ )
+        {
+        if ( G_LUA_MANAGER->is_exist_lua_function( name_Lua,
+            LUA_HOOKS_NAMES[ i ] ) )
+            {
+            lua_hooks |= 1u << i;
+            }
+        }
+
+    lua_hooks_version = G_LUA_MANAGER->get_functions_cache_version();
+    }
+//-----------------------------------------------------------------------------
 int tech_object::lua_get_run_step_after_pause( u_int mode ) const
     {
-    auto function_name = "get_run_step_after_pause";
-    if ( G_LUA_MANAGER->is_exist_lua_function( name_Lua, function_name ) )
+    if ( is_lua_hook_exist( LH_GET_RUN_STEP_AFTER_PAUSE ) )
         {
         return G_LUA_MANAGER->int_exec_lua_method( name_Lua,
-            function_name, mode,
+            LUA_HOOKS_NAMES[ LH_GET_RUN_STEP_AFTER_PAUSE ], mode,
             "int tech_object::lua_get_run_step_after_pause( u_int mode )" );
         }
 
@@ -427,19 +468,19 @@ int tech_object::lua_get_run_step_after_pause( u_int mode ) const
 //-----------------------------------------------------------------------------
 int tech_object::lua_check_on_start( u_int mode, bool show_error )
     {
-    return lua_check_function( "check_on_start",
+    return lua_check_function( LH_CHECK_ON_START,
         "int tech_object::check_on_start( u_int mode )", mode, show_error );
     }
 //-----------------------------------------------------------------------------
 int tech_object::lua_check_on_pause( u_int mode, bool show_error )
     {
-    return lua_check_function( "check_on_pause",
+    return lua_check_function( LH_CHECK_ON_PAUSE,
         "int tech_object::check_on_pause( u_int mode )", mode, show_error );
     }
 //-----------------------------------------------------------------------------
 int tech_object::lua_check_on_stop( u_int mode, bool show_error )
     {
-    return lua_check_function( "check_on_stop",
+    return lua_check_function( LH_CHECK_ON_STOP,
         "int tech_object::check_on_stop( u_int mode )", mode, show_error );
     }
 //-----------------------------------------------------------------------------
@@ -542,24 +583,16 @@ int tech_object::lua_check_on_mode( u_int mode, bool show_error )
 
     //TODO. Устаревшее название функции. Оставлено для совместимости.
     //Проверка на наличии функции check_on_mode.
-    auto old_function_name = "check_on_mode";
-    if ( G_LUA_MANAGER->is_exist_lua_function( name_Lua, old_function_name ) )
+    if ( is_lua_hook_exist( LH_CHECK_ON_MODE ) )
         {
-        return lua_manager::get_instance()->int_2_exec_lua_method( name_Lua,
-            old_function_name, mode, show_error ? 1 : 0,
-            "int tech_object::lua_check_on_mode( u_int mode )" );
+        return lua_check_function( LH_CHECK_ON_MODE,
+            "int tech_object::lua_check_on_mode( u_int mode )", mode,
+            show_error );
         }
 
     //Проверка на наличии функции user_check_operation_on.
-    auto new_function_name = "user_check_operation_on";
-    if ( G_LUA_MANAGER->is_exist_lua_function( name_Lua, new_function_name ) )
-        {
-        return lua_manager::get_instance()->int_2_exec_lua_method( name_Lua,
-            new_function_name, mode, show_error ? 1 : 0,
-            "int tech_object::lua_check_on_mode( u_int mode )" );
-        }
-
-    return 0;
+    return lua_check_function( LH_USER_CHECK_OPERATION_ON,
+        "int tech_object::lua_check_on_mode( u_int mode )", mode, show_error );
     }
 //-----------------------------------------------------------------------------
 void tech_object::lua_init_mode( u_int mode )
@@ -1116,6 +1149,76 @@ int tech_object::save_params_as_Lua_str( char* str )
     return res;
     }
 //-----------------------------------------------------------------------------
+/// @brief Сохранение набора параметров в двоичном виде.
+///
+/// @return количество записанных байт, -1 - недостаточно места.
+template < class T > static int save_params_set_as_bin( char* buff,
+    int max_size, u_int_2 obj_n, u_char par_id, const T& par )
+    {
+    const int HEADER_SIZE = 5;
+    if ( HEADER_SIZE > max_size ) return -1;
+
+    u_int_2 cnt = par.get_count();
+    memcpy( buff, &obj_n, sizeof( obj_n ) );
+    buff[ 2 ] = par_id;
+    memcpy( buff + 3, &cnt, sizeof( cnt ) );
+
+    u_int size = par.save_bin( buff + HEADER_SIZE, max_size - HEADER_SIZE );
+    if ( 0 == size && cnt > 0 ) return -1;
+
+    return HEADER_SIZE + size;
+    }
+//-----------------------------------------------------------------------------
+int tech_object::save_params_as_bin( char* buff, int max_size ) const
+    {
+    int res = save_params_set_as_bin( buff, max_size, serial_idx,
+        ID_PAR_FLOAT, par_float );
+    if ( res < 0 ) return -1;
+
+    int size = save_params_set_as_bin( buff + res, max_size - res,
+        serial_idx, ID_RT_PAR_FLOAT, rt_par_float );
+    if ( size < 0 ) return -1;
+    res += size;
+
+    size = save_params_set_as_bin( buff + res, max_size - res,
+        serial_idx, ID_PAR_UINT, par_uint );
+    if ( size < 0 ) return -1;
+    res += size;
+
+    size = save_params_set_as_bin( buff + res, max_size - res,
+        serial_idx, ID_RT_PAR_UINT, rt_par_uint );
+    if ( size < 0 ) return -1;
+
+    return res + size;
+    }
+//-----------------------------------------------------------------------------
+int tech_object::set_params_bin( int par_id, const char* values, u_int count )
+    {
+    switch ( par_id )
+        {
+    case ID_PAR_FLOAT:
+        par_float.set_bin( values, count );
+        break;
+
+    case ID_RT_PAR_FLOAT:
+        rt_par_float.set_bin( values, count );
+        break;
+
+    case ID_PAR_UINT:
+        par_uint.set_bin( values, count );
+        break;
+
+    case ID_RT_PAR_UINT:
+        rt_par_uint.set_bin( values, count );
+        break;
+
+    default:
+        return 1;
+        }
+
+    return 0;
+    }
+//-----------------------------------------------------------------------------
 int tech_object::set_param( int par_id, int index, double value )
     {
     switch ( par_id )
@@ -1508,6 +1611,9 @@ u_int tech_object_manager::get_count() const
 int tech_object_manager::evaluate()
     {
     int res = 0;
+    //Объекты вычисляются последовательно в основном потоке - вычисление
+    //объекта не потокобезопасно (обработчики Lua вызываются в общем
+    //lua_State, общий буфер G_LOG->msg, очередь valve::to_switch_off).
     for ( u_int i = 0; i < tech_objects.size(); i++ )
         {
         tech_objects.at( i )->evaluate();
@@ -1553,9 +1659,25 @@ int tech_object_manager::init_objects()
         }
     lua_remove( lua_manager::get_instance()->get_Lua(), -1 ); // stack: init
 
+    //Функции объектов определены - определяем наличие необязательных.
+    update_lua_hooks();
+    for ( auto obj : tech_objects )
+        {
+        //Действия операций заданы - обновляем выполняемые операции.
+        obj->get_modes_manager()->set_evaluated_operations_changed();
+        }
+
     return 0;
     }
 //-----------------------------------------------------------------------------
+void tech_object_manager::update_lua_hooks() const
+    {
+    for ( auto obj : tech_objects )
+        {
+        obj->update_lua_hooks();
+        }
+    }
+//-----------------------------------------------------------------------------
 tech_object_manager::~tech_object_manager()
     {
     delete stub;
@@ -1594,6 +1716,62 @@ int tech_object_manager::save_params_as_Lua_str( char* str )
     return res;
     }
 //-----------------------------------------------------------------------------
+int tech_object_manager::save_params_as_bin( char* buff, int max_size ) const
+    {
+    int res = 0;
+    for ( u_int i = 0; i < tech_objects.size(); i++ )
+        {
+        int size = tech_objects[ i ]->save_params_as_bin( buff + res,
+            max_size - res );
+        if ( size < 0 ) return -1;
+
+        res += size;
+        }
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+int tech_object_manager::restore_params_from_bin( const char* data, int size )
+    {
+    const int HEADER_SIZE = 5;
+    const int VALUE_SIZE = 4;
+
+    //Проверка формата - до изменения параметров.
+    for ( int pass = 0; pass < 2; pass++ )
+        {
+        int pos = 0;
+        while ( pos < size )
+            {
+            if ( pos + HEADER_SIZE > size ) return 1;
+
+            u_int_2 obj_n = 0;
+            u_int_2 cnt = 0;
+            memcpy( &obj_n, data + pos, sizeof( obj_n ) );
+            u_char par_id = data[ pos + 2 ];
+            memcpy( &cnt, data + pos + 3, sizeof( cnt ) );
+            pos += HEADER_SIZE;
+
+            if ( pos + cnt * VALUE_SIZE > size ) return 1;
+            if ( 0 == obj_n || obj_n > tech_objects.size() )
+                {
+                if ( pass > 0 ) G_LOG->warning( "Binary params backup - object %u is not "
+                    "found (total %zu), skipped.", obj_n, tech_objects.size() );
+                }
+            else if ( pass > 0 )
+                {
+                tech_objects[ obj_n - 1 ]->set_params_bin( par_id, data + pos,
+                    cnt );
+                }
+            pos += cnt * VALUE_SIZE;
+            }
+        }
+
+    //Сохраняемые параметры всех объектов записываются один раз.
+    params_manager::get_instance()->save();
+
+    return 0;
+    }
+//-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 tech_object_manager* G_TECH_OBJECT_MNGR()
     {
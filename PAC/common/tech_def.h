@@ -181,6 +181,29 @@ class tech_object: public i_tech_object, public i_Lua_save_device,
 
         timer_manager           timers;         ///< Таймеры объекта.
 
+        /// @brief Необязательные функции объекта, реализуемые в Lua.
+        enum LUA_HOOK
+            {
+            LH_CHECK_ON_START = 0,
+            LH_CHECK_ON_PAUSE,
+            LH_CHECK_ON_STOP,
+            LH_CHECK_ON_MODE,           ///< Устаревшее название функции.
+            LH_USER_CHECK_OPERATION_ON,
+            LH_GET_RUN_STEP_AFTER_PAUSE,
+
+            LH_CNT
+            };
+
+        /// @brief Проверка наличия необязательной функции объекта в Lua.
+        ///
+        /// Наличие функций определяется при инициализации объектов и
+        /// повторно - после изменения функций Lua (сброса кэша функций,
+        /// см. @ref lua_manager::get_functions_cache_version).
+        bool is_lua_hook_exist( LUA_HOOK hook ) const;
+
+        /// @brief Определение наличия необязательных функций объекта в Lua.
+        void update_lua_hooks() const;
+
         // Lua implemented methods.
         int lua_exec_cmd( u_int cmd );
 
@@ -189,6 +212,8 @@ class tech_object: public i_tech_object, public i_Lua_save_device,
         // Check functions.
         int lua_check_function( const char* function_name, const char* comment,
             u_int mode, bool show_error );
+        int lua_check_function( LUA_HOOK hook, const char* comment,
+            u_int mode, bool show_error );
         int lua_check_on_start( u_int mode, bool show_error = true );
         int lua_check_on_pause( u_int mode, bool show_error = true );
         int lua_check_on_stop( u_int mode, bool show_error = true );
@@ -321,6 +346,28 @@ class tech_object: public i_tech_object, public i_Lua_save_device,
 
         int set_param( int par_id, int index, double value );
 
+        /// @brief Сохранение параметров в двоичном виде.
+        ///
+        /// Для каждого набора параметров: номер объекта (2 байта), номер
+        /// набора (@ref PARAMS_ID, 1 байт), количество значений (2 байта),
+        /// значения.
+        ///
+        /// @return количество записанных байт, -1 - недостаточно места.
+        int save_params_as_bin( char* buff, int max_size ) const;
+
+        /// @brief Задание значений набора параметров из двоичного вида.
+        ///
+        /// Значения только задаются, запись сохраняемых параметров в
+        /// энергонезависимую память выполняется вызывающим кодом
+        /// (@ref tech_object_manager::restore_params_from_bin).
+        ///
+        /// @param par_id - номер набора (@ref PARAMS_ID).
+        /// @param values - значения.
+        /// @param count  - количество значений.
+        ///
+        /// @return 0 - ок, 1 - неверный номер набора.
+        int set_params_bin( int par_id, const char* values, u_int count );
+
         /// @brief Установка последовательного номера объекта, начинается с 1.
         ///
         /// @param idx - последовательный номер, >= 1.
@@ -341,6 +388,9 @@ class tech_object: public i_tech_object, public i_Lua_save_device,
         char* full_name;   ///< Имя объекта + номер.
         char *name_Lua;    ///< Имя объекта в Lua.
 
+        mutable u_int lua_hooks;            ///< Наличие функций (LUA_HOOK).
+        mutable u_int lua_hooks_version;    ///< Версия кэша функций Lua.
+
         smart_ptr< operation_manager > operations_manager; ///< Шаги режимов.
 
         enum PARAMS_ID
@@ -396,6 +446,10 @@ class tech_object_manager
         /// @brief Инициализация объектов на основе скрипта описания Lua.
         virtual int init_objects();
 
+        /// @brief Определение наличия необязательных функций Lua всех
+        /// объектов (после изменения функций Lua).
+        void update_lua_hooks() const;
+
         virtual ~tech_object_manager();
 
         /// @brief Добавление технологического объекта.
@@ -403,6 +457,21 @@ class tech_object_manager
 
         int save_params_as_Lua_str( char* str );
 
+        /// @brief Сохранение параметров всех объектов в двоичном виде
+        /// (@ref tech_object::save_params_as_bin).
+        ///
+        /// @return количество записанных байт, -1 - недостаточно места.
+        int save_params_as_bin( char* buff, int max_size ) const;
+
+        /// @brief Восстановление параметров объектов из двоичного вида.
+        ///
+        /// Сначала проверяется формат всех наборов, затем задаются значения,
+        /// после чего сохраняемые параметры записываются в энергонезависимую
+        /// память одной операцией (@ref params_manager::save).
+        ///
+        /// @return 0 - ок, 1 - ошибка формата (параметры не изменяются).
+        int restore_params_from_bin( const char* data, int size );
+
         /// @brief Включен ли хотя бы один важный режим технологического объекта.
         bool is_any_important_mode()
             {
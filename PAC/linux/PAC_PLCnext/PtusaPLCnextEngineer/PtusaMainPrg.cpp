@@ -9,12 +9,17 @@
 
 #include "prj_mngr.h"
 #include "lua_manager.h"
+#include "lua_gc_mngr.h"
+#include "lua_hot_reload.h"
 
 #include "iot_common.h"
 #include "PAC_dev.h"
 #include "PAC_err.h"
+#include "alarm_history.h"
 #include "error.h"
 #include "tech_def.h"
+#include "subscription_mngr.h"
+#include "g_device.h"
 
 #ifdef OPCUA
 #include "OPCUAServer.h"
@@ -42,6 +47,12 @@ namespace PtusaPLCnextEngineer
 
             chdir( "/opt/main/" );
 
+            //-История тревог (сохраняется в файле).
+            G_ALARM_HISTORY->init( "/opt/main/alarm_history.bin" );
+
+            //-Ограничения частоты запросов чтения клиентов.
+            device_communicator::set_default_limits();
+
             int res = G_LUA_MANAGER->init( 0, "/opt/main/main.plua",
                 G_PROJECT_MANAGER->path.c_str(),
                 G_PROJECT_MANAGER->sys_path.c_str() );   //-Инициализация Lua.
@@ -86,8 +97,7 @@ namespace PtusaPLCnextEngineer
             cycles_cnt++;
 #endif // TEST_SPEED
 
-            const int LUA_GC_SIZE = 200;
-            lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCSTEP, LUA_GC_SIZE );
+            u_long cycle_start_time = get_millisec();
             sleep_ms( sleep_time_ms );
 
 #ifndef DEBUG_NO_WAGO_MODULES
@@ -109,6 +119,7 @@ namespace PtusaPLCnextEngineer
 #endif // ifndef
 
             G_CMMCTR->evaluate();
+            G_SUBSCRIPTION_MANAGER->evaluate();
 #ifdef OPCUA
             if ( G_PAC_INFO()->par[ PAC_info::P_IS_OPC_UA_SERVER_ACTIVE ] == 1 )
                 {
@@ -126,6 +137,15 @@ namespace PtusaPLCnextEngineer
             G_SIREN_LIGHTS_MANAGER()->eval();
             sleep_ms( sleep_time_ms );
 
+            G_LUA_HOT_RELOAD->evaluate();
+
+            //Отложенная запись параметров.
+            params_manager::get_instance()->evaluate();
+
+            //Сборка мусора Lua - в оставшееся время цикла.
+            G_LUA_GC_MANAGER->evaluate( G_LUA_MANAGER->get_Lua(),
+                cycle_start_time );
+
 #ifdef TEST_DEVICE_N
             auto dev_idx = TEST_DEVICE_N;
             auto dev = DEVICE( dev_idx );
@@ -194,6 +214,9 @@ namespace PtusaPLCnextEngineer
                     lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCCOUNT, 0 ) * KILOBYTE +
                     lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCCOUNTB, 0 ) );
                 G_LOG->write_log( i_log::P_INFO );
+                G_LUA_MANAGER->get_allocator().print_to_log();
+                G_LUA_GC_MANAGER->print_to_log();
+                G_LUA_GC_MANAGER->clear_stat();
 
                 all_time = 0;
                 cycles_cnt = 0;
@@ -204,6 +227,7 @@ namespace PtusaPLCnextEngineer
             //-Информация о времени выполнения цикла программы.!->
 #endif // TEST_SPEED
             }
+        params_manager::get_instance()->flush();
 
 #ifdef OPCUA
             G_OPCUA_SERVER.shutdown();
@@ -39,6 +39,20 @@ unsigned long get_delta_millisec( unsigned long time1 )
     return now >= time1 ? now - time1 : ULONG_MAX - time1 + now;
     }
 //-----------------------------------------------------------------------------
+unsigned long get_microsec()
+    {
+    timespec start_tv = {0, 0};
+    clock_gettime( CLOCK_MONOTONIC, &start_tv );
+
+    return 1000000UL * start_tv.tv_sec + start_tv.tv_nsec / 1000UL;
+    }
+//-----------------------------------------------------------------------------
+unsigned long get_delta_microsec( unsigned long time1 )
+    {
+    //Беззнаковая арифметика корректно обрабатывает переполнение.
+    return get_microsec() - time1;
+    }
+//-----------------------------------------------------------------------------
 void sleep_ms( unsigned int ms )
     {
     usleep( 1000 * ms );
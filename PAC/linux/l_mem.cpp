@@ -4,8 +4,10 @@
 #include <limits.h>
 #include <errno.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 
 #include "l_mem.h"
+#include "dtime.h"
 
 int SRAM::file = 0;
 //-----------------------------------------------------------------------------
@@ -108,6 +110,126 @@ int SRAM::write( void *buff, u_int count, u_int start_pos )
     }
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
+mapped_SRAM::mapped_SRAM( const char *file_name,
+    u_int total_size,
+    u_int available_start_pos,
+    u_int available_end_pos ) : NV_memory( total_size,
+        available_start_pos,
+        available_end_pos ),
+    data( nullptr ),
+    //Адрес в памяти - смещение относительно начального доступного адреса
+    //(аналогично SRAM).
+    data_size( available_start_pos + total_size ),
+    dirty_start( 0 ),
+    dirty_end( 0 )
+    {
+    int f = open( file_name, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR );
+    if ( f < 0 )
+        {
+        if ( G_DEBUG )
+            {
+            printf( "mapped_SRAM() - ERROR: Can't open device (%s) : %s.\n",
+                file_name, strerror( errno ) );
+            }
+        return;
+        }
+
+    //Файл должен быть не меньше отображаемой памяти.
+    struct stat st;
+    if ( fstat( f, &st ) == 0 && st.st_size < ( off_t ) data_size )
+        {
+        if ( ftruncate( f, data_size ) < 0 )
+            {
+            if ( G_DEBUG )
+                {
+                printf( "mapped_SRAM() - ERROR: Can't resize device (%s) : %s.\n",
+                    file_name, strerror( errno ) );
+                }
+            close( f );
+            return;
+            }
+        }
+
+    void *res = mmap( nullptr, data_size, PROT_READ | PROT_WRITE, MAP_SHARED,
+        f, 0 );
+    close( f );
+
+    if ( MAP_FAILED == res )
+        {
+        if ( G_DEBUG )
+            {
+            printf( "mapped_SRAM() - ERROR: Can't map device (%s) : %s.\n",
+                file_name, strerror( errno ) );
+            }
+        return;
+        }
+    data = static_cast< char* >( res );
+
+    //При инициализации память считывается целиком.
+    madvise( data, data_size, MADV_WILLNEED );
+    }
+//-----------------------------------------------------------------------------
+mapped_SRAM::~mapped_SRAM()
+    {
+    if ( data )
+        {
+        sync();
+        munmap( data, data_size );
+        data = nullptr;
+        }
+    }
+//-----------------------------------------------------------------------------
+int mapped_SRAM::read( void *buff, u_int count, u_int start_pos )
+    {
+    u_int pos = get_available_start_pos() + start_pos;
+    if ( nullptr == data || pos + count > data_size ) return -1;
+
+    memcpy( buff, data + pos, count );
+    return count;
+    }
+//-----------------------------------------------------------------------------
+int mapped_SRAM::write( void *buff, u_int count, u_int start_pos )
+    {
+    u_int pos = get_available_start_pos() + start_pos;
+    if ( nullptr == data || pos + count > data_size ) return -1;
+    if ( 0 == count ) return 0;
+
+    memcpy( data + pos, buff, count );
+
+    if ( 0 == dirty_end )
+        {
+        dirty_start = pos;
+        dirty_end = pos + count;
+        }
+    else
+        {
+        if ( pos < dirty_start ) dirty_start = pos;
+        if ( pos + count > dirty_end ) dirty_end = pos + count;
+        }
+
+    return count;
+    }
+//-----------------------------------------------------------------------------
+int mapped_SRAM::sync()
+    {
+    if ( nullptr == data || 0 == dirty_end ) return 0;
+
+    //Адрес для msync должен быть выровнен по границе страницы.
+    static const u_int PAGE_SIZE_ = sysconf( _SC_PAGESIZE );
+    u_int start = dirty_start - dirty_start % PAGE_SIZE_;
+
+    int res = msync( data + start, dirty_end - start, MS_SYNC );
+    if ( res < 0 && G_DEBUG )
+        {
+        printf( "mapped_SRAM::sync() - ERROR: %s.\n", strerror( errno ) );
+        }
+
+    dirty_start = 0;
+    dirty_end = 0;
+    return res;
+    }
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
 data_file::data_file() : f( 0 )
     {
     }
@@ -44,6 +44,48 @@ class SRAM: public NV_memory
         int write( void *buff, u_int count, u_int start_pos );
     };
 //-----------------------------------------------------------------------------
+/// @brief Работа с энергонезависимой ОЗУ, отображенной на файл (mmap).
+///
+/// Чтение и запись - копирование в отображенную память без системных
+/// вызовов. Измененные страницы записываются в файл ядром (как и при
+/// записи в файл через write). Принудительная синхронизация с ожиданием
+/// записи (msync с MS_SYNC) выполняется только при удалении объекта -
+/// вне основного цикла.
+class mapped_SRAM: public NV_memory
+    {
+    friend class NV_memory_manager;
+
+    // Friendly класс предназначен только для тестирования
+    // и не должен использоваться в других целях
+#ifdef PTUSA_TEST
+    friend class test_mapped_SRAM;
+#endif
+
+    public:
+        /// @brief Синхронизация измененной памяти с файлом с ожиданием
+        /// завершения записи.
+        ///
+        /// @return 0 - ок, -1 - ошибка.
+        int sync();
+
+    private:
+        mapped_SRAM( const char *file_name, u_int total_size,
+            u_int available_start_pos, u_int available_end_pos );
+        virtual ~mapped_SRAM();
+
+        /// @brief Метод интерфейса @ref i_memory.
+        int read( void *buff, u_int count, u_int start_pos );
+
+        /// @brief Метод интерфейса @ref i_memory.
+        int write( void *buff, u_int count, u_int start_pos );
+
+        char *data;         ///< Отображенная память (весь файл).
+        u_int data_size;    ///< Размер отображенной памяти.
+
+        u_int dirty_start;  ///< Начало измененной области.
+        u_int dirty_end;    ///< Конец измененной области (0 - нет изменений).
+    };
+//-----------------------------------------------------------------------------
 class data_file : public file
     {
     public:
@@ -5,6 +5,15 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
+#include <sys/uio.h>
+
+#ifdef MSG_ZEROCOPY
+#include <linux/errqueue.h>
+#if defined SO_ZEROCOPY && defined SO_EE_ORIGIN_ZEROCOPY
+#define USE_ZEROCOPY ///< Передача данных без копирования в буфер ядра.
+#endif
+#endif // MSG_ZEROCOPY
 
 #include "l_tcp_cmctr.h"
 #include "PAC_err.h"
@@ -51,6 +60,7 @@ void tcp_communicator_linux::killsockets()
             {
             shutdown( sst[ i ].socket, SHUT_RDWR );
             close( sst[ i ].socket );
+            on_client_close( sst[ i ].socket );
             }
         }
     sst.clear();
@@ -301,6 +311,16 @@ int tcp_communicator_linux::evaluate()
         }
     // Инициализация сети, при необходимости.-!>
 
+    // Передача остатков данных без запроса.
+    for ( u_int i = 0; i < sst.size(); )
+        {
+        if ( !sst[ i ].push_backlog.empty() && flush_push_backlog( i ) < 0 )
+            {
+            continue; // Сокет закрыт и удален из таблицы.
+            }
+        i++;
+        }
+
     int count_cycles = 0;
     int max_sock_number = 0;
     while ( count_cycles < max_cycles )
@@ -336,6 +356,10 @@ int tcp_communicator_linux::evaluate()
                 }
             }
 
+        // Уведомления о завершении передач также делают сокет готовым для
+        // чтения - обрабатываем уже полученные.
+        wait_zerocopy_completion( 0 );
+
         // Ждём события в одном из сокетов.
         rc = select( max_sock_number + 1, &rfds, NULL, NULL, &tv );
 
@@ -350,6 +374,7 @@ int tcp_communicator_linux::evaluate()
 
             continue;
             }
+        ready_time = get_microsec();
 
         for ( u_int i = 0; i < sst.size(); i++ )  /* scan all possible sockets */
             {
@@ -433,6 +458,14 @@ int tcp_communicator_linux::evaluate()
                     else
                         {
                         slave_socket_state.ismodbus = 0;
+#ifdef USE_ZEROCOPY
+                        // Большие ответы передаем без копирования, если
+                        // ядро поддерживает это для сокета.
+                        int one = 1;
+                        slave_socket_state.is_zerocopy = use_zerocopy &&
+                            0 == setsockopt( slave_socket, SOL_SOCKET,
+                            SO_ZEROCOPY, &one, sizeof( one ) );
+#endif // USE_ZEROCOPY
                         }
 
                     sst.push_back(slave_socket_state);
@@ -502,6 +535,14 @@ int tcp_communicator_linux::sendall (int sockfd, unsigned char *buf, int len,
     int sec, int usec, const char* IP, const char* name,
     stat_time *stat )
     {
+    iovec iov = { buf, ( size_t ) len };
+    return sendallv( sockfd, &iov, 1, sec, usec, IP, name, stat );
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator_linux::sendallv( int sockfd, iovec *iov, int iovcnt,
+    int sec, int usec, const char* IP, const char* name,
+    stat_time *stat, u_int *zerocopy_cnt )
+    {
     //Network performance info.
     if (stat)
         {
@@ -540,8 +581,18 @@ int tcp_communicator_linux::sendall (int sockfd, unsigned char *buf, int len,
             }
         }
 
+    int len = 0;
+    for ( int i = 0; i < iovcnt; i++ )
+        {
+        len += iov[ i ].iov_len;
+        }
+
+    int send_flags = MSG_NOSIGNAL;
+#ifdef USE_ZEROCOPY
+    if ( zerocopy_cnt ) send_flags |= MSG_ZEROCOPY;
+#endif // USE_ZEROCOPY
+
     int total_size = 0;
-    unsigned char *p = buf;
 
     // Настраиваем  file descriptor set.
     fd_set fds;
@@ -588,10 +639,20 @@ int tcp_communicator_linux::sendall (int sockfd, unsigned char *buf, int len,
             return -1; // error
             }
 
-        int n = 0;
-
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iovcnt;
 
-        if ( ( n = send( sockfd, p, i, MSG_NOSIGNAL ) ) < 0 )
+        int n = 0;
+        if ( ( n = sendmsg( sockfd, &msg, send_flags ) ) < 0 &&
+            ENOBUFS == errno && send_flags != MSG_NOSIGNAL )
+            {
+            //Превышен лимит памяти для закрепления данных - передаем
+            //обычным образом.
+            send_flags = MSG_NOSIGNAL;
+            n = sendmsg( sockfd, &msg, send_flags );
+            }
+        if ( n < 0 )
             {
             sprintf( G_LOG->msg,
                 "Network device : s%d->\"%s\":\"%s\""
@@ -603,11 +664,24 @@ int tcp_communicator_linux::sendall (int sockfd, unsigned char *buf, int len,
             break;
             }
 
+        if ( send_flags != MSG_NOSIGNAL ) ( *zerocopy_cnt )++;
+
         usleep( 1 );
         i -= n;
-        p += n;
-
         total_size += n;
+
+        // Пропускаем переданные сегменты.
+        while ( iovcnt > 0 && ( size_t ) n >= iov->iov_len )
+            {
+            n -= iov->iov_len;
+            iov++;
+            iovcnt--;
+            }
+        if ( iovcnt > 0 )
+            {
+            iov->iov_base = ( u_char* ) iov->iov_base + n;
+            iov->iov_len -= n;
+            }
         }
 
     //Network performance info.
@@ -798,6 +872,20 @@ int tcp_communicator_linux::do_echo ( int idx )
 
     int err = 0, res;
 
+    // Буфер и сегменты прошлого ответа будут изменены - ожидаем завершения
+    // их передачи без копирования (время ожидания - как и для передачи).
+    wait_zerocopy_completion( 300 );
+    if ( sock_state.is_zerocopy && !sock_state.init )
+        {
+        // Сокет мог быть готов для чтения только из-за уведомлений.
+        u_char c;
+        if ( recv( sock_state.socket, &c, 1, MSG_PEEK | MSG_DONTWAIT ) < 0 &&
+            ( EAGAIN == errno || EWOULDBLOCK == errno ) )
+            {
+            return 0;
+            }
+        }
+
     sock_state.evaluated = 1;
     memset( buf, 0, BUFSIZE );
 
@@ -837,9 +925,7 @@ int tcp_communicator_linux::do_echo ( int idx )
 
     if ( err <= 0 )               /* read error */
         {
-        shutdown( sock_state.socket, 0 );
-        close( sock_state.socket );
-        sst.erase(sst.begin() + idx, sst.begin() + idx + 1);
+        close_client( idx );
         return err;
         }
 
@@ -867,9 +953,7 @@ int tcp_communicator_linux::do_echo ( int idx )
         switch ( buf[ 2 ] )
             {
             case FRAME_SINGLE:
-
-                res = services[ buf[ 1 ] ] (
-                    ( u_int ) ( buf[ 4 ] * 256 + buf[ 5 ] ), buf + 6, buf + 5 );
+                res = exec_service( sock_state.socket );
 
                 if ( ( unsigned int ) res > max_buffer_use )
                     {
@@ -880,15 +964,6 @@ int tcp_communicator_linux::do_echo ( int idx )
 
                     max_buffer_use = res + 0.1 * res;
                     }
-
-                if ( res == 0 )
-                    {
-                    _AknOK();
-                    }
-                else
-                    {
-                    _AknData( res );
-                    }
                 break;
 
             default:
@@ -927,19 +1002,185 @@ int tcp_communicator_linux::do_echo ( int idx )
             }
         }
 
-    err = sendall( sock_state.socket, buf, in_buffer_count, 0, 300000,
-        inet_ntoa( sock_state.sin.sin_addr ), dev_name, &sock_state.send_stat );
+    // Остаток данных без запроса, заголовок и данные из буфера, затем
+    // сегменты ответа (без копирования).
+    iovec iov[ C_MAX_SEGMENTS + 2 ];
+    int iovcnt = 0;
+    auto &backlog = sock_state.push_backlog;
+    if ( !backlog.empty() )
+        {
+        iov[ iovcnt++ ] = { backlog.data(), backlog.size() };
+        }
+    iov[ iovcnt++ ] = { buf, in_buffer_count };
+    for ( const auto &s : segments )
+        {
+        iov[ iovcnt++ ] = { ( void* ) s.data, s.size };
+        }
+    // Остаток данных без запроса будет изменен до завершения передачи, поэтому
+    // вместе с ним данные копируются.
+    bool is_zerocopy = sock_state.is_zerocopy && backlog.empty() &&
+        in_buffer_count + get_segments_size() >= zerocopy_min_size;
+    segments.clear();
+
+    err = sendallv( sock_state.socket, iov, iovcnt, 0, 300000,
+        inet_ntoa( sock_state.sin.sin_addr ), dev_name, &sock_state.send_stat,
+        is_zerocopy ? &sock_state.zerocopy_pending : nullptr );
 
     if ( err <= 0 )               /* write error */
         {
-        shutdown( sock_state.socket, 0 );
-        close( sock_state.socket );
-        sst.erase(sst.begin() + idx, sst.begin() + idx + 1);
-
+        close_client( idx );
         return err;
         }
 
+    backlog.clear();
     return err;
     }
 //------------------------------------------------------------------------------
+#ifdef USE_ZEROCOPY
+/// @brief Получение (без ожидания) уведомлений о завершении передач без
+/// копирования.
+///
+/// @return количество завершенных передач.
+static u_int read_zerocopy_completions( int sockfd )
+    {
+    u_int cnt = 0;
+    for ( ;; )
+        {
+        char control[ 100 ];
+        msghdr msg = {};
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof( control );
+        if ( recvmsg( sockfd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT ) < 0 )
+            {
+            return cnt;
+            }
+
+        for ( cmsghdr *cm = CMSG_FIRSTHDR( &msg ); cm;
+            cm = CMSG_NXTHDR( &msg, cm ) )
+            {
+            auto serr = ( sock_extended_err* ) CMSG_DATA( cm );
+            if ( serr->ee_errno != 0 ||
+                serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY ) continue;
+
+            //Уведомление содержит диапазон номеров завершенных передач.
+            cnt += serr->ee_data - serr->ee_info + 1;
+            }
+        }
+    }
+#endif // USE_ZEROCOPY
+//------------------------------------------------------------------------------
+void tcp_communicator_linux::wait_zerocopy_completion( int timeout_ms )
+    {
+#ifdef USE_ZEROCOPY
+    u_long start_time = get_millisec();
+    for ( auto &s : sst )
+        {
+        while ( s.zerocopy_pending > 0 )
+            {
+            u_int cnt = read_zerocopy_completions( s.socket );
+            s.zerocopy_pending = cnt >= s.zerocopy_pending ?
+                0 : s.zerocopy_pending - cnt;
+            if ( 0 == s.zerocopy_pending || 0 == timeout_ms ) break;
+
+            int wait_time = timeout_ms - ( int ) get_delta_millisec( start_time );
+            if ( wait_time > 0 )
+                {
+                pollfd pfd = { s.socket, 0, 0 };
+                poll( &pfd, 1, wait_time );
+                continue;
+                }
+
+            sprintf( G_LOG->msg,
+                "Network device : s%d->\"%s\":\"%s\""
+                " zerocopy send completion timeout, connection reset.",
+                s.socket, "easyserver", inet_ntoa( s.sin.sin_addr ) );
+            G_LOG->write_log( i_log::P_WARNING );
+
+            //Сброс соединения (данные из очереди передачи удаляются), сокет
+            //будет закрыт при следующем чтении.
+            sockaddr addr = {};
+            addr.sa_family = AF_UNSPEC;
+            connect( s.socket, &addr, sizeof( addr ) );
+            read_zerocopy_completions( s.socket );
+            s.zerocopy_pending = 0;
+            }
+        }
+#endif // USE_ZEROCOPY
+    }
+//------------------------------------------------------------------------------
+void tcp_communicator_linux::close_client( int idx )
+    {
+    int skt = sst[ idx ].socket;
+    shutdown( skt, 0 );
+    close( skt );
+    sst.erase( sst.begin() + idx, sst.begin() + idx + 1 );
+
+    on_client_close( skt );
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator_linux::send_to_client( int skt, u_char *data, int len )
+    {
+    for ( u_int i = 0; i < sst.size(); i++ )
+        {
+        if ( sst[ i ].socket == skt && sst[ i ].socket != master_socket &&
+            sst[ i ].socket != modbus_socket )
+            {
+            // Данные передаются только после остатка предыдущих.
+            int res = flush_push_backlog( i );
+            if ( res != 0 ) return res;
+
+            int n = send( skt, data, len, MSG_DONTWAIT | MSG_NOSIGNAL );
+            if ( n < 0 )
+                {
+                if ( EAGAIN == errno || EWOULDBLOCK == errno ) return 1;
+
+                sprintf( G_LOG->msg,
+                    "Network device : s%d->\"%s\":\"%s\""
+                    " disconnected on push write try : %s.",
+                    skt, "easyserver (push)",
+                    inet_ntoa( sst[ i ].sin.sin_addr ), strerror( errno ) );
+                G_LOG->write_log( i_log::P_ERR );
+
+                close_client( i );
+                return -1;
+                }
+
+            if ( n < len )
+                {
+                sst[ i ].push_backlog.assign( data + n, data + len );
+                }
+
+            return 0;
+            }
+        }
+
+    return -1;
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator_linux::flush_push_backlog( int idx )
+    {
+    auto &backlog = sst[ idx ].push_backlog;
+    if ( backlog.empty() ) return 0;
+
+    int n = send( sst[ idx ].socket, backlog.data(), backlog.size(),
+        MSG_DONTWAIT | MSG_NOSIGNAL );
+    if ( n < 0 )
+        {
+        if ( EAGAIN == errno || EWOULDBLOCK == errno ) return 1;
+
+        sprintf( G_LOG->msg,
+            "Network device : s%d->\"%s\":\"%s\""
+            " disconnected on push write try : %s.",
+            sst[ idx ].socket, "easyserver (push)",
+            inet_ntoa( sst[ idx ].sin.sin_addr ), strerror( errno ) );
+        G_LOG->write_log( i_log::P_ERR );
+
+        close_client( idx );
+        return -1;
+        }
+
+    backlog.erase( backlog.begin(), backlog.begin() + n );
+    return backlog.empty() ? 0 : 1;
+    }
+//------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
@@ -23,6 +23,7 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <sys/uio.h>
 
 #include <fcntl.h>
 #include <stdio.h>
@@ -42,6 +43,17 @@ struct socket_state
 
     stat_time recv_stat;  ///< Статистика работы с сокетом.
     stat_time send_stat;  ///< Статистика работы с сокетом.
+
+    /// Неотправленная часть данных, передаваемых без запроса (передается
+    /// перед любыми следующими данными).
+    std::vector< u_char > push_backlog;
+
+    /// Ядро поддерживает для сокета передачу без копирования (MSG_ZEROCOPY).
+    bool is_zerocopy = false;
+
+    /// Количество передач MSG_ZEROCOPY, завершение которых еще не
+    /// подтверждено ядром (до этого переданные данные нельзя изменять).
+    u_int zerocopy_pending = 0;
     };
 //-----------------------------------------------------------------------------
 /// @brief Коммуникатор для Linux - обмен данными PAC<->сервер.
@@ -69,6 +81,43 @@ class tcp_communicator_linux : public tcp_communicator
             /// @param skt - сокет.
             int do_echo( int idx );
 
+            /// @brief Отправка данных клиенту (без ожидания запроса).
+            ///
+            /// Передача выполняется без ожидания. Если данные переданы не
+            /// полностью, остаток сохраняется и передается позже.
+            ///
+            /// @return 1 - сокет занят (не передан остаток предыдущих
+            /// данных или буфер сокета заполнен), данные не переданы.
+            int send_to_client( int skt, u_char *data, int len ) override;
+
+            /// @brief Передача (без ожидания) остатка данных, переданных
+            /// без запроса.
+            ///
+            /// @param idx - индекс сокета в таблице состояний.
+            ///
+            /// @return -1 - ошибка, сокет закрыт и удален из таблицы.
+            /// @return 0  - остаток передан.
+            /// @return 1  - остаток передан не полностью.
+            int flush_push_backlog( int idx );
+
+            /// @brief Обработка уведомлений о завершении передач без
+            /// копирования (MSG_ZEROCOPY).
+            ///
+            /// Вызывается перед изменением буфера ответа и сегментов, а
+            /// также перед ожиданием запросов (уведомления делают сокет
+            /// готовым для чтения). Соединение, передача по которому не
+            /// завершилась за заданное время, сбрасывается - ядро
+            /// освобождает данные, и клиент закрывается при следующем чтении.
+            ///
+            /// @param timeout_ms - время ожидания уведомлений, мс (0 - без
+            /// ожидания).
+            void wait_zerocopy_completion( int timeout_ms );
+
+            /// @brief Закрытие сокета клиента и удаление его из таблицы.
+            ///
+            /// @param idx - индекс сокета в таблице состояний.
+            void close_client( int idx );
+
             u_long glob_last_transfer_time;  ///< Время последней успешной передачи данных.
 
             timeval tv;                      ///< Задержка ожидания функции опроса состояний сокетов, 0 по умолчанию.
@@ -90,6 +139,21 @@ class tcp_communicator_linux : public tcp_communicator
                 int sec, int usec, const char* IP, const char* name,
                 stat_time *stat );
 
+            /// @brief Передача данных, состоящих из нескольких сегментов,
+            /// одним системным вызовом (sendmsg).
+            ///
+            /// @param iov          - сегменты данных (изменяются при передаче).
+            /// @param iovcnt       - количество сегментов.
+            /// @param zerocopy_cnt - не nullptr: передача без копирования в
+            /// буфер ядра (MSG_ZEROCOPY, сокет должен ее поддерживать), сюда
+            /// добавляется количество передач, завершение которых будет
+            /// подтверждено уведомлениями ядра.
+            ///
+            /// Остальные параметры аналогичны @ref sendall.
+            static int sendallv( int sockfd, iovec *iov, int iovcnt,
+                int sec, int usec, const char* IP, const char* name,
+                stat_time *stat, u_int *zerocopy_cnt = nullptr );
+
             /// @brief Получение данных с таймаутом.
             ///
             /// @param s        - сокет.
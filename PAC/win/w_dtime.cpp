@@ -37,6 +37,31 @@ unsigned long get_delta_millisec( unsigned long time1 )
     return now >= time1 ? now - time1 : ULONG_MAX - time1 + now;
     }
 //-----------------------------------------------------------------------------
+unsigned long get_microsec()
+    {
+    static LARGE_INTEGER frequency = { 0 };
+    if ( 0 == frequency.QuadPart )
+        {
+        QueryPerformanceFrequency( &frequency );
+        }
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter( &counter );
+
+    //Деление по частям исключает переполнение при большом времени работы.
+    LONGLONG sec = counter.QuadPart / frequency.QuadPart;
+    LONGLONG rest = counter.QuadPart % frequency.QuadPart;
+
+    return ( unsigned long ) ( sec * 1000000LL +
+        rest * 1000000LL / frequency.QuadPart );
+    }
+//-----------------------------------------------------------------------------
+unsigned long get_delta_microsec( unsigned long time1 )
+    {
+    //Беззнаковая арифметика корректно обрабатывает переполнение.
+    return get_microsec() - time1;
+    }
+//-----------------------------------------------------------------------------
 void sleep_ms( u_int ms )
     {
     Sleep( ms );
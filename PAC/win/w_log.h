@@ -26,7 +26,7 @@ class w_log: public i_log
 #pragma warning( disable: 4996 ) //warning C4996: 'localtime': This function or variable may be unsafe.
 		void virtual write_log(PRIORITIES priority)
 			{
-            std::time_t _tm = std::time( nullptr );
+            std::time_t _tm = msg_time ? msg_time : std::time( nullptr );
             std::tm tm = *std::localtime( &_tm );
 
             std::cout << std::put_time( &tm, "%Y-%m-%d %H.%M.%S " );
@@ -68,6 +68,7 @@ void tcp_communicator_win::killsockets()
             sst[ i ].clID = -1;
             shutdown( sst[ i ].socket, SD_BOTH );
             closesocket( sst[ i ].socket );
+            on_client_close( sst[ i ].socket );
             }
         }
 
@@ -292,6 +293,16 @@ int tcp_communicator_win::evaluate()
         }
     // Инициализация сети, при необходимости.-!>
 
+    // Передача остатков данных без запроса.
+    for ( u_int i = 0; i < sst.size(); )
+        {
+        if ( !sst[ i ].push_backlog.empty() && flush_push_backlog( i ) < 0 )
+            {
+            continue; // Сокет закрыт и удален из таблицы.
+            }
+        i++;
+        }
+
     int count_cycles = 0;
     while ( count_cycles < max_cycles )
         {
@@ -331,6 +342,7 @@ int tcp_communicator_win::evaluate()
             WSACleanup();
             return -1;           
             }
+        ready_time = get_microsec();
 
         for ( u_int i = 0; i < sst.size(); i++ )  /* scan all possible sockets */
             {
@@ -359,7 +371,7 @@ int tcp_communicator_win::evaluate()
                         continue;   
                         }
                     // Установка сокета в неблокирующий режим.
-                    u_long mode = 0;
+                    u_long mode = 1;
                     if ( ioctlsocket( slave_socket, FIONBIO, &mode ) == SOCKET_ERROR ) 
                         {
                         printf( "Ошибка перевода клиентского сокета в неблокирующий режим: %s\n",
@@ -491,6 +503,57 @@ int tcp_communicator_win::recvtimeout( u_int s, u_char *buf,
     return recv( s, ( char* ) buf, len, 0 );
     }
 //------------------------------------------------------------------------------
+int tcp_communicator_win::sendtimeout( u_int s, WSABUF *wsa_buf,
+    DWORD buf_cnt, int timeout, int usec )
+    {
+    u_long start_time = get_millisec();
+    long timeout_ms = timeout * 1000L + usec / 1000;
+    int total_size = 0;
+
+    while ( buf_cnt > 0 )
+        {
+        DWORD sent_size = 0;
+        if ( WSASend( s, wsa_buf, buf_cnt, &sent_size, 0,
+            NULL, NULL ) == SOCKET_ERROR )
+            {
+            if ( WSAGetLastError() != WSAEWOULDBLOCK ) return -1; // error
+
+            // Буфер сокета заполнен - ждем возможности отправки.
+            long wait_time = timeout_ms - ( long ) get_delta_millisec( start_time );
+            if ( wait_time <= 0 ) return -2;  // timeout!
+
+            fd_set fds;
+            FD_ZERO( &fds );
+            FD_SET( s, &fds );
+            timeval send_tv;
+            send_tv.tv_sec = wait_time / 1000;
+            send_tv.tv_usec = wait_time % 1000 * 1000;
+
+            int n = select( 0/*Не учитывается*/, NULL, &fds, NULL, &send_tv );
+            if ( 0 == n ) return -2;  // timeout!
+            if ( SOCKET_ERROR == n ) return -1; // error
+            continue;
+            }
+
+        total_size += sent_size;
+
+        // Пропускаем переданные сегменты.
+        while ( buf_cnt > 0 && sent_size >= wsa_buf->len )
+            {
+            sent_size -= wsa_buf->len;
+            wsa_buf++;
+            buf_cnt--;
+            }
+        if ( buf_cnt > 0 )
+            {
+            wsa_buf->buf += sent_size;
+            wsa_buf->len -= sent_size;
+            }
+        }
+
+    return total_size;
+    }
+//------------------------------------------------------------------------------
 int tcp_communicator_win::do_echo( int idx )
     {
     socket_state &sock_state = sst[ idx ];
@@ -544,9 +607,7 @@ int tcp_communicator_win::do_echo( int idx )
                 }
             }
 
-        shutdown( sock_state.socket, 0 );
-        closesocket( sock_state.socket );
-        sst.erase( sst.begin() + idx, sst.begin() + idx + 1 );
+        close_client( idx );
         return err;
         }
 
@@ -577,23 +638,14 @@ int tcp_communicator_win::do_echo( int idx )
         switch ( buf[ 2 ] )
             {
             case FRAME_SINGLE:
-                res = services[ buf[ 1 ] ] ( 
-                    ( u_int ) ( buf[ 4 ] * 256 + buf[ 5 ] ), buf + 6, buf + 5 );
+                res = exec_service( sock_state.socket );
 
-                if ( res == 0 )
-                    {
-                    _AknOK();
-                    }
-                else
+                if ( G_DEBUG ) 
                     {
-                    _AknData( res );
-                    if ( G_DEBUG ) 
+                    if ( ( unsigned int ) res > max_buffer_use )
                         {
-                        if ( ( unsigned int ) res > max_buffer_use )
-                            {
-                            max_buffer_use = res + res / 10;
-                            printf( "Max buffer use %u\n", res );
-                            }
+                        max_buffer_use = res + res / 10;
+                        printf( "Max buffer use %u\n", res );
                         }
                     }
                 break;
@@ -635,7 +687,30 @@ int tcp_communicator_win::do_echo( int idx )
             }
         }
 
-    err = send( sock_state.socket, ( char* ) buf, in_buffer_count, 0 );
+    // Остаток данных без запроса, заголовок и данные из буфера, затем
+    // сегменты ответа (без копирования).
+    WSABUF wsa_buf[ C_MAX_SEGMENTS + 2 ];
+    DWORD buf_cnt = 0;
+    auto &backlog = sock_state.push_backlog;
+    if ( !backlog.empty() )
+        {
+        wsa_buf[ buf_cnt ].buf = ( char* ) backlog.data();
+        wsa_buf[ buf_cnt ].len = ( ULONG ) backlog.size();
+        buf_cnt++;
+        }
+    wsa_buf[ buf_cnt ].buf = ( char* ) buf;
+    wsa_buf[ buf_cnt ].len = in_buffer_count;
+    buf_cnt++;
+    for ( const auto &s : segments )
+        {
+        wsa_buf[ buf_cnt ].buf = ( char* ) s.data;
+        wsa_buf[ buf_cnt ].len = s.size;
+        buf_cnt++;
+        }
+    segments.clear();
+
+    // Ожидаем возможности отправки с таймаутом 1 сек.
+    err = sendtimeout( sock_state.socket, wsa_buf, buf_cnt, 1, 0 );
 
     if ( err <= 0 )               /* write error */
         {
@@ -646,13 +721,87 @@ int tcp_communicator_win::do_echo( int idx )
                 WSA_Last_Err_Decode() );
             }
 
-        shutdown( sock_state.socket, 0 );
-        closesocket( sock_state.socket );
-        sst.erase( sst.begin() + idx, sst.begin() + idx + 1 );
+        close_client( idx );
         return err;
         }
 
+    backlog.clear();
     return err;
     }
 //------------------------------------------------------------------------------
+void tcp_communicator_win::close_client( int idx )
+    {
+    int skt = sst[ idx ].socket;
+    shutdown( skt, 0 );
+    closesocket( skt );
+    sst.erase( sst.begin() + idx, sst.begin() + idx + 1 );
+
+    on_client_close( skt );
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator_win::send_to_client( int skt, u_char *data, int len )
+    {
+    for ( u_int i = 0; i < sst.size(); i++ )
+        {
+        if ( sst[ i ].socket == skt && sst[ i ].socket != master_socket )
+            {
+            // Данные передаются только после остатка предыдущих.
+            int res = flush_push_backlog( i );
+            if ( res != 0 ) return res;
+
+            // Сокет неблокирующий - передача без ожидания.
+            int n = send( skt, ( char* ) data, len, 0 );
+            if ( SOCKET_ERROR == n )
+                {
+                if ( WSAEWOULDBLOCK == WSAGetLastError() ) return 1;
+
+                if ( G_DEBUG )
+                    {
+                    printf( "Socket %d->\"%s\" disconnected on push write try : %s\n",
+                        skt, inet_ntoa( sst[ i ].sin.sin_addr ),
+                        WSA_Last_Err_Decode() );
+                    }
+
+                close_client( i );
+                return -1;
+                }
+
+            if ( n < len )
+                {
+                sst[ i ].push_backlog.assign( data + n, data + len );
+                }
+
+            return 0;
+            }
+        }
+
+    return -1;
+    }
+//------------------------------------------------------------------------------
+int tcp_communicator_win::flush_push_backlog( int idx )
+    {
+    auto &backlog = sst[ idx ].push_backlog;
+    if ( backlog.empty() ) return 0;
+
+    int n = send( sst[ idx ].socket, ( char* ) backlog.data(),
+        ( int ) backlog.size(), 0 );
+    if ( SOCKET_ERROR == n )
+        {
+        if ( WSAEWOULDBLOCK == WSAGetLastError() ) return 1;
+
+        if ( G_DEBUG )
+            {
+            printf( "Socket %d->\"%s\" disconnected on push write try : %s\n",
+                sst[ idx ].socket, inet_ntoa( sst[ idx ].sin.sin_addr ),
+                WSA_Last_Err_Decode() );
+            }
+
+        close_client( idx );
+        return -1;
+        }
+
+    backlog.erase( backlog.begin(), backlog.begin() + n );
+    return backlog.empty() ? 0 : 1;
+    }
+//------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
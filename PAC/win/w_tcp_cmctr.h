@@ -29,6 +29,10 @@ struct socket_state
     int         evaluated;   ///< В данном цикле уже произошел обмен информацией по данному сокету.
     int         clID;        ///< Идентификатор клиента для идентификации того, не занят ли уже сокет другим клиентом.
     sockaddr_in sin; ///< Адрес клиента.
+
+    /// Неотправленная часть данных, передаваемых без запроса (передается
+    /// перед любыми следующими данными).
+    std::vector< u_char > push_backlog;
     };
 //-----------------------------------------------------------------------------
 /// @brief Коммуникатор для Windows - обмен данными PAC<->сервер.
@@ -55,6 +59,30 @@ class tcp_communicator_win : public tcp_communicator
             ///
             /// @param skt - сокет.
             int do_echo( int skt );
+
+            /// @brief Отправка данных клиенту (без ожидания запроса).
+            ///
+            /// Передача выполняется без ожидания. Если данные переданы не
+            /// полностью, остаток сохраняется и передается позже.
+            ///
+            /// @return 1 - сокет занят (не передан остаток предыдущих
+            /// данных или буфер сокета заполнен), данные не переданы.
+            int send_to_client( int skt, u_char *data, int len ) override;
+
+            /// @brief Передача (без ожидания) остатка данных, переданных
+            /// без запроса.
+            ///
+            /// @param idx - индекс сокета в таблице состояний.
+            ///
+            /// @return -1 - ошибка, сокет закрыт и удален из таблицы.
+            /// @return 0  - остаток передан.
+            /// @return 1  - остаток передан не полностью.
+            int flush_push_backlog( int idx );
+
+            /// @brief Закрытие сокета клиента и удаление его из таблицы.
+            ///
+            /// @param idx - индекс сокета в таблице состояний.
+            void close_client( int idx );
             
             u_long glob_last_transfer_time;  ///< Время последней успешной передачи данных.
 
@@ -85,6 +113,21 @@ class tcp_communicator_win : public tcp_communicator
             /// @return >= 0 - размер реально считанных данных.
             int  recvtimeout( u_int s, u_char *buf, int len,
                 int timeout, int usec );
+
+            /// @brief Передача данных, состоящих из нескольких сегментов, с
+            /// ожиданием возможности передачи (сокет неблокирующий).
+            ///
+            /// @param s        - сокет.
+            /// @param wsa_buf  - сегменты данных (изменяются при передаче).
+            /// @param buf_cnt  - количество сегментов.
+            /// @param timeout  - время ожидания, сек.
+            /// @param usec     - время ожидания, мк сек.
+            ///
+            /// @return -1   - ошибка работы с сокетом.
+            /// @return -2   - ошибка таймаута.
+            /// @return >= 0 - размер переданных данных.
+            int  sendtimeout( u_int s, WSABUF *wsa_buf, DWORD buf_cnt,
+                int timeout, int usec );
     };
     
 #endif //TCP_CMCTR_LINUX
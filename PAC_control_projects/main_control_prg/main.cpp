@@ -21,8 +21,12 @@
 #include "PAC_info.h"
 #include "tech_def.h"
 #include "lua_manager.h"
+#include "lua_gc_mngr.h"
+#include "lua_hot_reload.h"
 #include "PAC_err.h"
+#include "alarm_history.h"
 #include "version_info.h"
+#include "subscription_mngr.h"
 
 #ifdef WIN_OS
 #include <shellapi.h>
@@ -99,6 +103,9 @@ int main( int argc, const char *argv[] )
         exit( EXIT_SUCCESS );
         }
 
+    //-История тревог (сохраняется в файле).
+    G_ALARM_HISTORY->init( "./alarm_history.bin" );
+
     //-Инициализация Lua.
     res = G_LUA_MANAGER->init( nullptr, G_PROJECT_MANAGER->main_script.c_str(),
         G_PROJECT_MANAGER->path.c_str(), G_PROJECT_MANAGER->sys_path.c_str(),
@@ -148,6 +155,9 @@ int main( int argc, const char *argv[] )
     G_LOG->info( "Starting main loop! Sleep time is %li ms.",
         G_PROJECT_MANAGER->sleep_time_ms );
 
+    //Сообщения в основном цикле записываются в журнал в конце цикла.
+    log_mngr::set_deferred();
+
     while ( running )
         {
         if ( G_DEBUG )
@@ -164,7 +174,7 @@ int main( int argc, const char *argv[] )
         cycles_cnt++;
 #endif // TEST_SPEED
 
-        lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCSTEP, 200 );
+        u_long cycle_start_time = get_millisec();
         sleep_ms( G_PROJECT_MANAGER->sleep_time_ms );
 
 #ifndef DEBUG_NO_IO_MODULES
@@ -185,6 +195,7 @@ int main( int argc, const char *argv[] )
 #endif // ifndef
 
         G_CMMCTR->evaluate();
+        G_SUBSCRIPTION_MANAGER->evaluate();
 #ifdef OPCUA
         if ( G_PAC_INFO()->par[ PAC_info::P_IS_OPC_UA_SERVER_ACTIVE ] == 1 )
             {
@@ -209,6 +220,17 @@ int main( int argc, const char *argv[] )
             }
 #endif // USE_PROFIBUS
 
+        G_LUA_HOT_RELOAD->evaluate();
+
+        //Отложенная запись параметров.
+        params_manager::get_instance()->evaluate();
+
+        //Запись сообщений журнала.
+        G_LOG->evaluate();
+
+        //Сборка мусора Lua - в оставшееся время цикла.
+        G_LUA_GC_MANAGER->evaluate( G_LUA_MANAGER->get_Lua(), cycle_start_time );
+
 #ifdef TEST_SPEED
         u_int TRESH_AVG =
             G_PAC_INFO()->par[ PAC_info::P_MAIN_CYCLE_WARN_ANSWER_AVG_TIME ];
@@ -254,6 +276,9 @@ int main( int argc, const char *argv[] )
                 cycles_per_period,
                 lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCCOUNT, 0 ) * 1024 +
                 lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCCOUNTB, 0 ) );
+            G_LUA_MANAGER->get_allocator().print_to_log();
+            G_LUA_GC_MANAGER->print_to_log();
+            G_LUA_GC_MANAGER->clear_stat();
 
             all_time   = 0;
             cycles_cnt = 0;
@@ -264,6 +289,9 @@ int main( int argc, const char *argv[] )
         //-Информация о времени выполнения цикла программы.!->
 #endif // TEST_SPEED
         }
+    params_manager::get_instance()->flush();
+    G_LOG->flush();
+
 #ifdef OPCUA
     G_OPCUA_SERVER.shutdown();
 #endif
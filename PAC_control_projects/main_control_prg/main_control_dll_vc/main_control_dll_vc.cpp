@@ -10,7 +10,10 @@
 #include "PAC_info.h"
 #include "tech_def.h"
 #include "lua_manager.h"
+#include "lua_gc_mngr.h"
+#include "lua_hot_reload.h"
 #include "PAC_err.h"
+#include "alarm_history.h"
 #include "version_info.h"
 
 #include "log.h"
@@ -70,6 +73,9 @@ int lua_init( lua_State* L )
         return 1;
         }
 
+    //-История тревог (сохраняется в файле).
+    G_ALARM_HISTORY->init( "./alarm_history.bin" );
+
     //-Инициализация Lua.
     res = G_LUA_MANAGER->init( L, G_PROJECT_MANAGER->main_script.c_str(),
         G_PROJECT_MANAGER->path.c_str(), G_PROJECT_MANAGER->sys_path.c_str(),
@@ -107,7 +113,7 @@ int eval( lua_State* L )
     cycles_cnt++;
 #endif // TEST_SPEED
 
-    lua_gc( G_LUA_MANAGER->get_Lua(), LUA_GCSTEP, 200 );
+    u_long cycle_start_time = get_millisec();
 
     valve::evaluate();
     valve_bottom_mix_proof::evaluate();
@@ -118,6 +124,14 @@ int eval( lua_State* L )
     G_ERRORS_MANAGER->evaluate();
     G_SIREN_LIGHTS_MANAGER()->eval();
 
+    G_LUA_HOT_RELOAD->evaluate();
+
+    //Отложенная запись параметров (оставшиеся изменения записываются при
+    //выгрузке библиотеки, в деструкторе params_manager).
+    params_manager::get_instance()->evaluate();
+
+    G_LUA_GC_MANAGER->evaluate( G_LUA_MANAGER->get_Lua(), cycle_start_time );
+
     lua_pushnumber( L, res );
     return 1;
     }
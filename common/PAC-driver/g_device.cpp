@@ -10,6 +10,11 @@
 
 #include "lua_manager.h"
 #include "tech_def.h"
+#include "cmctr_metrics.h"
+#include "lua_profiler.h"
+#include "lua_hot_reload.h"
+#include "alarm_history.h"
+#include "prj_mngr.h"
 
 char device_communicator::buff[ tcp_communicator::BUFSIZE ];
 
@@ -34,6 +39,39 @@ void print_str( const char *err_str, char is_need_CR )
 #endif // DRIVER
     }
 //-----------------------------------------------------------------------------
+bool device_communicator::is_read_cmd( u_char cmd )
+    {
+    switch ( cmd )
+        {
+        case CMD_GET_INFO_ON_CONNECT:
+        case CMD_GET_DEVICES:
+        case CMD_GET_DEVICES_STATES:
+        case CMD_GET_PAC_ERRORS:
+        case CMD_GET_PARAMS:
+        case CMD_GET_PARAMS_CRC:
+        case CMD_GET_PARAMS_BIN:
+        case CMD_GET_PAC_ERRORS_CHANGES:
+        case CMD_GET_ALARM_HISTORY:
+        case CMD_RM_GET_DEVICES:
+        case CMD_RM_GET_DEVICES_STATES:
+            return true;
+
+        default:
+            return false;
+        }
+    }
+//-----------------------------------------------------------------------------
+void device_communicator::set_default_limits()
+    {
+    request_limiter &limiter = tcp_communicator::get_limiter();
+    limiter.set_client_rate_limit( C_SERVICE_N, C_CLIENT_READ_RATE,
+        C_CLIENT_READ_BURST, is_read_cmd );
+    limiter.set_rate_limit( C_SERVICE_N, CMD_GET_DEVICES,
+        C_GET_DEVICES_RATE, C_GET_DEVICES_BURST );
+    limiter.set_cache_time( C_SERVICE_N, CMD_GET_DEVICES,
+        C_GET_DEVICES_CACHE_TIME );
+    }
+//-----------------------------------------------------------------------------
 long device_communicator::write_devices_states_service(
     long len, u_char *data, u_char *outdata )
     {
@@ -48,6 +86,8 @@ long device_communicator::write_devices_states_service(
     u_long start_time = get_millisec();
 #endif // DEBUG_DEV_CMCTR
 
+    u_long handler_start_time = get_microsec();
+
     u_int param_size = 0;
     static u_int_2 g_devices_request_id = 0;
 
@@ -218,6 +258,64 @@ long device_communicator::write_devices_states_service(
             break;
             }
 
+        case CMD_GET_PAC_ERRORS_CHANGES:
+            {
+            unsigned char project_descr_id = len > 1 ? data[ 1 ] : 0;
+            u_int_4 since_id = 0;
+            if ( len > 5 )
+                {
+                since_id = data[ 2 ] | data[ 3 ] << 8 | data[ 4 ] << 16 |
+                    ( u_int_4 ) data[ 5 ] << 24;
+                }
+
+            char *str = ( char* ) outdata;
+            u_int_2 err_id = 0;
+            bool is_full = false;
+
+            answer_size = sprintf( str, "alarms_changes[ %d ] =\n  {\n",
+                project_descr_id );
+            answer_size += sprintf( str + answer_size, "  id = %u,\n",
+                G_ERRORS_MANAGER->get_journal_id() );
+
+            answer_size += sprintf( str + answer_size, "  critical =\n  {\n" );
+            answer_size +=
+                PAC_critical_errors_manager::get_instance()->save_as_Lua_str(
+                str + answer_size, err_id );
+            answer_size += sprintf( str + answer_size, "  },\n" );
+
+            answer_size += sprintf( str + answer_size, "  changes =\n  {\n" );
+            answer_size += G_ERRORS_MANAGER->save_changes_as_Lua_str(
+                str + answer_size, since_id, is_full );
+            answer_size += sprintf( str + answer_size, "  },\n" );
+
+            answer_size += sprintf( str + answer_size, "  full = %s,\n  }\n",
+                is_full ? "true" : "false" );
+
+            str[ answer_size++ ] = '\0'; // Учитываем завершающий \0.
+            break;
+            }
+
+        case CMD_GET_ALARM_HISTORY:
+            {
+            u_int_4 from_time = 0;
+            u_int_4 to_time = 0;
+            if ( len > 4 )
+                {
+                from_time = data[ 1 ] | data[ 2 ] << 8 | data[ 3 ] << 16 |
+                    ( u_int_4 ) data[ 4 ] << 24;
+                }
+            if ( len > 8 )
+                {
+                to_time = data[ 5 ] | data[ 6 ] << 8 | data[ 7 ] << 16 |
+                    ( u_int_4 ) data[ 8 ] << 24;
+                }
+
+            answer_size = G_ALARM_HISTORY->save_as_Lua_str( ( char* ) outdata,
+                tcp_communicator::BUFSIZE - 10, from_time, to_time );
+            answer_size++; // Учитываем завершающий \0.
+            break;
+            }
+
         case CMD_SET_PAC_ERROR_CMD:
             {
 #ifdef DEBUG_DEV_CMCTR
@@ -274,14 +372,99 @@ long device_communicator::write_devices_states_service(
             break;
             }
 
+        case CMD_GET_PARAMS_BIN:
+            answer_size = params_manager::get_instance()->save_params_as_bin(
+                ( char* ) outdata, tcp_communicator::BUFSIZE - 10 );
+            break;
+
+        case CMD_RESTORE_PARAMS_BIN:
+            {
+            int res = params_manager::get_instance()->restore_params_from_bin(
+                ( char* ) data + 1, len - 1 );
+
+            outdata[ 0 ] = res ? 1 : 0;
+            outdata[ 1 ] = 0;
+            answer_size = 2;
+            break;
+            }
+
         case CMD_GET_PARAMS_CRC:
             answer_size = sprintf( ( char* ) outdata, "params_CRC=%d; request_id=%d\n",
                 params_manager::get_instance()->solve_CRC(),
                 g_devices_request_id );
             answer_size++; // Учитываем завершающий \0.
             break;
+
+        case CMD_GET_CMCTR_METRICS:
+            answer_size = G_CMMCTR_METRICS->save_as_Lua_str( ( char* ) outdata,
+                tcp_communicator::BUFSIZE - 10 );
+            answer_size++; // Учитываем завершающий \0.
+
+            if ( len > 1 && 1 == data[ 1 ] )
+                {
+                G_CMMCTR_METRICS->clear();
+                }
+            break;
+
+        case CMD_LUA_PROFILER:
+            if ( len > 1 )
+                {
+                switch ( data[ 1 ] )
+                    {
+                    case 0:
+                        G_LUA_PROFILER->stop();
+                        break;
+
+                    case 1:
+                        G_LUA_PROFILER->start( G_LUA_MANAGER->get_Lua(),
+                            lua_profiler::M_CALLS );
+                        break;
+
+                    case 2:
+                        G_LUA_PROFILER->start( G_LUA_MANAGER->get_Lua(),
+                            lua_profiler::M_FULL );
+                        break;
+
+                    case 3:
+                        G_LUA_PROFILER->clear();
+                        break;
+                    }
+                }
+
+            if ( len > 1 && 4 == data[ 1 ] )
+                {
+                answer_size = G_LUA_PROFILER->save_as_Lua_str(
+                    ( char* ) outdata, tcp_communicator::BUFSIZE - 10 );
+                }
+            else
+                {
+                answer_size = G_LUA_PROFILER->save_as_folded(
+                    ( char* ) outdata, tcp_communicator::BUFSIZE - 10 );
+                }
+            answer_size++; // Учитываем завершающий \0.
+            break;
+
+        case CMD_LUA_HOT_RELOAD:
+            if ( len > 1 && 1 == data[ 1 ] )
+                {
+                std::string path = G_PROJECT_MANAGER->main_script;
+                if ( len > 2 && data[ 2 ] )
+                    {
+                    path = G_PROJECT_MANAGER->path;
+                    path.append( ( char* ) data + 2,
+                        strnlen( ( char* ) data + 2, len - 2 ) );
+                    }
+                G_LUA_HOT_RELOAD->start( path.c_str() );
+                }
+
+            answer_size = G_LUA_HOT_RELOAD->save_as_Lua_str( ( char* ) outdata,
+                tcp_communicator::BUFSIZE - 10 );
+            answer_size++; // Учитываем завершающий \0.
+            break;
         }
 
+    u_long handler_time = get_delta_microsec( handler_start_time );
+    u_int raw_size = answer_size;
 
     if ( answer_size > 0 && use_compression )
         {
@@ -290,7 +473,13 @@ long device_communicator::write_devices_states_service(
 
         if ( res == Z_OK && r > 0 )
             {
-            memcpy( outdata, buff, r );
+            //Сжатые данные по возможности передаются прямо из буфера, без
+            //копирования в буфер ответа.
+            if ( nullptr == G_CMMCTR ||
+                G_CMMCTR->add_response_segment( ( u_char* ) buff, r ) )
+                {
+                memcpy( outdata, buff, r );
+                }
             answer_size = r;
             }
         else
@@ -302,6 +491,9 @@ long device_communicator::write_devices_states_service(
             }
         }
 
+    G_CMMCTR_METRICS->add_command( data[ 0 ], handler_time, raw_size,
+        answer_size );
+
     return answer_size;
     }
 //-----------------------------------------------------------------------------
@@ -106,8 +106,59 @@ class device_communicator
             /// Эта сумма используется для отслеживания изменения параметров PAC
             /// и их записи в этом случае в резервную копию.
             CMD_GET_PARAMS_CRC,
+
+            ///@brief Получение параметров в двоичном виде
+            /// (@ref params_manager::save_params_as_bin).
+            CMD_GET_PARAMS_BIN,
+            ///@brief Восстановление параметров из двоичного вида (data[ 1 ]...).
+            ///
+            /// В ответе: data[ 0 ] = 0 - ок, 1 - ошибка.
+            CMD_RESTORE_PARAMS_BIN,
             // Резервное копирование параметров. -!>
 
+            ///@brief Получение статистики коммуникатора.
+            ///
+            /// Если data[ 1 ] = 1, то после чтения статистика сбрасывается.
+            CMD_GET_CMCTR_METRICS = 150,
+
+            ///@brief Управление профилированием функций Lua.
+            ///
+            /// data[ 1 ] - действие: 0 - остановка, 1 - запуск (только вызовы
+            /// из C++), 2 - запуск (все вызовы), 3 - сброс статистики,
+            /// 4 - получение полной статистики.
+            /// В ответе - статистика в виде свернутых стеков
+            /// (@ref lua_profiler::save_as_folded), для действия 4 - в виде
+            /// таблицы Lua (@ref lua_profiler::save_as_Lua_str).
+            CMD_LUA_PROFILER,
+
+            ///@brief Горячая перезагрузка функций Lua.
+            ///
+            /// data[ 1 ] - действие: 0 - получение состояния, 1 - запуск
+            /// перезагрузки скрипта, имя которого (относительно каталога
+            /// проекта) - в data[ 2 ]... (пустое имя - основной скрипт).
+            /// В ответе - состояние последней перезагрузки
+            /// (@ref lua_hot_reload::save_as_Lua_str).
+            CMD_LUA_HOT_RELOAD,
+
+            ///@brief Запрос изменений ошибок PAC.
+            ///
+            /// data[ 1 ] - номер описания проекта (как в
+            /// @ref CMD_GET_PAC_ERRORS), data[ 2 ]...data[ 5 ] - номер
+            /// последней полученной записи журнала ошибок (младший байт
+            /// первый, id из предыдущего ответа). В ответе - критические ошибки
+            /// и изменившиеся ошибки объектов
+            /// (@ref errors_manager::save_changes_as_Lua_str), при full = true
+            /// - полный список ошибок.
+            CMD_GET_PAC_ERRORS_CHANGES,
+
+            ///@brief Получение истории тревог.
+            ///
+            /// data[ 1 ]...data[ 4 ] - начало, data[ 5 ]...data[ 8 ] - конец
+            /// (0 - без ограничения) интервала времени, с (UTC, младший байт
+            /// первый). В ответе - события истории тревог
+            /// (@ref alarm_history::save_as_Lua_str).
+            CMD_GET_ALARM_HISTORY,
+
             CMD_RM_GET_DEVICES = 200,   ///< Запрос устройств PAC от PAC-мастера.
             CMD_RM_GET_DEVICES_STATES,  ///< Запрос состояния устройств PAC от PAC-мастера.
             };
@@ -169,6 +220,29 @@ class device_communicator
         /// @brief Сервис для работы с device_communicator.
         static long write_devices_states_service( long len, u_char *data,
             u_char *outdata );
+
+        /// @brief Проверка, что команда только читает данные (частоту
+        /// таких команд можно ограничивать, а ответ - сохранять).
+        static bool is_read_cmd( u_char cmd );
+
+        /// @brief Задание ограничений частоты запросов чтения по умолчанию.
+        ///
+        /// Для каждого клиента ограничивается общая частота команд чтения
+        /// (@ref C_CLIENT_READ_RATE, @ref C_CLIENT_READ_BURST), а также
+        /// частота запроса описания устройств (@ref CMD_GET_DEVICES), ответ
+        /// на который хранится @ref C_GET_DEVICES_CACHE_TIME мс. Команды
+        /// записи и выполнения не ограничиваются. Ограничения можно изменить
+        /// параметрами командной строки.
+        static void set_default_limits();
+
+        enum DEFAULT_LIMITS
+            {
+            C_CLIENT_READ_RATE = 20,        ///< Команд чтения клиента, 1/с.
+            C_CLIENT_READ_BURST = 40,       ///< Команд чтения клиента подряд.
+            C_GET_DEVICES_RATE = 1,         ///< Запросов описания устройств, 1/с.
+            C_GET_DEVICES_BURST = 3,        ///< Запросов описания устройств подряд.
+            C_GET_DEVICES_CACHE_TIME = 1000,///< Время хранения описания устройств, мс.
+            };
 #endif // !DRIVER
     };
 //-----------------------------------------------------------------------------
@@ -3,8 +3,14 @@
 #include "stdafx.h" //Стандартный заголовочный файл для использования precompiled headers.
 #endif //USE_STDAFX
 #else
+#include <algorithm>
+#include <unordered_map>
+#include <random>
+#include <chrono>
+
 #include "g_errors.h"
 #include "PAC_err.h"
+#include "alarm_history.h"
 #endif
 
 #ifdef PAC
@@ -151,6 +157,11 @@ unsigned int tech_dev_error::get_object_n() const
     return simple_device->get_serial_n();
     }
 //-----------------------------------------------------------------------------
+int tech_dev_error::get_value() const
+    {
+    return simple_device->get_state();
+    }
+//-----------------------------------------------------------------------------
 int tech_dev_error::set_cmd( int cmd, int object_alarm_number )
     {
     int res = 0;
@@ -345,8 +356,111 @@ const char* tech_obj_error::get_group( tech_object::ERR_MSG_TYPES err_type )
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
-errors_manager::errors_manager(): errors_id( 0 )
+//Начальный номер журнала изменений ошибок.
+//
+//Номер не должен совпадать с номерами журнала предыдущих запусков PAC, иначе
+//клиент после перезапуска получит только часть изменений вместо полного
+//списка. Время с момента загрузки для этого не подходит (одинаково после
+//каждой перезагрузки), поэтому используется случайное значение, смешанное
+//с текущим временем (на случай детерминированного random_device).
+static u_int_4 get_initial_journal_id()
     {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    u_int_4 id = static_cast< u_int_4 >(
+        std::chrono::duration_cast< std::chrono::milliseconds >( now ).count() );
+
+    try
+        {
+        std::random_device rd;
+        id ^= static_cast< u_int_4 >( rd() );
+        }
+    catch ( ... )
+        {
+        //Источник случайных чисел недоступен - только время.
+        }
+
+    return id;
+    }
+//-----------------------------------------------------------------------------
+errors_manager::errors_manager(): errors_id( 0 ),
+    journal_id( get_initial_journal_id() )
+    {
+    journal.reserve( C_JOURNAL_SIZE );
+    }
+//-----------------------------------------------------------------------------
+void errors_manager::add_to_journal( u_int idx )
+    {
+    if ( journal.size() < C_JOURNAL_SIZE )
+        {
+        journal.push_back( idx );
+        }
+    else
+        {
+        journal[ journal_pos ] = idx;
+        }
+    journal_pos = ( journal_pos + 1 ) % C_JOURNAL_SIZE;
+    journal_id++;
+
+    auto err = s_errors_vector[ idx ];
+    G_ALARM_HISTORY->add( alarm_history::S_ERROR, err->get_error_state(),
+        err->get_object_type(), 0, err->get_object_n(), err->get_value() );
+    }
+//-----------------------------------------------------------------------------
+int errors_manager::save_changes_as_Lua_str( char *str, u_int_4 since_id,
+    bool &is_full )
+    {
+    int res = 0;
+    str[ 0 ] = 0;
+
+    //Количество записей после since_id (при since_id из "будущего" -
+    //заведомо больше размера журнала).
+    u_int_4 changes_cnt = journal_id - since_id;
+    is_full = changes_cnt > journal.size();
+
+    changed_errors.clear();
+    if ( is_full )
+        {
+        for ( u_int i = 0; i < s_errors_vector.size(); i++ )
+            {
+            changed_errors.push_back( i );
+            }
+        }
+    else
+        {
+        //Последняя запись находится перед journal_pos.
+        for ( u_int_4 i = 1; i <= changes_cnt; i++ )
+            {
+            changed_errors.push_back(
+                journal[ ( journal_pos + C_JOURNAL_SIZE - i ) % C_JOURNAL_SIZE ] );
+            }
+        std::sort( changed_errors.begin(), changed_errors.end() );
+        changed_errors.erase( std::unique( changed_errors.begin(),
+            changed_errors.end() ), changed_errors.end() );
+        }
+
+    for ( auto idx : changed_errors )
+        {
+        auto err = s_errors_vector[ idx ];
+        int alarms_size = err->save_as_Lua_str( str + res );
+        if ( is_full && 0 == alarms_size )
+            {
+            //В полном списке - только объекты с ошибками.
+            str[ res ] = 0;
+            continue;
+            }
+
+        //Заголовок записывается перед уже сохраненными ошибками объекта.
+        char header[ 60 ];
+        int header_size = snprintf( header, sizeof( header ),
+            "\t{ id_type = %d, id_n = %u, alarms =\n\t{\n",
+            err->get_object_type(), err->get_object_n() );
+        memmove( str + res + header_size, str + res, alarms_size );
+        memcpy( str + res, header, header_size );
+        res += header_size + alarms_size;
+        res += sprintf( str + res, "\t} },\n" );
+        }
+
+    return res;
     }
 //-----------------------------------------------------------------------------
 int errors_manager::save_as_Lua_str( char *str, u_int_2 &id )
@@ -374,9 +488,69 @@ void errors_manager::evaluate()
     tech_dev_error::is_new_error = false;
     tech_obj_error::is_any_message = false;
 
-    for ( u_int i = 0; i < s_errors_vector.size(); i++ )
+    auto dev_mngr = G_DEVICE_MANAGER();
+    if ( !dev_mngr->is_errors_valid() )
         {
-        s_errors_vector[ i ]->evaluate( is_new_error_state );
+        //Изменения состояний устройств не отслеживаются - обновление всех
+        //ошибок.
+        for ( u_int i = 0; i < s_errors_vector.size(); i++ )
+            {
+            bool is_changed = false;
+            s_errors_vector[ i ]->evaluate( is_changed );
+            if ( is_changed )
+                {
+                is_new_error_state = true;
+                add_to_journal( i );
+                }
+            }
+        evaluated_count = s_errors_vector.size();
+        is_index_changed = true;
+        }
+    else
+        {
+        if ( is_index_changed ||
+            index_devices_count != dev_mngr->get_devices_count() )
+            {
+            update_index();
+            }
+
+        evaluated_errors = polled_errors;
+        evaluated_errors.insert( evaluated_errors.end(),
+            active_errors.begin(), active_errors.end() );
+        for ( auto dev_n : dev_mngr->get_changed_devices() )
+            {
+            if ( dev_n < dev_errors_idx.size() && dev_errors_idx[ dev_n ] >= 0 )
+                {
+                evaluated_errors.push_back( dev_errors_idx[ dev_n ] );
+                }
+            }
+        dev_mngr->clear_changed_devices();
+
+        //Обновление в порядке добавления ошибок.
+        std::sort( evaluated_errors.begin(), evaluated_errors.end() );
+        evaluated_errors.erase( std::unique( evaluated_errors.begin(),
+            evaluated_errors.end() ), evaluated_errors.end() );
+
+        active_errors.clear();
+        for ( auto idx : evaluated_errors )
+            {
+            auto err = s_errors_vector[ idx ];
+            bool is_changed = false;
+            err->evaluate( is_changed );
+            if ( is_changed )
+                {
+                is_new_error_state = true;
+                add_to_journal( idx );
+                }
+
+            if ( idx < dev_errors_idx_by_error.size() &&
+                dev_errors_idx_by_error[ idx ] &&
+                err->get_error_state() != AS_NORMAL )
+                {
+                active_errors.push_back( idx );
+                }
+            }
+        evaluated_count = evaluated_errors.size();
         }
 
     if ( is_new_error_state )
@@ -385,12 +559,111 @@ void errors_manager::evaluate()
         }
     }
 //-----------------------------------------------------------------------------
+void errors_manager::update_index()
+    {
+    auto dev_mngr = G_DEVICE_MANAGER();
+    index_devices_count = dev_mngr->get_devices_count();
+    dev_errors_idx.assign( index_devices_count, -1 );
+    dev_errors_idx_by_error.assign( s_errors_vector.size(), false );
+
+    //Сопоставление только по адресу устройства (устройство ошибки могло
+    //быть уже удалено).
+    std::unordered_map< const device*, u_int > devices;
+    for ( u_int i = 0; i < index_devices_count; i++ )
+        {
+        devices[ dev_mngr->get_device( i ) ] = i;
+        }
+    for ( auto& item : dev_errors )
+        {
+        auto it = devices.find( item.second->simple_device );
+        if ( it != devices.end() )
+            {
+            dev_errors_idx[ it->second ] = item.first;
+            dev_errors_idx_by_error[ item.first ] = true;
+            }
+        }
+
+    //Ошибки объектов и устройств, не зарегистрированных в менеджере
+    //устройств, обновляются каждый раз. Активные ошибки устройств
+    //определяются заново полным обновлением.
+    polled_errors.clear();
+    active_errors.clear();
+    for ( u_int i = 0; i < s_errors_vector.size(); i++ )
+        {
+        if ( !dev_errors_idx_by_error[ i ] ||
+            s_errors_vector[ i ]->get_error_state() != AS_NORMAL )
+            {
+            if ( dev_errors_idx_by_error[ i ] ) active_errors.push_back( i );
+            else polled_errors.push_back( i );
+            }
+        }
+
+    is_index_changed = false;
+    }
+//-----------------------------------------------------------------------------
 int errors_manager::add_error( base_error  *s_error )
     {
     s_errors_vector.push_back( s_error );
+    is_index_changed = true;
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+int errors_manager::add_error( tech_dev_error *dev_error )
+    {
+    dev_errors.push_back( { ( u_int ) s_errors_vector.size(), dev_error } );
+    return add_error( static_cast< base_error* >( dev_error ) );
+    }
+//-----------------------------------------------------------------------------
+int errors_manager::remove_error( base_error *s_error )
+    {
+    auto it = std::find( s_errors_vector.begin(), s_errors_vector.end(),
+        s_error );
+    if ( it == s_errors_vector.end() ) return 1;
+
+    u_int idx = static_cast< u_int >( it - s_errors_vector.begin() );
+    s_errors_vector.erase( it );
+
+    dev_errors.erase( std::remove_if( dev_errors.begin(), dev_errors.end(),
+        [ idx ]( const std::pair< u_int, tech_dev_error* >& item )
+            {
+            return item.first == idx;
+            } ), dev_errors.end() );
+    for ( auto& item : dev_errors )
+        {
+        if ( item.first > idx ) item.first--;
+        }
+    is_index_changed = true;
+
+    reset_journal();
     return 0;
     }
 //-----------------------------------------------------------------------------
+void errors_manager::reset_journal()
+    {
+    journal.clear();
+    journal_pos = 0;
+    journal_id += C_JOURNAL_SIZE + 1;
+    errors_id++;
+    }
+//-----------------------------------------------------------------------------
+void errors_manager::remove_dev_errors()
+    {
+    if ( dev_errors.empty() ) return;
+
+    for ( auto& item : dev_errors )
+        {
+        delete item.second;
+        s_errors_vector[ item.first ] = nullptr;
+        }
+    dev_errors.clear();
+
+    s_errors_vector.erase( std::remove( s_errors_vector.begin(),
+        s_errors_vector.end(), nullptr ), s_errors_vector.end() );
+    is_index_changed = true;
+
+    reset_journal();
+    }
+//-----------------------------------------------------------------------------
 void errors_manager::print()
     {
     if ( G_DEBUG )
@@ -418,6 +691,7 @@ void errors_manager::set_cmd( unsigned int cmd, unsigned int object_type,
                                  unsigned int object_alarm_number )
     {
     base_error *res = 0;
+    u_int res_idx = 0;
 
     // Поиск нужного устройства.
     for ( u_int i = 0; i < s_errors_vector.size(); i++ )
@@ -426,6 +700,7 @@ void errors_manager::set_cmd( unsigned int cmd, unsigned int object_type,
             s_errors_vector[ i ]->get_object_n() == object_number )
             {
             res = s_errors_vector[ i ];
+            res_idx = i;
             break;
             }
         }
@@ -437,6 +712,7 @@ void errors_manager::set_cmd( unsigned int cmd, unsigned int object_type,
         if ( 0 == result )
             {
             errors_id++; // Cостояние ошибок изменилось.
+            add_to_journal( res_idx );
             }
         }
     else
@@ -206,12 +206,25 @@ class base_error
         /// @brief Выполнение команды над ошибкой.
         virtual int set_cmd( int cmd, int object_alarm_number ) = 0;
 
+        /// @brief Получение значения для истории тревог
+        /// (@ref alarm_history::record::value).
+        virtual int get_value() const
+            {
+            return 0;
+            }
+
         /// @brief Сброс параметров ошибки в значение по умолчанию (0).
         void reset_errors_params()
             {
             err_par[ P_PARAM_N ] = 0;
             }
 
+        /// @brief Получение состояния ошибки (@ref ALARM_STATE).
+        unsigned char get_error_state() const
+            {
+            return error_state;
+            }
+
         enum PARAMS  ///< Параметры ошибки, определяют номера битов.
             {
             P_PARAM_N = 1,	  //Номер параметра.
@@ -266,6 +279,9 @@ class tech_dev_error: public base_error
         /// @brief Выполнение команды над ошибкой.
         int set_cmd( int cmd, int object_alarm_number );
 
+        /// @brief Состояние устройства.
+        int get_value() const;
+
     protected:
         bool static is_any_error;        ///< Наличие тревоги.
         bool static is_any_no_ack_error; ///< Наличие неподтвержденной тревоги.
@@ -313,6 +329,12 @@ class tech_obj_error: public base_error
             return tech_dev->get_number();
             }
 
+        /// @brief Количество сообщений объекта.
+        int get_value() const
+            {
+            return static_cast< int >( tech_dev->get_errors().size() );
+            }
+
         static const char* get_group( tech_object::ERR_MSG_TYPES err_type );
 
         static int get_priority( tech_object::ERR_MSG_TYPES err_type );
@@ -351,7 +373,38 @@ class errors_manager
         /// @return   0 - ок.
         int save_as_Lua_str( char *str, u_int_2 &id );
 
+        /// @brief Сохранение изменившихся ошибок для передачи на сервер.
+        ///
+        /// Для каждого объекта, ошибки которого изменились после записи
+        /// журнала с номером since_id, сохраняются все его текущие ошибки
+        /// (пустой список - ошибок больше нет):
+        /// { id_type = ..., id_n = ..., alarms = { ... } }.
+        ///
+        /// Если записи журнала после since_id уже перезаписаны (или номер
+        /// неизвестен, например, после перезапуска PAC), сохраняются все
+        /// объекты с ошибками, а is_full = true.
+        ///
+        /// @param str      - строка для записи.
+        /// @param since_id - номер последней полученной клиентом записи
+        ///                   журнала (@ref get_journal_id).
+        /// @param is_full  - сохранен полный список ошибок.
+        ///
+        /// @return количество записанных байт.
+        int save_changes_as_Lua_str( char *str, u_int_4 since_id,
+            bool &is_full );
+
+        /// @brief Номер последней записи журнала изменений ошибок.
+        u_int_4 get_journal_id() const
+            {
+            return journal_id;
+            }
+
         /// @brief Обновление состояния ошибок.
+        ///
+        /// Ошибки устройств обновляются только для устройств, состояние
+        /// которых изменилось (@ref device_manager::get_changed_devices), и
+        /// для устройств с активной ошибкой (состояние ошибки не
+        /// @ref AS_NORMAL). Остальные ошибки обновляются каждый раз.
         void evaluate();
 
         /// @brief Добавление ошибки в массив ошибок.
@@ -362,6 +415,29 @@ class errors_manager
         /// @return   0 - ок.
         int add_error( base_error *s_error );
 
+        /// @brief Добавление ошибки устройства в массив ошибок.
+        int add_error( tech_dev_error *dev_error );
+
+        /// @brief Удаление всех ошибок устройств (при удалении устройств).
+        ///
+        /// Журнал изменений ошибок очищается.
+        void remove_dev_errors();
+
+        /// @brief Удаление ошибки из массива ошибок.
+        ///
+        /// Объект ошибки не удаляется (освобождается вызывающим кодом).
+        /// Журнал изменений ошибок очищается.
+        ///
+        /// @return 0 - ок, 1 - ошибка не найдена.
+        int remove_error( base_error *s_error );
+
+        /// @brief Количество ошибок, обновленных при последнем вызове
+        /// @ref evaluate.
+        u_int get_evaluated_count() const
+            {
+            return evaluated_count;
+            }
+
         /// @brief Сброс параметров всех ошибок в значение по умолчанию (0).
         void reset_errors_params();
 
@@ -387,9 +463,51 @@ class errors_manager
         enum DEM_CONST
             {
             DEM_MAX_ERRORS_CNT = 29,
+
+            C_JOURNAL_SIZE = 256, ///< Количество записей журнала изменений.
             };
 
+        /// @brief Запись в журнал изменения ошибки.
+        ///
+        /// @param idx - номер ошибки в s_errors_vector.
+        void add_to_journal( u_int idx );
+
+        /// @brief Очистка журнала при изменении номеров ошибок.
+        ///
+        /// Номер журнала увеличивается больше, чем на размер журнала, -
+        /// клиенты получат полный список ошибок.
+        void reset_journal();
+
+        /// Журнал изменений ошибок (кольцевой буфер номеров ошибок в
+        /// s_errors_vector), последняя запись имеет номер journal_id.
+        std::vector< u_int > journal;
+        u_int   journal_pos = 0;
+        u_int_4 journal_id;
+
         std::vector< base_error* > s_errors_vector;    ///< Массив ошибок.
+
+        /// Ошибки устройств (номер в s_errors_vector, ошибка).
+        std::vector< std::pair< u_int, tech_dev_error* > > dev_errors;
+
+        /// @brief Обновление соответствия устройств ошибкам.
+        void update_index();
+
+        bool is_index_changed = true;
+        u_int index_devices_count = 0;
+
+        /// Номер ошибки (в s_errors_vector) по номеру устройства, -1 - нет.
+        std::vector< int > dev_errors_idx;
+        /// Признак ошибки зарегистрированного устройства по номеру ошибки.
+        std::vector< bool > dev_errors_idx_by_error;
+        /// Ошибки, обновляемые каждый раз (номера в s_errors_vector).
+        std::vector< u_int > polled_errors;
+        /// Ошибки устройств с активной ошибкой (номера в s_errors_vector).
+        std::vector< u_int > active_errors;
+        /// Обновляемые ошибки (номера в s_errors_vector).
+        std::vector< u_int > evaluated_errors;
+        /// Изменившиеся ошибки для ответа (номера в s_errors_vector).
+        std::vector< u_int > changed_errors;
+        u_int evaluated_count = 0;
     };
 
 //Совместимость с предыдущей версией драйвера EasyDrv. FIXME.
@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lua_allocator.h"
+
+#include "log.h"
+//-----------------------------------------------------------------------------
+lua_allocator::lua_allocator() : live_bytes( 0 ), peak_bytes( 0 ),
+    big_bytes( 0 ), big_cnt( 0 )
+    {
+    memset( free_lists, 0, sizeof( free_lists ) );
+    memset( classes, 0, sizeof( classes ) );
+    }
+//-----------------------------------------------------------------------------
+lua_allocator::~lua_allocator()
+    {
+    for ( auto page : pages )
+        {
+        free( page );
+        }
+    }
+//-----------------------------------------------------------------------------
+void* lua_allocator::alloc( void* ud, void* ptr, size_t osize, size_t nsize )
+    {
+    auto a = static_cast< lua_allocator* >( ud );
+
+    if ( 0 == nsize )
+        {
+        if ( ptr ) a->deallocate( ptr, osize );
+        return nullptr;
+        }
+
+    if ( nullptr == ptr ) return a->allocate( nsize );
+
+    return a->reallocate( ptr, osize, nsize );
+    }
+//-----------------------------------------------------------------------------
+int lua_allocator::get_class( size_t size )
+    {
+    if ( size > C_MAX_SMALL_SIZE ) return -1;
+
+    return static_cast< int >( ( size + C_CLASS_STEP - 1 ) / C_CLASS_STEP ) - 1;
+    }
+//-----------------------------------------------------------------------------
+int lua_allocator::add_page( int class_n )
+    {
+    auto page = static_cast< char* >( malloc( C_PAGE_SIZE ) );
+    if ( nullptr == page ) return 1;
+
+    pages.push_back( page );
+
+    size_t block_size = ( class_n + 1 ) * C_CLASS_STEP;
+    size_t cnt = C_PAGE_SIZE / block_size;
+    for ( size_t i = 0; i < cnt; i++ )
+        {
+        auto block = reinterpret_cast< free_block* >( page + i * block_size );
+        block->next = free_lists[ class_n ];
+        free_lists[ class_n ] = block;
+        }
+    classes[ class_n ].free_cnt += cnt;
+
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+void* lua_allocator::allocate( size_t size )
+    {
+    void* res = nullptr;
+
+    int class_n = get_class( size );
+    if ( class_n < 0 )
+        {
+        res = malloc( size );
+        if ( nullptr == res ) return nullptr;
+
+        big_bytes += size;
+        big_cnt++;
+        }
+    else
+        {
+        if ( nullptr == free_lists[ class_n ] && add_page( class_n ) )
+            {
+            return nullptr;
+            }
+
+        free_block* block = free_lists[ class_n ];
+        free_lists[ class_n ] = block->next;
+
+        class_stat& st = classes[ class_n ];
+        st.free_cnt--;
+        st.used_cnt++;
+        st.alloc_cnt++;
+        res = block;
+        }
+
+    live_bytes += size;
+    if ( live_bytes > peak_bytes ) peak_bytes = live_bytes;
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+void lua_allocator::deallocate( void* ptr, size_t size )
+    {
+    live_bytes -= size;
+
+    int class_n = get_class( size );
+    if ( class_n < 0 )
+        {
+        free( ptr );
+        big_bytes -= size;
+        big_cnt--;
+        return;
+        }
+
+    auto block = static_cast< free_block* >( ptr );
+    block->next = free_lists[ class_n ];
+    free_lists[ class_n ] = block;
+
+    classes[ class_n ].free_cnt++;
+    classes[ class_n ].used_cnt--;
+    }
+//-----------------------------------------------------------------------------
+void* lua_allocator::reallocate( void* ptr, size_t osize, size_t nsize )
+    {
+    int o_class = get_class( osize );
+    int n_class = get_class( nsize );
+
+    //Блок остается в том же классе.
+    if ( o_class >= 0 && o_class == n_class )
+        {
+        live_bytes = live_bytes - osize + nsize;
+        if ( live_bytes > peak_bytes ) peak_bytes = live_bytes;
+        return ptr;
+        }
+
+    //Оба блока большие.
+    if ( o_class < 0 && n_class < 0 )
+        {
+        void* res = realloc( ptr, nsize );
+        if ( nullptr == res ) return nullptr;
+
+        big_bytes = big_bytes - osize + nsize;
+        live_bytes = live_bytes - osize + nsize;
+        if ( live_bytes > peak_bytes ) peak_bytes = live_bytes;
+        return res;
+        }
+
+    void* res = allocate( nsize );
+    if ( nullptr == res )
+        {
+        if ( nsize >= osize ) return nullptr;
+
+        //Уменьшение блока не должно завершаться ошибкой (требование Lua).
+        //Остается прежний блок, далее он используется как блок нового
+        //класса (его размера достаточно). Большой блок при этом системе не
+        //возвращается.
+        if ( o_class < 0 )
+            {
+            big_bytes -= osize;
+            big_cnt--;
+            }
+        else
+            {
+            classes[ o_class ].used_cnt--;
+            }
+        classes[ n_class ].used_cnt++;
+        live_bytes = live_bytes - osize + nsize;
+
+        return ptr;
+        }
+
+    memcpy( res, ptr, osize < nsize ? osize : nsize );
+    deallocate( ptr, osize );
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+size_t lua_allocator::get_live_bytes() const
+    {
+    return live_bytes;
+    }
+//-----------------------------------------------------------------------------
+size_t lua_allocator::get_peak_bytes() const
+    {
+    return peak_bytes;
+    }
+//-----------------------------------------------------------------------------
+size_t lua_allocator::get_reserved_bytes() const
+    {
+    return pages.size() * C_PAGE_SIZE + big_bytes;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_allocator::get_big_blocks_cnt() const
+    {
+    return big_cnt;
+    }
+//-----------------------------------------------------------------------------
+const lua_allocator::class_stat& lua_allocator::get_class_stat(
+    int class_n ) const
+    {
+    if ( class_n < 0 ) class_n = 0;
+    if ( class_n >= C_CLASS_CNT ) class_n = C_CLASS_CNT - 1;
+
+    return classes[ class_n ];
+    }
+//-----------------------------------------------------------------------------
+int lua_allocator::save_as_Lua_str( char* buff, int max_size ) const
+    {
+    int res = snprintf( buff, max_size,
+        "lua_mem =\n\t{\n\tlive = %zu, peak = %zu, reserved = %zu, "
+        "big_cnt = %lu,\n\tclasses =\n\t\t{\n",
+        live_bytes, peak_bytes, get_reserved_bytes(), big_cnt );
+
+    for ( int i = 0; i < C_CLASS_CNT && res < max_size; i++ )
+        {
+        const class_stat& st = classes[ i ];
+        res += snprintf( buff + res, max_size - res,
+            "\t\t[ %d ] = { used = %lu, free = %lu, alloc = %lu },\n",
+            ( i + 1 ) * C_CLASS_STEP, st.used_cnt, st.free_cnt, st.alloc_cnt );
+        }
+
+    if ( res < max_size )
+        {
+        res += snprintf( buff + res, max_size - res, "\t\t}\n\t}\n" );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
+void lua_allocator::print_to_log() const
+    {
+    G_LOG->info( "Lua memory : live = %zu, peak = %zu, reserved = %zu b "
+        "(%zu pages, %lu big blocks).", live_bytes, peak_bytes,
+        get_reserved_bytes(), pages.size(), big_cnt );
+
+    for ( int i = 0; i < C_CLASS_CNT; i++ )
+        {
+        const class_stat& st = classes[ i ];
+        if ( 0 == st.alloc_cnt ) continue;
+
+        G_LOG->debug( "Lua memory : class %3d b : used = %lu, free = %lu, "
+            "allocations = %lu.", ( i + 1 ) * C_CLASS_STEP, st.used_cnt,
+            st.free_cnt, st.alloc_cnt );
+        }
+    }
+//-----------------------------------------------------------------------------
@@ -0,0 +1,109 @@
+/// @file lua_allocator.h
+/// @brief Функция выделения памяти для Lua с пулами блоков.
+///
+/// Lua в основном выделяет небольшие блоки (таблицы, строки, замыкания).
+/// Такие блоки (до @ref lua_allocator::C_MAX_SMALL_SIZE байт) выделяются из
+/// пулов блоков фиксированного размера (классов), память для которых
+/// выделяется крупными страницами и не возвращается системе. Освобожденный
+/// блок повторно используется для блока того же класса, поэтому при
+/// длительной работе куча не фрагментируется. Большие блоки выделяются
+/// через malloc/realloc.
+///
+/// Страницы пулов освобождаются только при удалении объекта (закрытии Lua):
+/// объем полученной памяти (@ref lua_allocator::get_reserved_bytes)
+/// соответствует максимальному количеству одновременно используемых
+/// небольших блоков и после сборки мусора не уменьшается.
+
+#ifndef LUA_ALLOCATOR_H
+#define LUA_ALLOCATOR_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "s_types.h"
+//-----------------------------------------------------------------------------
+/// @brief Функция выделения памяти для Lua (lua_Alloc) с пулами блоков.
+class lua_allocator
+    {
+    public:
+        enum CONSTANTS
+            {
+            C_CLASS_STEP = 16,          ///< Шаг размера блока класса.
+            C_MAX_SMALL_SIZE = 256,     ///< Максимальный размер блока пула.
+            C_CLASS_CNT = C_MAX_SMALL_SIZE / C_CLASS_STEP,
+
+            C_PAGE_SIZE = 16 * 1024,    ///< Размер страницы пула.
+            };
+
+        /// @brief Статистика класса блоков.
+        struct class_stat
+            {
+            u_long used_cnt;    ///< Количество используемых блоков.
+            u_long free_cnt;    ///< Количество свободных блоков.
+            u_long alloc_cnt;   ///< Всего выделений.
+            };
+
+        lua_allocator();
+
+        ~lua_allocator();
+
+        /// @brief Функция выделения памяти (lua_Alloc).
+        ///
+        /// @param ud - указатель на объект lua_allocator.
+        static void* alloc( void* ud, void* ptr, size_t osize, size_t nsize );
+
+        /// @brief Объем памяти, используемой Lua, байт.
+        size_t get_live_bytes() const;
+
+        /// @brief Максимальный объем памяти, используемой Lua, байт.
+        size_t get_peak_bytes() const;
+
+        /// @brief Объем памяти, полученной от системы (страницы пулов и
+        /// большие блоки), байт.
+        size_t get_reserved_bytes() const;
+
+        /// @brief Количество больших блоков.
+        u_long get_big_blocks_cnt() const;
+
+        const class_stat& get_class_stat( int class_n ) const;
+
+        /// @brief Сохранение статистики в виде таблицы Lua.
+        ///
+        /// @return количество записанных байт.
+        int save_as_Lua_str( char* buff, int max_size ) const;
+
+        /// @brief Вывод статистики в лог.
+        void print_to_log() const;
+
+    private:
+        lua_allocator( const lua_allocator& ) = delete;
+        lua_allocator& operator=( const lua_allocator& ) = delete;
+
+        struct free_block
+            {
+            free_block* next;
+            };
+
+        static int get_class( size_t size );
+
+        void* allocate( size_t size );
+        void  deallocate( void* ptr, size_t size );
+        void* reallocate( void* ptr, size_t osize, size_t nsize );
+
+        /// @brief Выделение новой страницы для пула.
+        ///
+        /// @return 0 - успешно.
+        int add_page( int class_n );
+
+        free_block* free_lists[ C_CLASS_CNT ];
+        class_stat  classes[ C_CLASS_CNT ];
+        std::vector< void* > pages;
+
+        size_t live_bytes;
+        size_t peak_bytes;
+        size_t big_bytes;
+        u_long big_cnt;
+    };
+//-----------------------------------------------------------------------------
+#endif // LUA_ALLOCATOR_H
@@ -0,0 +1,196 @@
+#include "lua_gc_mngr.h"
+
+#include "log.h"
+
+auto_smart_ptr < lua_gc_manager > lua_gc_manager::instance;
+
+//Доля оставшегося времени цикла, используемая для сборки мусора.
+static const float SLACK_USAGE = 0.5f;
+//Во сколько раз сборка мусора должна опережать выделение памяти.
+static const float ALLOC_RATE_MUL = 2.f;
+//Коэффициент сглаживания оценок.
+static const float SMOOTH_K = 0.1f;
+//Доля предела памяти, ниже которой превышение считается устраненным.
+static const float LIMIT_HYSTERESIS = 0.9f;
+//-----------------------------------------------------------------------------
+lua_gc_manager* lua_gc_manager::get_instance()
+    {
+    if ( instance.is_null() )
+        {
+        instance = new lua_gc_manager();
+        }
+
+    return instance;
+    }
+//-----------------------------------------------------------------------------
+lua_gc_manager::lua_gc_manager() : cycle_time( C_DEFAULT_CYCLE_TIME ),
+    min_step( C_DEFAULT_MIN_STEP ), max_step( C_DEFAULT_MAX_STEP ),
+    memory_limit( 0 ),
+    full_collect_interval( C_DEFAULT_FULL_COLLECT_INTERVAL ),
+    is_over_limit( false ), is_limit_collected( false ),
+    last_full_collect_time( 0 ),
+    alloc_rate( 0 ), step_time_per_kb( 5 ), last_mem( -1 )
+    {
+    clear_stat();
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::set_cycle_time( u_int new_cycle_time )
+    {
+    cycle_time = new_cycle_time;
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::set_step_limits( u_int new_min_step, u_int new_max_step )
+    {
+    min_step = new_min_step > 0 ? new_min_step : 1;
+    max_step = new_max_step > min_step ? new_max_step : min_step;
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::set_memory_limit( u_int new_memory_limit )
+    {
+    memory_limit = new_memory_limit;
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::set_full_collect_interval( u_int interval )
+    {
+    full_collect_interval = interval;
+    }
+//-----------------------------------------------------------------------------
+u_int lua_gc_manager::get_step_size( u_long slack_time ) const
+    {
+    float step = slack_time * SLACK_USAGE / step_time_per_kb;
+
+    //Сборка мусора должна успевать за выделением памяти, иначе объем
+    //памяти постоянно растет.
+    float step_by_alloc = alloc_rate * ALLOC_RATE_MUL;
+    if ( step < step_by_alloc ) step = step_by_alloc;
+
+    if ( step < min_step ) return min_step;
+    if ( step > max_step ) return max_step;
+
+    return static_cast< u_int >( step );
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::evaluate( lua_State* L, u_long cycle_start_time )
+    {
+    if ( nullptr == L ) return;
+
+    int mem = lua_gc( L, LUA_GCCOUNT, 0 );
+    if ( last_mem >= 0 )
+        {
+        alloc_rate += ( ( mem - last_mem ) - alloc_rate ) * SMOOTH_K;
+        if ( alloc_rate < 0 ) alloc_rate = 0;
+        }
+
+    u_long budget = cycle_time * 1000UL;
+    u_long elapsed = get_delta_millisec( cycle_start_time ) * 1000UL;
+    u_long slack_time = budget > elapsed ? budget - elapsed : 0;
+
+    if ( memory_limit > 0 && !is_over_limit &&
+        static_cast< u_int >( mem ) > memory_limit )
+        {
+        is_over_limit = true;
+        is_limit_collected = false;
+
+        G_LOG->notice( "Lua memory limit exceeded (%d > %u KB).", mem,
+            memory_limit );
+        }
+    else if ( is_over_limit &&
+        ( 0 == memory_limit || mem < memory_limit * LIMIT_HYSTERESIS ) )
+        {
+        is_over_limit = false;
+
+        G_LOG->notice( "Lua memory is below the limit (%d KB).", mem );
+        }
+
+    u_long start_time = get_microsec();
+    if ( is_over_limit )
+        {
+        //Полная сборка мусора - только при большом запасе времени цикла и
+        //не чаще заданного интервала.
+        bool is_interval_elapsed = !is_limit_collected ||
+            get_delta_millisec( last_full_collect_time ) >=
+            full_collect_interval;
+        if ( is_interval_elapsed && slack_time >= budget / 2 )
+            {
+            lua_gc( L, LUA_GCCOLLECT, 0 );
+            full_collect_cnt++;
+            last_step = 0;
+            is_limit_collected = true;
+            last_full_collect_time = get_millisec();
+            }
+        else
+            {
+            last_step = max_step;
+            lua_gc( L, LUA_GCSTEP, last_step );
+            }
+        }
+    else
+        {
+        last_step = get_step_size( slack_time );
+        lua_gc( L, LUA_GCSTEP, last_step );
+        }
+    last_gc_time = get_delta_microsec( start_time );
+
+    if ( last_step > 0 )
+        {
+        float time_per_kb = static_cast< float >( last_gc_time ) / last_step;
+        step_time_per_kb += ( time_per_kb - step_time_per_kb ) * SMOOTH_K;
+        //Оценка не должна становиться нулевой (при очень быстром шаге).
+        if ( step_time_per_kb < 0.01f ) step_time_per_kb = 0.01f;
+        }
+
+    last_mem = lua_gc( L, LUA_GCCOUNT, 0 );
+
+    if ( last_gc_time > max_gc_time ) max_gc_time = last_gc_time;
+    all_gc_time += last_gc_time;
+    cycles_cnt++;
+    }
+//-----------------------------------------------------------------------------
+float lua_gc_manager::get_alloc_rate() const
+    {
+    return alloc_rate;
+    }
+//-----------------------------------------------------------------------------
+float lua_gc_manager::get_step_time_per_kb() const
+    {
+    return step_time_per_kb;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_gc_manager::get_last_gc_time() const
+    {
+    return last_gc_time;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_gc_manager::get_max_gc_time() const
+    {
+    return max_gc_time;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_gc_manager::get_avg_gc_time() const
+    {
+    return cycles_cnt ? static_cast< u_long >( all_gc_time / cycles_cnt ) : 0;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_gc_manager::get_full_collect_cnt() const
+    {
+    return full_collect_cnt;
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::print_to_log() const
+    {
+    G_LOG->info( "Lua GC performance : avg = %lu, max = %lu us (%lu cycles), "
+        "full collections = %lu, alloc rate = %.1f KB/cycle, "
+        "step time = %.2f us/KB.", get_avg_gc_time(), max_gc_time,
+        cycles_cnt, full_collect_cnt, alloc_rate, step_time_per_kb );
+    }
+//-----------------------------------------------------------------------------
+void lua_gc_manager::clear_stat()
+    {
+    last_gc_time = 0;
+    max_gc_time = 0;
+    all_gc_time = 0;
+    cycles_cnt = 0;
+    full_collect_cnt = 0;
+    last_step = 0;
+    }
+//-----------------------------------------------------------------------------
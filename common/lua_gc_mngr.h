@@ -0,0 +1,127 @@
+/// @file lua_gc_mngr.h
+/// @brief Управление сборкой мусора Lua в основном цикле.
+///
+/// Вместо шага сборки мусора фиксированного размера размер шага выбирается
+/// каждый цикл: по оставшемуся до конца цикла времени (с учетом измеренной
+/// скорости сборки) и не меньше, чем требуется для того, чтобы сборка
+/// успевала за выделением памяти скриптами (по изменению LUA_GCCOUNT).
+///
+/// При превышении заданного предела памяти выполняется полная сборка мусора,
+/// но только в цикле с большим запасом времени и не чаще одного раза за
+/// заданный интервал, иначе - шаг максимального размера. Превышение
+/// считается устраненным, когда объем памяти становится меньше предела
+/// с учетом гистерезиса.
+
+#ifndef LUA_GC_MNGR_H
+#define LUA_GC_MNGR_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include    "lua.h"
+
+#ifdef  __cplusplus
+    };
+#endif
+
+#include "smart_ptr.h"
+#include "dtime.h"
+//-----------------------------------------------------------------------------
+/// @brief Управление сборкой мусора Lua.
+class lua_gc_manager
+    {
+    public:
+        enum CONSTANTS
+            {
+            C_DEFAULT_CYCLE_TIME = 50,  ///< Время цикла по умолчанию, мс.
+            C_DEFAULT_MIN_STEP = 20,    ///< Минимальный шаг по умолчанию, КБ.
+            C_DEFAULT_MAX_STEP = 1000,  ///< Максимальный шаг по умолчанию, КБ.
+
+            /// Минимальный интервал между полными сборками по умолчанию, мс.
+            C_DEFAULT_FULL_COLLECT_INTERVAL = 10000,
+            };
+
+        /// @brief Получение единственного экземпляра класса.
+        static lua_gc_manager* get_instance();
+
+        /// @brief Задание требуемого времени цикла, мс.
+        void set_cycle_time( u_int cycle_time );
+
+        /// @brief Задание пределов размера шага сборки мусора, КБ.
+        void set_step_limits( u_int min_step, u_int max_step );
+
+        /// @brief Задание предела памяти Lua, КБ (0 - без ограничения).
+        void set_memory_limit( u_int memory_limit );
+
+        /// @brief Задание минимального интервала между полными сборками
+        /// мусора при превышении предела памяти, мс.
+        void set_full_collect_interval( u_int interval );
+
+        /// @brief Выполнение шага сборки мусора.
+        ///
+        /// Вызывается в конце каждого цикла.
+        ///
+        /// @param L                - состояние Lua.
+        /// @param cycle_start_time - время начала цикла, мс (get_millisec()).
+        void evaluate( lua_State* L, u_long cycle_start_time );
+
+        /// @brief Расчет размера шага сборки мусора, КБ.
+        ///
+        /// @param slack_time - оставшееся время цикла, мкс.
+        u_int get_step_size( u_long slack_time ) const;
+
+        /// @brief Оценка скорости выделения памяти, КБ за цикл.
+        float get_alloc_rate() const;
+
+        /// @brief Оценка времени сборки мусора, мкс на 1 КБ шага.
+        float get_step_time_per_kb() const;
+
+        /// @brief Время сборки мусора в последнем цикле, мкс.
+        u_long get_last_gc_time() const;
+
+        /// @brief Максимальное время сборки мусора в цикле, мкс.
+        u_long get_max_gc_time() const;
+
+        /// @brief Среднее время сборки мусора в цикле, мкс.
+        u_long get_avg_gc_time() const;
+
+        /// @brief Количество выполненных полных сборок мусора.
+        u_long get_full_collect_cnt() const;
+
+        /// @brief Вывод статистики в лог.
+        void print_to_log() const;
+
+        /// @brief Сброс статистики.
+        void clear_stat();
+
+    private:
+        lua_gc_manager();
+
+        u_int cycle_time;
+        u_int min_step;
+        u_int max_step;
+        u_int memory_limit;
+        u_int full_collect_interval;
+
+        bool   is_over_limit;        ///< Предел памяти превышен.
+        bool   is_limit_collected;   ///< Выполнялась полная сборка при превышении.
+        u_long last_full_collect_time;
+
+        float alloc_rate;       ///< Выделение памяти, КБ/цикл.
+        float step_time_per_kb; ///< Время сборки, мкс/КБ.
+        int   last_mem;         ///< Память после сборки в прошлом цикле, КБ.
+
+        u_long last_gc_time;
+        u_long max_gc_time;
+        unsigned long long all_gc_time;
+        u_long cycles_cnt;
+        u_long full_collect_cnt;
+        u_int  last_step;
+
+        static auto_smart_ptr < lua_gc_manager > instance;
+    };
+//-----------------------------------------------------------------------------
+#define G_LUA_GC_MANAGER lua_gc_manager::get_instance()
+//-----------------------------------------------------------------------------
+#endif // LUA_GC_MNGR_H
@@ -0,0 +1,714 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "lua_hot_reload.h"
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include    "lauxlib.h"
+
+#ifdef  __cplusplus
+    };
+#endif
+
+#include "lua_manager.h"
+#include "log.h"
+
+auto_smart_ptr < lua_hot_reload > lua_hot_reload::instance;
+//-----------------------------------------------------------------------------
+static int dump_writer( lua_State*, const void* p, size_t size, void* ud )
+    {
+    static_cast< std::string* >( ud )->append(
+        static_cast< const char* >( p ), size );
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+/// @brief Удаление из байт-кода функции (формат lua_dump Lua 5.1) имени файла
+/// и номеров строк.
+///
+/// Они изменяются у всех функций ниже вставленной (удаленной) строки, поэтому
+/// не должны учитываться при сравнении функций.
+class line_info_stripper
+    {
+    public:
+        line_info_stripper( const std::string& code ) : code( code ), pos( 0 ),
+            instr_size( 0 ), number_size( 0 )
+            {
+            }
+
+        /// @return false - неизвестный формат байт-кода.
+        bool strip( std::string& res )
+            {
+            //Заголовок: сигнатура, версия, формат, порядок байт, размеры
+            //int, size_t, Instruction, lua_Number, признак целых чисел.
+            const size_t HEADER_SIZE = 12;
+            if ( code.size() < HEADER_SIZE ||
+                static_cast< u_char >( code[ 7 ] ) != sizeof( int ) ||
+                static_cast< u_char >( code[ 8 ] ) != sizeof( size_t ) ) return false;
+            instr_size = static_cast< u_char >( code[ 9 ] );
+            number_size = static_cast< u_char >( code[ 10 ] );
+
+            res.assign( code, 0, HEADER_SIZE );
+            pos = HEADER_SIZE;
+            return strip_function( res ) && pos == code.size();
+            }
+
+    private:
+        bool copy( size_t size, std::string* res )
+            {
+            if ( size > code.size() - pos ) return false;
+
+            if ( res ) res->append( code, pos, size );
+            pos += size;
+            return true;
+            }
+
+        bool read_int( int& value, std::string* res )
+            {
+            if ( sizeof( value ) > code.size() - pos ) return false;
+
+            memcpy( &value, code.data() + pos, sizeof( value ) );
+            return copy( sizeof( value ), res ) && value >= 0;
+            }
+
+        bool copy_string( std::string* res )
+            {
+            size_t size = 0;
+            if ( sizeof( size ) > code.size() - pos ) return false;
+
+            memcpy( &size, code.data() + pos, sizeof( size ) );
+            return copy( sizeof( size ), res ) && copy( size, res );
+            }
+
+        bool copy_array( size_t item_size, std::string* res )
+            {
+            int cnt = 0;
+            return read_int( cnt, res ) && copy( cnt * item_size, res );
+            }
+
+        bool strip_function( std::string& res )
+            {
+            int cnt = 0;
+
+            //Имя файла, строки начала и конца функции - пропускаются.
+            if ( !copy_string( nullptr ) || !copy( 2 * sizeof( int ), nullptr ) )
+                {
+                return false;
+                }
+
+            //Количество upvalue и параметров, vararg, размер стека, код.
+            if ( !copy( 4, &res ) || !copy_array( instr_size, &res ) )
+                {
+                return false;
+                }
+
+            //Константы.
+            if ( !read_int( cnt, &res ) ) return false;
+            for ( int i = 0; i < cnt; i++ )
+                {
+                if ( !copy( 1, &res ) ) return false;
+
+                bool is_ok = true;
+                switch ( code[ pos - 1 ] )
+                    {
+                    case LUA_TNIL:
+                        break;
+
+                    case LUA_TBOOLEAN:
+                        is_ok = copy( 1, &res );
+                        break;
+
+                    case LUA_TNUMBER:
+                        is_ok = copy( number_size, &res );
+                        break;
+
+                    case LUA_TSTRING:
+                        is_ok = copy_string( &res );
+                        break;
+
+                    default:
+                        is_ok = false;
+                        break;
+                    }
+                if ( !is_ok ) return false;
+                }
+
+            //Вложенные функции.
+            if ( !read_int( cnt, &res ) ) return false;
+            for ( int i = 0; i < cnt; i++ )
+                {
+                if ( !strip_function( res ) ) return false;
+                }
+
+            //Номера строк инструкций - пропускаются.
+            if ( !copy_array( sizeof( int ), nullptr ) ) return false;
+
+            //Локальные переменные (имя, диапазон инструкций).
+            if ( !read_int( cnt, &res ) ) return false;
+            for ( int i = 0; i < cnt; i++ )
+                {
+                if ( !copy_string( &res ) || !copy( 2 * sizeof( int ), &res ) )
+                    {
+                    return false;
+                    }
+                }
+
+            //Имена upvalue.
+            if ( !read_int( cnt, &res ) ) return false;
+            for ( int i = 0; i < cnt; i++ )
+                {
+                if ( !copy_string( &res ) ) return false;
+                }
+
+            return true;
+            }
+
+        const std::string& code;
+        size_t pos;
+
+        size_t instr_size;
+        size_t number_size;
+    };
+//-----------------------------------------------------------------------------
+/// @brief Байт-код функции из вершины стека без информации о строках.
+static std::string dump_function( lua_State* L )
+    {
+    std::string code;
+    lua_dump( L, dump_writer, &code );
+
+    std::string res;
+    line_info_stripper stripper( code );
+    return stripper.strip( res ) ? res : code;
+    }
+//-----------------------------------------------------------------------------
+lua_hot_reload* lua_hot_reload::get_instance()
+    {
+    if ( instance.is_null() )
+        {
+        instance = new lua_hot_reload();
+        }
+
+    return instance;
+    }
+//-----------------------------------------------------------------------------
+lua_hot_reload::lua_hot_reload() : L( nullptr ), state( S_IDLE ),
+    chunk_ref( LUA_NOREF ), env_ref( LUA_NOREF ), shadows_ref( LUA_NOREF ),
+    cursor( 0 ),
+    budget( C_DEFAULT_BUDGET ), start_time( 0 ), latency( 0 ),
+    max_step_time( 0 ), changed_cnt( 0 )
+    {
+    }
+//-----------------------------------------------------------------------------
+void lua_hot_reload::set_budget( u_long new_budget )
+    {
+    budget = new_budget;
+    }
+//-----------------------------------------------------------------------------
+int lua_hot_reload::start( const char* new_path )
+    {
+    if ( S_LOAD == state || S_DIFF == state )
+        {
+        G_LOG->warning( "Lua hot reload of \"%s\" is already in progress.",
+            path.c_str() );
+        return 1;
+        }
+
+    path = new_path;
+    err.clear();
+    candidates.clear();
+    cursor = 0;
+    latency = 0;
+    max_step_time = 0;
+    changed_cnt = 0;
+    start_time = get_microsec();
+
+    L = G_LUA_MANAGER->get_Lua();
+    if ( nullptr == L )
+        {
+        err = "Lua is not initialized";
+        state = S_ERROR;
+        return 1;
+        }
+
+    G_LOG->notice( "Start Lua hot reload of \"%s\".", path.c_str() );
+    state = S_LOAD;
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+void lua_hot_reload::evaluate()
+    {
+    if ( S_LOAD != state && S_DIFF != state ) return;
+
+    if ( L != G_LUA_MANAGER->get_Lua() )
+        {
+        err = "Lua state was changed";
+        finish( S_ERROR );
+        G_LOG->error( "Lua hot reload of \"%s\" - %s.", path.c_str(),
+            err.c_str() );
+        return;
+        }
+
+    u_long step_start = get_microsec();
+    int top = lua_gettop( L );
+
+    //Компиляция и выполнение скрипта не ограничиваются временем шага,
+    //поэтому выполняются в отдельных циклах.
+    if ( S_LOAD == state )
+        {
+        if ( LUA_NOREF == chunk_ref )
+            {
+            if ( compile() ) finish( S_ERROR );
+            }
+        else if ( load() )
+            {
+            finish( S_ERROR );
+            }
+        else
+            {
+            state = S_DIFF;
+            }
+        }
+    else if ( S_DIFF == state )
+        {
+        if ( diff( step_start ) )
+            {
+            apply();
+            finish( S_DONE );
+            }
+        }
+
+    lua_settop( L, top );
+
+    u_long step_time = get_delta_microsec( step_start );
+    if ( step_time > max_step_time ) max_step_time = step_time;
+
+    if ( S_DONE == state )
+        {
+        G_LOG->notice( "Lua hot reload of \"%s\" - Ok (%u changed, %u "
+            "unchanged functions, latency %lu us, max step %lu us).",
+            path.c_str(), changed_cnt, get_unchanged_cnt(), latency,
+            max_step_time );
+        }
+    else if ( S_ERROR == state )
+        {
+        G_LOG->error( "Lua hot reload of \"%s\" - %s.", path.c_str(),
+            err.c_str() );
+        }
+    }
+//-----------------------------------------------------------------------------
+int lua_hot_reload::compile()
+    {
+    if ( G_LUA_MANAGER->load_file( path.c_str() ) != 0 )
+        {
+        err = lua_tostring( L, -1 );
+        return 1;
+        }
+
+    chunk_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+int lua_hot_reload::load()
+    {
+    lua_rawgeti( L, LUA_REGISTRYINDEX, chunk_ref );
+    luaL_unref( L, LUA_REGISTRYINDEX, chunk_ref );
+    chunk_ref = LUA_NOREF;
+    int chunk = lua_gettop( L );
+
+    //Окружение скрипта: чтение - из глобальных переменных (для объектов -
+    //тени), запись - в окружение.
+    lua_newtable( L );
+    int env = lua_gettop( L );
+    lua_newtable( L );
+    int shadows = lua_gettop( L );
+
+    lua_newtable( L );
+    lua_pushvalue( L, shadows );
+    lua_pushcclosure( L, env_index, 1 );
+    lua_setfield( L, -2, "__index" );
+    lua_setmetatable( L, env );
+
+    lua_pushvalue( L, env );
+    lua_setfenv( L, chunk );
+    lua_pushvalue( L, chunk );
+    if ( lua_pcall( L, 0, 0, 0 ) != 0 )
+        {
+        err = lua_tostring( L, -1 );
+        return 1;
+        }
+
+    //Функции, записанные в тени объектов.
+    lua_pushnil( L );
+    while ( lua_next( L, shadows ) )
+        {
+        int shadow = lua_gettop( L );
+
+        //Объект мог быть заменен скриптом - он не перезагружается.
+        lua_pushvalue( L, -2 );
+        lua_rawget( L, env );
+        bool is_shadow = LUA_TSTRING == lua_type( L, -3 ) &&
+            lua_rawequal( L, -1, shadow );
+        lua_pop( L, 1 );
+
+        if ( is_shadow )
+            {
+            std::string object = lua_tostring( L, -2 );
+
+            lua_pushnil( L );
+            while ( lua_next( L, shadow ) )
+                {
+                if ( LUA_TSTRING == lua_type( L, -2 ) && lua_isfunction( L, -1 ) )
+                    {
+                    candidates.push_back( { object, lua_tostring( L, -2 ),
+                        false } );
+                    }
+                lua_pop( L, 1 );
+                }
+            }
+        lua_pop( L, 1 );
+        }
+
+    //Глобальные функции.
+    lua_pushnil( L );
+    while ( lua_next( L, env ) )
+        {
+        if ( LUA_TSTRING == lua_type( L, -2 ) && lua_isfunction( L, -1 ) )
+            {
+            candidates.push_back( { "", lua_tostring( L, -2 ), false } );
+            }
+        lua_pop( L, 1 );
+        }
+
+    shadows_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+    env_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+bool lua_hot_reload::diff( u_long step_start )
+    {
+    while ( cursor < candidates.size() )
+        {
+        candidate& c = candidates[ cursor ];
+
+        push_function( c, true );
+        push_function( c, false );
+        int top = lua_gettop( L );
+        c.is_changed = !is_equal_functions( L, top - 1, top );
+        lua_pop( L, 2 );
+
+        cursor++;
+        if ( get_delta_microsec( step_start ) >= budget ) break;
+        }
+
+    return cursor >= candidates.size();
+    }
+//-----------------------------------------------------------------------------
+void lua_hot_reload::apply()
+    {
+    //Соответствие теней объектам.
+    lua_newtable( L );
+    int objects = lua_gettop( L );
+    lua_rawgeti( L, LUA_REGISTRYINDEX, shadows_ref );
+    lua_pushnil( L );
+    while ( lua_next( L, -2 ) )
+        {
+        lua_getmetatable( L, -1 );
+        lua_getfield( L, -1, "__index" );
+        lua_remove( L, -2 );
+        lua_rawset( L, objects );
+        }
+    lua_pop( L, 1 );
+    lua_newtable( L );
+    int visited = lua_gettop( L );
+
+    for ( auto& c : candidates )
+        {
+        if ( !c.is_changed ) continue;
+
+        //Новая функция выполняется в глобальном окружении и с объектами
+        //вместо их теней.
+        push_function( c, true );
+        lua_pushvalue( L, LUA_GLOBALSINDEX );
+        lua_setfenv( L, -2 );
+        replace_shadows( L, lua_gettop( L ), objects, visited );
+
+        if ( c.object.empty() )
+            {
+            lua_setfield( L, LUA_GLOBALSINDEX, c.name.c_str() );
+            }
+        else
+            {
+            lua_getfield( L, LUA_GLOBALSINDEX, c.object.c_str() );
+            if ( !lua_istable( L, -1 ) && !lua_isuserdata( L, -1 ) )
+                {
+                lua_pop( L, 2 );
+                continue;
+                }
+            lua_insert( L, -2 );
+            lua_setfield( L, -2, c.name.c_str() );
+            lua_pop( L, 1 );
+            }
+
+        changed_cnt++;
+        }
+
+    //Вложенные функции, созданные скриптом, сохраняют окружение скрипта,
+    //поэтому оно делается прозрачным - все обращения переадресуются в
+    //глобальное окружение.
+    lua_rawgeti( L, LUA_REGISTRYINDEX, env_ref );
+    int env = lua_gettop( L );
+    lua_pushnil( L );
+    while ( lua_next( L, env ) )
+        {
+        lua_pop( L, 1 );
+        lua_pushvalue( L, -1 );
+        lua_pushnil( L );
+        lua_rawset( L, env );
+        }
+    lua_newtable( L );
+    lua_pushvalue( L, LUA_GLOBALSINDEX );
+    lua_setfield( L, -2, "__index" );
+    lua_pushvalue( L, LUA_GLOBALSINDEX );
+    lua_setfield( L, -2, "__newindex" );
+    lua_setmetatable( L, env );
+    lua_pop( L, 3 );
+
+    G_LUA_MANAGER->clear_functions_cache();
+    }
+//-----------------------------------------------------------------------------
+void lua_hot_reload::push_function( const candidate& c, bool is_new ) const
+    {
+    int top = lua_gettop( L );
+
+    if ( is_new )
+        {
+        if ( c.object.empty() )
+            {
+            lua_rawgeti( L, LUA_REGISTRYINDEX, env_ref );
+            }
+        else
+            {
+            lua_rawgeti( L, LUA_REGISTRYINDEX, shadows_ref );
+            lua_getfield( L, -1, c.object.c_str() );
+            }
+        lua_pushstring( L, c.name.c_str() );
+        lua_rawget( L, -2 );
+        }
+    else
+        {
+        if ( c.object.empty() )
+            {
+            lua_getfield( L, LUA_GLOBALSINDEX, c.name.c_str() );
+            return;
+            }
+
+        lua_getfield( L, LUA_GLOBALSINDEX, c.object.c_str() );
+        if ( lua_istable( L, -1 ) || lua_isuserdata( L, -1 ) )
+            {
+            lua_getfield( L, -1, c.name.c_str() );
+            }
+        else
+            {
+            lua_pushnil( L );
+            }
+        }
+
+    lua_replace( L, top + 1 );
+    lua_settop( L, top + 1 );
+    }
+//-----------------------------------------------------------------------------
+bool lua_hot_reload::is_equal_functions( lua_State* L, int f1, int f2 )
+    {
+    if ( !lua_isfunction( L, f2 ) ) return false;
+    if ( lua_iscfunction( L, f1 ) || lua_iscfunction( L, f2 ) )
+        {
+        return lua_rawequal( L, f1, f2 ) != 0;
+        }
+
+    lua_pushvalue( L, f1 );
+    std::string code1 = dump_function( L );
+    lua_pop( L, 1 );
+    lua_pushvalue( L, f2 );
+    std::string code2 = dump_function( L );
+    lua_pop( L, 1 );
+    if ( code1 != code2 ) return false;
+
+    //Значения локальных переменных скрипта (например, констант) не входят
+    //в байт-код функции.
+    for ( int i = 1; ; i++ )
+        {
+        const char* n1 = lua_getupvalue( L, f1, i );
+        const char* n2 = lua_getupvalue( L, f2, i );
+        if ( nullptr == n1 && nullptr == n2 ) return true;
+        if ( nullptr == n1 || nullptr == n2 )
+            {
+            lua_pop( L, 1 );
+            return false;
+            }
+
+        //Объекты в upvalue новой функции - тени, поэтому сравниваются
+        //только простые значения.
+        bool is_equal = true;
+        if ( is_simple_value( L, -2 ) || is_simple_value( L, -1 ) )
+            {
+            is_equal = lua_type( L, -2 ) == lua_type( L, -1 ) &&
+                lua_rawequal( L, -2, -1 );
+            }
+        lua_pop( L, 2 );
+
+        if ( !is_equal ) return false;
+        }
+    }
+//-----------------------------------------------------------------------------
+bool lua_hot_reload::is_simple_value( lua_State* L, int idx )
+    {
+    int t = lua_type( L, idx );
+    return LUA_TNIL == t || LUA_TNUMBER == t || LUA_TSTRING == t ||
+        LUA_TBOOLEAN == t;
+    }
+//-----------------------------------------------------------------------------
+void lua_hot_reload::replace_shadows( lua_State* L, int f, int objects,
+    int visited )
+    {
+    if ( !lua_isfunction( L, f ) || lua_iscfunction( L, f ) ) return;
+
+    lua_pushvalue( L, f );
+    lua_rawget( L, visited );
+    bool is_visited = !lua_isnil( L, -1 );
+    lua_pop( L, 1 );
+    if ( is_visited ) return;
+
+    lua_pushvalue( L, f );
+    lua_pushboolean( L, 1 );
+    lua_rawset( L, visited );
+
+    for ( int i = 1; lua_getupvalue( L, f, i ); i++ )
+        {
+        lua_pushvalue( L, -1 );
+        lua_rawget( L, objects );
+        if ( !lua_isnil( L, -1 ) )
+            {
+            lua_setupvalue( L, f, i );
+            }
+        else
+            {
+            lua_pop( L, 1 );
+            //Вложенные функции (например, локальные функции скрипта).
+            replace_shadows( L, lua_gettop( L ), objects, visited );
+            }
+        lua_pop( L, 1 );
+        }
+    }
+//-----------------------------------------------------------------------------
+int lua_hot_reload::env_index( lua_State* L )
+    {
+    //Параметры: окружение, ключ.
+    lua_pushvalue( L, 2 );
+    lua_gettable( L, LUA_GLOBALSINDEX );
+
+    int t = lua_type( L, -1 );
+    if ( LUA_TSTRING != lua_type( L, 2 ) ||
+        ( LUA_TTABLE != t && LUA_TUSERDATA != t ) )
+        {
+        return 1;
+        }
+
+    //Тень объекта: чтение - из объекта, запись - в тень.
+    lua_newtable( L );
+    lua_newtable( L );
+    lua_pushvalue( L, -3 );
+    lua_setfield( L, -2, "__index" );
+    lua_setmetatable( L, -2 );
+
+    lua_pushvalue( L, 2 );
+    lua_pushvalue( L, -2 );
+    lua_settable( L, lua_upvalueindex( 1 ) );
+
+    lua_pushvalue( L, 2 );
+    lua_pushvalue( L, -2 );
+    lua_rawset( L, 1 );
+
+    return 1;
+    }
+//-----------------------------------------------------------------------------
+void lua_hot_reload::finish( STATE new_state )
+    {
+    luaL_unref( L, LUA_REGISTRYINDEX, chunk_ref );
+    chunk_ref = LUA_NOREF;
+    luaL_unref( L, LUA_REGISTRYINDEX, env_ref );
+    luaL_unref( L, LUA_REGISTRYINDEX, shadows_ref );
+    env_ref = LUA_NOREF;
+    shadows_ref = LUA_NOREF;
+
+    latency = get_delta_microsec( start_time );
+    state = new_state;
+    }
+//-----------------------------------------------------------------------------
+lua_hot_reload::STATE lua_hot_reload::get_state() const
+    {
+    return state;
+    }
+//-----------------------------------------------------------------------------
+u_int lua_hot_reload::get_changed_cnt() const
+    {
+    return changed_cnt;
+    }
+//-----------------------------------------------------------------------------
+u_int lua_hot_reload::get_unchanged_cnt() const
+    {
+    u_int res = 0;
+    for ( size_t i = 0; i < cursor; i++ )
+        {
+        if ( !candidates[ i ].is_changed ) res++;
+        }
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_hot_reload::get_latency() const
+    {
+    return latency;
+    }
+//-----------------------------------------------------------------------------
+u_long lua_hot_reload::get_max_step_time() const
+    {
+    return max_step_time;
+    }
+//-----------------------------------------------------------------------------
+int lua_hot_reload::save_as_Lua_str( char* buff, int max_size ) const
+    {
+    //Сообщение об ошибке Lua может содержать кавычки и переводы строк.
+    std::string err_str;
+    for ( auto ch : err )
+        {
+        if ( '"' == ch || '\\' == ch ) err_str += '\\';
+        err_str += '\n' == ch ? ' ' : ch;
+        }
+
+    int res = snprintf( buff, max_size,
+        "hot_reload =\n\t{\n\tstate = %d, path = \"%s\",\n\tchanged = %u, "
+        "unchanged = %u, latency = %lu, max_step_time = %lu,\n\t"
+        "err = \"%s\",\n\tfunctions =\n\t\t{\n",
+        state, path.c_str(), changed_cnt, get_unchanged_cnt(), latency,
+        max_step_time, err_str.c_str() );
+
+    for ( size_t i = 0; i < candidates.size() && res < max_size; i++ )
+        {
+        const candidate& c = candidates[ i ];
+        if ( !c.is_changed ) continue;
+
+        res += snprintf( buff + res, max_size - res, "\t\t\"%s%s%s\",\n",
+            c.object.c_str(), c.object.empty() ? "" : ":", c.name.c_str() );
+        }
+
+    if ( res < max_size )
+        {
+        res += snprintf( buff + res, max_size - res, "\t\t}\n\t}\n" );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
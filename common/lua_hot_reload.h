@@ -0,0 +1,176 @@
+/// @file lua_hot_reload.h
+/// @brief Горячая перезагрузка функций объектов Lua без повторной
+/// инициализации.
+///
+/// Скрипт выполняется в отдельном окружении: обращение к существующей
+/// глобальной таблице (объекту) возвращает ее "тень" - таблицу, чтение из
+/// которой переадресуется исходной таблице, а запись остается в тени. Таким
+/// образом выполнение скрипта не изменяет состояние объектов.
+///
+/// Затем функции, записанные в тени объектов и в окружение скрипта,
+/// сравниваются с текущими (по байт-коду без информации о строках и
+/// значениям простых upvalue), и заменяются только изменившиеся функции.
+/// Остальные значения (состояние объектов) не изменяются.
+///
+/// Перезагрузка выполняется по шагам в основном цикле (@ref evaluate), по
+/// одному шагу в цикле: компиляция скрипта, выполнение скрипта, сравнение
+/// функций (прерывается при превышении заданного времени и продолжается в
+/// следующем цикле), замена функций. Компиляция скрипта неделима, ее время
+/// ограничивается только размером скрипта (учитывается в
+/// @ref get_max_step_time).
+///
+/// Управление - командой @ref device_communicator::CMD_LUA_HOT_RELOAD.
+
+#ifndef LUA_HOT_RELOAD_H
+#define LUA_HOT_RELOAD_H
+
+#include <string>
+#include <vector>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include    "lua.h"
+
+#ifdef  __cplusplus
+    };
+#endif
+
+#include "smart_ptr.h"
+#include "dtime.h"
+//-----------------------------------------------------------------------------
+/// @brief Горячая перезагрузка функций объектов Lua.
+class lua_hot_reload
+    {
+    public:
+        enum STATE
+            {
+            S_IDLE = 0, ///< Перезагрузка не выполнялась.
+            S_LOAD,     ///< Ожидание загрузки скрипта.
+            S_DIFF,     ///< Сравнение функций.
+            S_DONE,     ///< Перезагрузка завершена.
+            S_ERROR,    ///< Ошибка перезагрузки.
+            };
+
+        enum CONSTANTS
+            {
+            C_DEFAULT_BUDGET = 5000,    ///< Время на шаг по умолчанию, мкс.
+            };
+
+        /// @brief Получение единственного экземпляра класса.
+        static lua_hot_reload* get_instance();
+
+        /// @brief Задание максимального времени шага перезагрузки в цикле,
+        /// мкс.
+        void set_budget( u_long budget );
+
+        /// @brief Запуск перезагрузки.
+        ///
+        /// Сама перезагрузка выполняется далее в основном цикле.
+        ///
+        /// @param path - путь к скрипту.
+        ///
+        /// @return 0 - перезагрузка запущена, 1 - предыдущая перезагрузка еще
+        /// не завершена.
+        int start( const char* path );
+
+        /// @brief Выполнение шага перезагрузки (вызывается в основном цикле).
+        void evaluate();
+
+        STATE get_state() const;
+
+        /// @brief Количество замененных функций.
+        u_int get_changed_cnt() const;
+
+        /// @brief Количество неизменившихся функций.
+        u_int get_unchanged_cnt() const;
+
+        /// @brief Время от запуска до завершения перезагрузки, мкс.
+        u_long get_latency() const;
+
+        /// @brief Максимальное время шага перезагрузки в цикле, мкс.
+        u_long get_max_step_time() const;
+
+        /// @brief Сохранение состояния перезагрузки в виде таблицы Lua.
+        ///
+        /// @return количество записанных байт.
+        int save_as_Lua_str( char* buff, int max_size ) const;
+
+    private:
+        lua_hot_reload();
+
+        /// @brief Функция (новая) из окружения скрипта.
+        struct candidate
+            {
+            std::string object;     ///< Пустая строка - глобальная функция.
+            std::string name;
+            bool is_changed;
+            };
+
+        /// @brief Компиляция скрипта.
+        ///
+        /// @return 0 - успешно.
+        int compile();
+
+        /// @brief Выполнение скомпилированного скрипта в отдельном
+        /// окружении.
+        ///
+        /// @return 0 - успешно.
+        int load();
+
+        /// @brief Сравнение очередных функций в пределах времени шага.
+        ///
+        /// @return true - все функции сравнены.
+        bool diff( u_long start_time );
+
+        /// @brief Замена изменившихся функций.
+        void apply();
+
+        /// @brief Помещение в стек новой (is_new = true) или текущей функции.
+        void push_function( const candidate& c, bool is_new ) const;
+
+        void finish( STATE new_state );
+
+        static bool is_equal_functions( lua_State* L, int f1, int f2 );
+
+        static bool is_simple_value( lua_State* L, int idx );
+
+        /// @brief Замена теней объектов в upvalue функции (и вложенных
+        /// функций) самими объектами.
+        ///
+        /// @param f       - индекс функции в стеке.
+        /// @param objects - индекс таблицы соответствия теней объектам.
+        /// @param visited - индекс таблицы обработанных функций.
+        static void replace_shadows( lua_State* L, int f, int objects,
+            int visited );
+
+        /// @brief Обработчик чтения глобальной переменной в окружении
+        /// скрипта (создание тени объекта).
+        static int env_index( lua_State* L );
+
+        lua_State* L;
+
+        STATE state;
+        std::string path;
+        std::string err;
+
+        int chunk_ref;      ///< Скомпилированный скрипт.
+        int env_ref;        ///< Окружение скрипта.
+        int shadows_ref;    ///< Тени объектов, ключ - имя объекта.
+
+        std::vector< candidate > candidates;
+        size_t cursor;
+
+        u_long budget;
+        u_long start_time;
+        u_long latency;
+        u_long max_step_time;
+        u_int  changed_cnt;
+
+        static auto_smart_ptr < lua_hot_reload > instance;
+    };
+//-----------------------------------------------------------------------------
+#define G_LUA_HOT_RELOAD lua_hot_reload::get_instance()
+//-----------------------------------------------------------------------------
+#endif // LUA_HOT_RELOAD_H
@@ -6,17 +6,74 @@
 #include <Windows.h>
 #endif // OS_WIN
 
+#include <cstdio>
+#include <vector>
+
+#include "zlib.h"
+
 #include "lua_manager.h"
 
 #include "prj_mngr.h"
 #include "PAC_dev.h"
 #include "tech_def.h"
 #include "modbus_serv.h"
+#include "subscription_mngr.h"
+#include "lua_profiler.h"
 
 #include "log.h"
 //-----------------------------------------------------------------------------
 auto_smart_ptr< lua_manager > lua_manager::instance;
 bool lua_manager::is_print_stack_traceback = true;
+bool lua_manager::is_use_functions_cache = true;
+bool lua_manager::is_use_bytecode_cache = true;
+//-----------------------------------------------------------------------------
+/// @brief Заголовок файла кэша байт-кода.
+struct bytecode_header
+    {
+    char    signature[ 4 ];
+    u_int_4 lua_version;
+    u_int_4 src_size;       ///< Размер исходного текста.
+    u_int_4 src_crc;        ///< CRC32 исходного текста.
+    u_int_4 size;           ///< Размер байт-кода.
+    };
+
+static const char BYTECODE_SIGNATURE[] = "PBC1";
+static const char BYTECODE_EXT[] = ".luac";
+//-----------------------------------------------------------------------------
+static int read_file( const char* path, std::vector< char >& data )
+    {
+    FILE* f = fopen( path, "rb" );
+    if ( nullptr == f ) return 1;
+
+    int res = 0;
+    fseek( f, 0, SEEK_END );
+    long size = ftell( f );
+    fseek( f, 0, SEEK_SET );
+    if ( size < 0 )
+        {
+        res = 1;
+        }
+    else
+        {
+        data.resize( size );
+        if ( size > 0 && fread( data.data(), 1, size, f ) != ( size_t ) size )
+            {
+            res = 1;
+            }
+        }
+
+    fclose( f );
+    return res;
+    }
+//-----------------------------------------------------------------------------
+static int bytecode_writer( lua_State*, const void* p, size_t size,
+    void* ud )
+    {
+    auto data = static_cast< std::vector< char >* >( ud );
+    auto bytes = static_cast< const char* >( p );
+    data->insert( data->end(), bytes, bytes + size );
+    return 0;
+    }
 //-----------------------------------------------------------------------------
 lua_manager* lua_manager::get_instance()
     {
@@ -117,10 +174,12 @@ int lua_manager::init( lua_State* lua_state, const char* script_name,
             dir, sys_dir, extra_dirs );
         }
 
+    reset_functions_cache();
+
         if ( 0 == lua_state )
         {
         //Инициализация Lua.
-        L = lua_open();   // Create Lua context.
+        L = lua_newstate( lua_allocator::alloc, &allocator ); // Create Lua context.
 
         if ( NULL == L )
             {
@@ -128,6 +187,7 @@ int lua_manager::init( lua_State* lua_state, const char* script_name,
             return 1;
             }
         is_free_lua = 1;
+        lua_atpanic( L, panic );
 
         lua_gc( L, LUA_GCSTOP, 0 );
         luaL_openlibs( L );    // Open standard libraries.
@@ -227,7 +287,7 @@ int lua_manager::init( lua_State* lua_state, const char* script_name,
             sprintf( path, "%s%s", dir, FILES[ i ] );
             }
 
-        if ( luaL_dofile( L, path ) != 0 )
+        if ( load_file( path ) || lua_pcall( L, 0, LUA_MULTRET, 0 ) )
             {
             sprintf( G_LOG->msg, "%s", lua_tostring( L, -1 ) );
             G_LOG->write_log( i_log::P_CRIT );
@@ -244,6 +304,7 @@ int lua_manager::init( lua_State* lua_state, const char* script_name,
         printf( "Экспорт в Lua необходимых объектов.\n" );
         }
     tolua_PAC_dev_open( L );
+    tolua_PAC_dev_fast_open( L );
     tolua_IOT_dev_open( L );
 #ifdef RFID
     tolua_rfid_reader_open( L );
@@ -282,7 +343,7 @@ int lua_manager::init( lua_State* lua_state, const char* script_name,
         printf( "Выполнение основного скрипта (\"%s\").\n", script_name );
         }
 
-    if( luaL_loadfile( L, script_name ) != 0 )
+    if( load_file( script_name ) != 0 )
         {
         sprintf( G_LOG->msg, "%s", lua_tostring( L, -1 ) );
         G_LOG->write_log( i_log::P_CRIT );
@@ -340,6 +401,9 @@ int lua_manager::init( lua_State* lua_state, const char* script_name,
     G_CMMCTR->reg_service( device_communicator::C_SERVICE_N,
         device_communicator::write_devices_states_service );
     G_CMMCTR->reg_service( 15, ModbusServ::ModbusService );
+    G_CMMCTR->reg_service( subscription_manager::C_SERVICE_N,
+        subscription_manager::subscription_service );
+    G_CMMCTR->reg_close_handler( subscription_manager::on_socket_close );
 #endif
 
     lua_gc( L, LUA_GCRESTART, 0 );
@@ -365,24 +429,51 @@ lua_manager::~lua_manager()
         {
         if ( L )
             {
+            //Восстанавливаем функцию выделения памяти.
+            if ( lua_profiler::is_active() ) G_LUA_PROFILER->stop();
             lua_close( L );
             L = NULL;
             }
         }
     }
 //-----------------------------------------------------------------------------
+#ifdef PTUSA_TEST
+void lua_manager::free_Lua()
+    {
+    reset_functions_cache();
+    if ( L )
+        {
+        if ( lua_profiler::is_active() ) G_LUA_PROFILER->stop();
+        lua_close( L );
+        L = nullptr;
+        }
+    }
+#endif
+//-----------------------------------------------------------------------------
 bool lua_manager::is_exist_lua_function( const char* object_name,
     const char* function_name ) const
     {
-    auto res = false;
+    if ( is_use_functions_cache )
+        {
+        auto f_ref = get_lua_function_ref( object_name, function_name );
+        if ( !f_ref ) return false;
+
+        lua_rawgeti( L, LUA_REGISTRYINDEX, f_ref->function_ref );
+        bool res = lua_isfunction( L, -1 );
+        lua_pop( L, 1 );
+        return res;
+        }
+
     lua_getfield( L, LUA_GLOBALSINDEX, object_name );
-    if ( !lua_isnil( L, -1 ) )
+    if ( lua_isnil( L, -1 ) )
         {
-        lua_getfield( L, -1, function_name );
-        res = lua_isfunction( L, -1 );
         lua_pop( L, 1 );
+        return false;
         }
-    lua_pop( L, 1 );
+
+    lua_getfield( L, -1, function_name );
+    bool res = lua_isfunction( L, -1 );
+    lua_pop( L, 2 );
     return res;
     }
 //-----------------------------------------------------------------------------
@@ -458,25 +549,27 @@ int lua_manager::exec_lua_method_var( const char* object_name,
     //    u_long start_time;
     //    start_time = get_millisec();
 
-    lua_pushcclosure( lua_manager::L, error_trace, 0 );
+    //Функция обработки ошибок создается один раз и хранится в реестре.
+    if ( LUA_NOREF == err_func_ref )
+        {
+        lua_pushcclosure( L, error_trace, 0 );
+        err_func_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+        }
+    lua_rawgeti( L, LUA_REGISTRYINDEX, err_func_ref );
     instance->err_func = lua_gettop( L );
 
-    int param_count = 0;
-
-    if ( object_name && strcmp( object_name, "" ) != 0 )
+    int param_count = push_lua_function( object_name, function_name );
+    if ( param_count < 0 )
         {
-        lua_getfield( L, LUA_GLOBALSINDEX, object_name );
-        if ( lua_type( L, -1 ) == LUA_TNIL ) return 1;
-        lua_getfield( L, -1, function_name );
-        if ( lua_type( L, -1 ) == LUA_TNIL ) return 1;
-        lua_remove( L, -2 );
-        lua_getfield( L, LUA_GLOBALSINDEX, object_name );
-
-        param_count++;
+        lua_settop( L, err_func - 1 );
+        return 1;
         }
-    else
+
+    size_t profiler_depth = 0;
+    bool is_profile = lua_profiler::is_active();
+    if ( is_profile )
         {
-        lua_getfield( L, LUA_GLOBALSINDEX, function_name );
+        profiler_depth = G_LUA_PROFILER->enter( object_name, function_name );
         }
 
     va_list param;
@@ -493,6 +586,11 @@ int lua_manager::exec_lua_method_var( const char* object_name,
     int results_count = is_use_lua_return_value == 1 ? 1 : 0;
     int res = lua_pcall( L, param_count, results_count, err_func );
 
+    if ( is_profile )
+        {
+        G_LUA_PROFILER->leave( profiler_depth );
+        }
+
     lua_remove( L, -results_count - 1 ); //Удаляем функцию error_trace.
 
     //LARGE_INTEGER finish_time;
@@ -512,6 +610,232 @@ int lua_manager::exec_lua_method_var( const char* object_name,
     return res;
     }
 //-----------------------------------------------------------------------------
+int lua_manager::push_lua_function( const char* object_name,
+    const char* function_name ) const
+    {
+    bool is_object = object_name && object_name[ 0 ] != '\0';
+
+    if ( !is_use_functions_cache )
+        {
+        if ( is_object )
+            {
+            lua_getfield( L, LUA_GLOBALSINDEX, object_name );
+            if ( lua_type( L, -1 ) == LUA_TNIL ) return -1;
+            lua_getfield( L, -1, function_name );
+            if ( lua_type( L, -1 ) == LUA_TNIL ) return -1;
+            lua_remove( L, -2 );
+            lua_getfield( L, LUA_GLOBALSINDEX, object_name );
+            return 1;
+            }
+
+        lua_getfield( L, LUA_GLOBALSINDEX, function_name );
+        return 0;
+        }
+
+    auto f_ref = get_lua_function_ref( object_name, function_name );
+    if ( !f_ref ) return -1;
+
+    lua_rawgeti( L, LUA_REGISTRYINDEX, f_ref->function_ref );
+    if ( !is_object ) return 0;
+
+    lua_rawgeti( L, LUA_REGISTRYINDEX, f_ref->object_ref );
+    return 1;
+    }
+//-----------------------------------------------------------------------------
+const lua_manager::lua_function_ref* lua_manager::get_lua_function_ref(
+    const char* object_name, const char* function_name ) const
+    {
+    bool is_object = object_name && object_name[ 0 ] != '\0';
+
+    cache_key.clear();
+    if ( is_object )
+        {
+        cache_key.append( object_name ).append( 1, '.' );
+        }
+    cache_key.append( function_name );
+    auto it = functions_cache.find( cache_key );
+    if ( it != functions_cache.end() ) return &it->second;
+
+    lua_function_ref f_ref = { LUA_NOREF, LUA_NOREF };
+    if ( is_object )
+        {
+        lua_getfield( L, LUA_GLOBALSINDEX, object_name );
+        if ( lua_type( L, -1 ) == LUA_TNIL )
+            {
+            lua_pop( L, 1 );
+            return nullptr;
+            }
+        lua_getfield( L, -1, function_name );
+        if ( lua_type( L, -1 ) == LUA_TNIL )
+            {
+            lua_pop( L, 2 );
+            return nullptr;
+            }
+
+        f_ref.function_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+        f_ref.object_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+        }
+    else
+        {
+        lua_getfield( L, LUA_GLOBALSINDEX, function_name );
+        if ( lua_type( L, -1 ) == LUA_TNIL )
+            {
+            lua_pop( L, 1 );
+            return nullptr;
+            }
+
+        f_ref.function_ref = luaL_ref( L, LUA_REGISTRYINDEX );
+        }
+
+    it = functions_cache.insert( std::make_pair( cache_key, f_ref ) ).first;
+    return &it->second;
+    }
+//-----------------------------------------------------------------------------
+int lua_manager::load_file( const char* path ) const
+    {
+    std::vector< char > src;
+    if ( !is_use_bytecode_cache || read_file( path, src ) )
+        {
+        return luaL_loadfile( L, path );
+        }
+
+    u_int_4 src_size = static_cast< u_int_4 >( src.size() );
+    u_int_4 src_crc = crc32( crc32( 0L, Z_NULL, 0 ),
+        reinterpret_cast< const Bytef* >( src.data() ), src_size );
+
+    std::string cache_path = std::string( path ) + BYTECODE_EXT;
+    if ( 0 == load_bytecode( cache_path.c_str(), src_size, src_crc ) )
+        {
+        return 0;
+        }
+
+    //Первая строка, начинающаяся с '#', пропускается (как в luaL_loadfile).
+    if ( !src.empty() && '#' == src[ 0 ] )
+        {
+        for ( size_t i = 0; i < src.size() && src[ i ] != '\n'; i++ )
+            {
+            src[ i ] = ' ';
+            }
+        }
+
+    std::string chunk_name = std::string( "@" ) + path;
+    int res = luaL_loadbuffer( L, src.data(), src.size(), chunk_name.c_str() );
+    if ( 0 == res )
+        {
+        save_bytecode( cache_path.c_str(), src_size, src_crc );
+        }
+
+    return res;
+    }
+//-----------------------------------------------------------------------------
+int lua_manager::load_bytecode( const char* cache_path, u_int_4 src_size,
+    u_int_4 src_crc ) const
+    {
+    std::vector< char > data;
+    if ( read_file( cache_path, data ) ) return 1;
+
+    bytecode_header header;
+    if ( data.size() < sizeof( header ) ) return 1;
+    memcpy( &header, data.data(), sizeof( header ) );
+
+    if ( memcmp( header.signature, BYTECODE_SIGNATURE,
+            sizeof( header.signature ) ) != 0 ||
+        header.lua_version != LUA_VERSION_NUM ||
+        header.src_size != src_size || header.src_crc != src_crc ||
+        header.size != data.size() - sizeof( header ) )
+        {
+        return 1;
+        }
+
+    //Имя файла берется из байт-кода.
+    if ( luaL_loadbuffer( L, data.data() + sizeof( header ), header.size,
+        cache_path ) != 0 )
+        {
+        G_LOG->warning( "Bytecode \"%s\" is not loaded - %s.", cache_path,
+            lua_tostring( L, -1 ) );
+        lua_pop( L, 1 );
+        return 1;
+        }
+
+    if ( G_DEBUG )
+        {
+        G_LOG->debug( "Bytecode \"%s\" loaded.", cache_path );
+        }
+
+    return 0;
+    }
+//-----------------------------------------------------------------------------
+void lua_manager::save_bytecode( const char* cache_path, u_int_4 src_size,
+    u_int_4 src_crc ) const
+    {
+    std::vector< char > data( sizeof( bytecode_header ) );
+    if ( lua_dump( L, bytecode_writer, &data ) != 0 ) return;
+
+    bytecode_header header;
+    memcpy( header.signature, BYTECODE_SIGNATURE, sizeof( header.signature ) );
+    header.lua_version = LUA_VERSION_NUM;
+    header.src_size = src_size;
+    header.src_crc = src_crc;
+    header.size = static_cast< u_int_4 >( data.size() - sizeof( header ) );
+    memcpy( data.data(), &header, sizeof( header ) );
+
+    //Запись через временный файл, чтобы при отключении питания не остался
+    //частично записанный кэш.
+    std::string tmp_path = std::string( cache_path ) + ".tmp";
+    FILE* f = fopen( tmp_path.c_str(), "wb" );
+    if ( nullptr == f )
+        {
+        if ( G_DEBUG )
+            {
+            G_LOG->debug( "Bytecode \"%s\" is not saved.", cache_path );
+            }
+        return;
+        }
+
+    bool is_ok = fwrite( data.data(), 1, data.size(), f ) == data.size();
+    is_ok = 0 == fclose( f ) && is_ok;
+
+#ifdef WIN_OS
+    remove( cache_path );
+#endif // WIN_OS
+    if ( !is_ok || rename( tmp_path.c_str(), cache_path ) != 0 )
+        {
+        remove( tmp_path.c_str() );
+        }
+    }
+//-----------------------------------------------------------------------------
+void lua_manager::clear_functions_cache() const
+    {
+    if ( L )
+        {
+        for ( const auto& item : functions_cache )
+            {
+            luaL_unref( L, LUA_REGISTRYINDEX, item.second.function_ref );
+            luaL_unref( L, LUA_REGISTRYINDEX, item.second.object_ref );
+            }
+        }
+
+    functions_cache.clear();
+    functions_cache_version++;
+    }
+//-----------------------------------------------------------------------------
+void lua_manager::reset_functions_cache()
+    {
+    functions_cache.clear();
+    functions_cache_version++;
+    err_func_ref = LUA_NOREF;
+    }
+//-----------------------------------------------------------------------------
+size_t lua_manager::get_functions_cache_size() const
+    {
+    return functions_cache.size();
+    }
+//-----------------------------------------------------------------------------
+u_int lua_manager::get_functions_cache_version() const
+    {
+    return functions_cache_version;
+    }
+//-----------------------------------------------------------------------------
 int lua_manager::error_trace( lua_State * L )
     {
     static std::vector< std::string > errors;
@@ -610,6 +934,10 @@ int lua_manager::exec_Lua_str( const char *Lua_str, const char *error_str,
     {
     int res = luaL_dostring( L, Lua_str );
 
+    //Строка могла заменить объекты и функции Lua (в том числе при ошибке
+    //выполнения - частично).
+    clear_functions_cache();
+
     if( res != 0  )
         {
         if ( is_print_error_msg )
@@ -631,6 +959,18 @@ lua_State * lua_manager::get_Lua() const
     return L;
     }
 //-----------------------------------------------------------------------------
+const lua_allocator& lua_manager::get_allocator() const
+    {
+    return allocator;
+    }
+//-----------------------------------------------------------------------------
+int lua_manager::panic( lua_State * L )
+    {
+    G_LOG->critical( "PANIC: unprotected error in call to Lua API (%s).",
+        lua_tostring( L, -1 ) );
+    return 0;
+    }
+//-----------------------------------------------------------------------------
 int lua_manager::reload_script( int script_n, const char* script_function_name,
     char *res_str, int max_res_str_length )
     {
@@ -704,10 +1044,11 @@ int lua_manager::reload_script( int script_n, const char* script_function_name,
     //    }
 
     //-Выполнение скрипта.
-    if ( luaL_dofile( L, path ) != 0 )
+    if ( load_file( path ) || lua_pcall( L, 0, LUA_MULTRET, 0 ) )
         {
         lua_pop( L, 1 );
-        if ( luaL_dofile( L, FILES[ script_n ] ) != 0 )
+        if ( load_file( FILES[ script_n ] ) ||
+            lua_pcall( L, 0, LUA_MULTRET, 0 ) )
             {
             sprintf( G_LOG->msg, "Reload Lua script - %s", lua_tostring( L, -1 ) );
             G_LOG->write_log( i_log::P_ERR );
@@ -727,10 +1068,15 @@ int lua_manager::reload_script( int script_n, const char* script_function_name,
             //    lua_pop( L, 1 );
             //    }
 
+            clear_functions_cache();
             return 1;
             }
         }
 
+    //Функции объектов могли быть переопределены (в том числе при ошибке
+    //выполнения скрипта - частично).
+    clear_functions_cache();
+
     G_LOG->notice( "Reload Lua script \"%s\" - Ok.", path );
     return 0;
     }
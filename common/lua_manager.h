@@ -1,4 +1,8 @@
+#include <string>
+#include <unordered_map>
+
 #include "smart_ptr.h"
+#include "lua_allocator.h"
 
 #ifdef  __cplusplus
 extern "C" {
@@ -16,6 +20,10 @@ extern "C" {
 //-----------------------------------------------------------------------------
 TOLUA_API int tolua_PAC_dev_open ( lua_State* tolua_S );
 
+/// @brief Замена оберток tolua++ наиболее часто вызываемых методов устройств
+/// быстрыми функциями (вызывается после tolua_PAC_dev_open).
+int tolua_PAC_dev_fast_open( lua_State* L );
+
 TOLUA_API int tolua_IOT_dev_open(lua_State* tolua_S);
 
 #ifdef RFID
@@ -54,6 +62,30 @@ class lua_manager
             is_print_stack_traceback = true;
             }
 
+        /// @brief Отключение кэша байт-кода скриптов (скрипты всегда
+        /// компилируются из исходного текста).
+        static void switch_off_bytecode_cache()
+            {
+            is_use_bytecode_cache = false;
+            }
+
+        static void switch_on_bytecode_cache()
+            {
+            is_use_bytecode_cache = true;
+            }
+
+        /// @brief Отключение кэширования функций Lua (каждый вызов ищет
+        /// объект и функцию по имени).
+        static void switch_off_functions_cache()
+            {
+            is_use_functions_cache = false;
+            }
+
+        static void switch_on_functions_cache()
+            {
+            is_use_functions_cache = true;
+            }
+
         static lua_manager* get_instance();
 
         int init( lua_State* L, const char* script_name, const char* dir = "",
@@ -93,32 +125,90 @@ class lua_manager
 
         lua_State * get_Lua() const;
 
+        /// @brief Функция выделения памяти созданного менеджером состояния
+        /// Lua.
+        const lua_allocator& get_allocator() const;
+
         int reload_script( int script_n, const char* script_function_name,
             char *res_str, int max_res_str_length );
 
+        /// @brief Загрузка (без выполнения) файла скрипта.
+        ///
+        /// Откомпилированный скрипт сохраняется рядом с исходным в файле с
+        /// расширением ".luac" вместе с контрольной суммой исходного текста и
+        /// версией Lua. При следующей загрузке, если исходный текст не
+        /// изменился, используется сохраненный байт-код.
+        ///
+        /// @return результат luaL_loadfile - 0 (функция скрипта в стеке) или
+        /// код ошибки (сообщение об ошибке в стеке).
+        int load_file( const char* path ) const;
+
+        /// @brief Сброс кэша функций Lua.
+        ///
+        /// Выполняется автоматически при перезагрузке скрипта, горячей
+        /// перезагрузке функций (@ref lua_hot_reload) и выполнении строки
+        /// (@ref exec_Lua_str). Должен вызываться и после замены объектов
+        /// или функций Lua другим способом (OBJ = ..., OBJ.f = ...), иначе
+        /// будут вызываться прежние функции.
+        void clear_functions_cache() const;
+
+        /// @brief Получение количества закэшированных функций Lua.
+        size_t get_functions_cache_size() const;
+
+        /// @brief Получение версии кэша функций Lua.
+        ///
+        /// Версия изменяется при каждом сбросе кэша (функции объектов Lua
+        /// могли измениться), что позволяет обновлять зависящие от наличия
+        /// функций данные.
+        u_int get_functions_cache_version() const;
+
 #ifdef PTUSA_TEST
         void set_Lua( lua_State* l)
             {
+            reset_functions_cache();
             L = l;
             }
 
-        void free_Lua()
-            {
-            if ( L )
-                {
-                lua_close( L );
-                L = nullptr;
-                };
-            }
+        void free_Lua();
 #endif
 
     private:
-        lua_manager() : L( 0 ), err_func( 0 ), is_free_lua( 0 )
+        lua_manager() : err_func( 0 ), L( 0 ), is_free_lua( 0 ),
+            err_func_ref( LUA_NOREF ), functions_cache_version( 1 )
             {
             }
 
+        /// @brief Помещение в стек функции и объекта (если есть).
+        ///
+        /// При первом вызове объект и функция ищутся по имени, ссылки на них
+        /// сохраняются в реестре Lua. Далее используются сохраненные ссылки.
+        ///
+        /// @return -1 - объект или функция не найдены, иначе количество
+        /// помещенных в стек параметров (0 или 1 - объект).
+        int push_lua_function( const char* object_name,
+            const char* function_name ) const;
+
+        /// @brief Закэшированная функция Lua (ссылки в реестре Lua).
+        struct lua_function_ref
+            {
+            int object_ref;     ///< Объект (LUA_NOREF - глобальная функция).
+            int function_ref;   ///< Функция.
+            };
+
+        /// @brief Получение закэшированной функции (с добавлением в кэш).
+        ///
+        /// @return nullptr - объект или функция не найдены.
+        const lua_function_ref* get_lua_function_ref( const char* object_name,
+            const char* function_name ) const;
+
+        /// @brief Очистка кэша без освобождения ссылок (при смене состояния
+        /// Lua).
+        void reset_functions_cache();
+
         static int error_trace( lua_State * L );
 
+        static int panic( lua_State * L );
+
         static auto_smart_ptr< lua_manager > instance;
 
         int exec_lua_method( const char *object_name,
@@ -129,12 +219,36 @@ class lua_manager
             int is_use_lua_return_value = 0, int cnt = 0, ... ) const;
 
         static bool is_print_stack_traceback;
+        static bool is_use_functions_cache;
+        static bool is_use_bytecode_cache;
+
+        /// @brief Загрузка байт-кода из кэша.
+        ///
+        /// @return 0 - байт-код актуален и загружен.
+        int load_bytecode( const char* cache_path, u_int_4 src_size,
+            u_int_4 src_crc ) const;
+
+        /// @brief Сохранение в кэш байт-кода функции из вершины стека.
+        void save_bytecode( const char* cache_path, u_int_4 src_size,
+            u_int_4 src_crc ) const;
 
         int err_func;
         lua_State * L;
 
         int is_free_lua;
 
+        lua_allocator allocator;
+
+        /// Ссылка на функцию обработки ошибок (создается один раз).
+        mutable int err_func_ref;
+
+        /// Кэш функций, ключ - "объект.функция" (для глобальной функции -
+        /// ее имя).
+        mutable std::unordered_map< std::string, lua_function_ref >
+            functions_cache;
+        mutable std::string cache_key;  ///< Буфер для формирования ключа.
+        mutable u_int functions_cache_version;
+
         enum CONSTANTS
             {
             MAX_ERRORS = 50,
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "lua_profiler.h"
+
+auto_smart_ptr < lua_profiler > lua_profiler::instance;
+bool lua_profiler::is_on = false;
+//-----------------------------------------------------------------------------
+lua_profiler* lua_profiler::get_instance()
+    {
+    if ( instance.is_null() )
+        {
+        instance = new lua_profiler();
+        }
+
+    return instance;
+    }
+//-----------------------------------------------------------------------------
+lua_profiler::lua_profiler() : mode( M_OFF ), L( nullptr ),
+    prev_alloc( nullptr ), prev_alloc_ud( nullptr )
+    {
+    }
+//-----------------------------------------------------------------------------
+lua_profiler::~lua_profiler()
+    {
+    stop();
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::start( lua_State* lua_state, MODE new_mode )
+    {
+    stop();
+    if ( M_OFF == new_mode ) return;
+
+    mode = new_mode;
+    L = lua_state;
+    if ( L )
+        {
+        prev_alloc = lua_getallocf( L, &prev_alloc_ud );
+        lua_setallocf( L, alloc, this );
+
+        if ( M_FULL == mode )
+            {
+            lua_sethook( L, hook, LUA_MASKCALL | LUA_MASKRET, 0 );
+            }
+        }
+
+    is_on = true;
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::stop()
+    {
+    if ( M_OFF == mode ) return;
+
+    if ( L )
+        {
+        lua_sethook( L, nullptr, 0, 0 );
+        lua_setallocf( L, prev_alloc, prev_alloc_ud );
+        }
+
+    while ( !frames.empty() ) pop_frame();
+
+    is_on = false;
+    mode = M_OFF;
+    L = nullptr;
+    }
+//-----------------------------------------------------------------------------
+lua_profiler::MODE lua_profiler::get_mode() const
+    {
+    return mode;
+    }
+//-----------------------------------------------------------------------------
+size_t lua_profiler::enter( const char* object_name,
+    const char* function_name )
+    {
+    size_t depth = frames.size();
+
+    char name[ 100 ];
+    snprintf( name, sizeof( name ), "%s:%s",
+        object_name ? object_name : "", function_name );
+    push_frame( name, true );
+
+    return depth;
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::leave( size_t depth )
+    {
+    while ( frames.size() > depth ) pop_frame();
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::push_frame( const char* name, bool is_entry )
+    {
+    frame f;
+    f.path_len = path.size();
+    f.child_time = 0;
+    f.alloc_self = 0;
+    f.child_alloc = 0;
+    f.is_entry = is_entry;
+    f.is_skip_call = is_entry;
+
+    if ( !path.empty() ) path += ';';
+    //Символ ';' разделяет вызовы в свернутом стеке.
+    for ( const char* c = name; *c; c++ )
+        {
+        path += *c == ';' ? ',' : *c;
+        }
+
+    f.start_time = get_microsec();
+    frames.push_back( f );
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::pop_frame()
+    {
+    frame f = frames.back();
+    frames.pop_back();
+
+    u_long time_all = get_delta_microsec( f.start_time );
+    unsigned long long alloc_all = f.alloc_self + f.child_alloc;
+
+    stat& s = stats[ path ];
+    s.calls++;
+    s.time_all += time_all;
+    s.time_self += time_all > f.child_time ? time_all - f.child_time : 0;
+    s.alloc_all += alloc_all;
+    s.alloc_self += f.alloc_self;
+
+    path.resize( f.path_len );
+
+    if ( !frames.empty() )
+        {
+        frames.back().child_time += time_all;
+        frames.back().child_alloc += alloc_all;
+        }
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::hook( lua_State* L, lua_Debug* ar )
+    {
+    lua_profiler* p = instance;
+    if ( !p || p->frames.empty() ) return; //Учитываем только вызовы из C++.
+
+    frame& top = p->frames.back();
+    if ( LUA_HOOKCALL == ar->event )
+        {
+        //Вызов самой функции уже учтен в enter().
+        if ( top.is_skip_call )
+            {
+            top.is_skip_call = false;
+            return;
+            }
+
+        lua_getinfo( L, "nS", ar );
+        char name[ 200 ];
+        if ( ar->what && 0 == strcmp( ar->what, "C" ) )
+            {
+            snprintf( name, sizeof( name ), "%s [C]",
+                ar->name ? ar->name : "?" );
+            }
+        else
+            {
+            snprintf( name, sizeof( name ), "%s@%s:%d",
+                ar->name ? ar->name : "?", ar->short_src, ar->linedefined );
+            }
+        p->push_frame( name, false );
+        }
+    else if ( !top.is_entry ) //LUA_HOOKRET, LUA_HOOKTAILRET.
+        {
+        p->pop_frame();
+        }
+    }
+//-----------------------------------------------------------------------------
+void* lua_profiler::alloc( void* ud, void* ptr, size_t osize, size_t nsize )
+    {
+    auto p = static_cast<lua_profiler*>( ud );
+    if ( nsize > osize && !p->frames.empty() )
+        {
+        p->frames.back().alloc_self += nsize - osize;
+        }
+
+    return p->prev_alloc( p->prev_alloc_ud, ptr, osize, nsize );
+    }
+//-----------------------------------------------------------------------------
+const lua_profiler::stat* lua_profiler::get_stat( const char* stack ) const
+    {
+    auto it = stats.find( stack );
+    return it != stats.end() ? &it->second : nullptr;
+    }
+//-----------------------------------------------------------------------------
+int lua_profiler::save_as_folded( char* buff, int max_size ) const
+    {
+    int res = 0;
+    buff[ 0 ] = 0;
+    for ( const auto& item : stats )
+        {
+        if ( res >= max_size ) break;
+
+        res += snprintf( buff + res, max_size - res, "%s %lu\n",
+            item.first.c_str(), item.second.time_self );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
+int lua_profiler::save_as_Lua_str( char* buff, int max_size ) const
+    {
+    int res = snprintf( buff, max_size,
+        "lua_profiler =\n\t{\n\tmode = %d,\n\tstats =\n\t\t{\n", mode );
+
+    std::string key;
+    for ( const auto& item : stats )
+        {
+        if ( res >= max_size ) break;
+
+        //Имя файла в стеке может содержать обратную косую черту (Windows).
+        key.clear();
+        for ( auto c : item.first )
+            {
+            if ( '\\' == c || '"' == c ) key += '\\';
+            key += c;
+            }
+
+        const stat& st = item.second;
+        res += snprintf( buff + res, max_size - res,
+            "\t\t[ \"%s\" ] = { calls = %lu, time_all = %lu, time_self = %lu, "
+            "alloc_all = %llu, alloc_self = %llu },\n",
+            key.c_str(), st.calls, st.time_all, st.time_self, st.alloc_all,
+            st.alloc_self );
+        }
+
+    if ( res < max_size )
+        {
+        res += snprintf( buff + res, max_size - res, "\t\t}\n\t}\n" );
+        }
+
+    return res < max_size ? res : max_size - 1;
+    }
+//-----------------------------------------------------------------------------
+void lua_profiler::clear()
+    {
+    stats.clear();
+    }
+//-----------------------------------------------------------------------------
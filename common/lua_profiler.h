@@ -0,0 +1,154 @@
+/// @file lua_profiler.h
+/// @brief Профилирование вызовов функций Lua.
+///
+/// Учитываются вызовы функций Lua из C++ (@ref lua_manager) - количество
+/// вызовов, полное время (с учетом вложенных вызовов), собственное время и
+/// объем выделенной памяти для каждой пары (объект, функция). В полном режиме
+/// с помощью lua_sethook учитываются также вложенные вызовы функций Lua и C.
+///
+/// Результат сохраняется в формате "свернутых стеков" (folded stacks):
+/// строка на каждый стек вызовов вида "o1:evaluate;f@file.lua:10 123", где
+/// число - собственное время, мкс. Этот формат принимается flamegraph.pl и
+/// аналогичными инструментами. Полная статистика (количество вызовов,
+/// полное и собственное время, выделенная память) сохраняется в виде таблицы
+/// Lua (@ref lua_profiler::save_as_Lua_str).
+///
+/// Управление - командой @ref device_communicator::CMD_LUA_PROFILER.
+
+#ifndef LUA_PROFILER_H
+#define LUA_PROFILER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include    "lua.h"
+
+#ifdef  __cplusplus
+    };
+#endif
+
+#include "smart_ptr.h"
+#include "dtime.h"
+//-----------------------------------------------------------------------------
+/// @brief Профилировщик вызовов функций Lua.
+class lua_profiler
+    {
+    public:
+        enum MODE
+            {
+            M_OFF = 0,  ///< Отключен.
+            M_CALLS,    ///< Только вызовы функций Lua из C++.
+            M_FULL,     ///< Все вызовы функций (lua_sethook).
+            };
+
+        /// @brief Статистика стека вызовов.
+        struct stat
+            {
+            u_long calls = 0;           ///< Количество вызовов.
+            u_long time_all = 0;        ///< Полное время, мкс.
+            u_long time_self = 0;       ///< Собственное время, мкс.
+
+            unsigned long long alloc_all = 0;   ///< Выделено всего, байт.
+            unsigned long long alloc_self = 0;  ///< Выделено самой функцией.
+            };
+
+        /// @brief Получение единственного экземпляра класса.
+        static lua_profiler* get_instance();
+
+        ~lua_profiler();
+
+        /// @brief Проверка работы профилировщика (вызывается на каждый вызов
+        /// функции Lua, поэтому без обращения к экземпляру).
+        static bool is_active()
+            {
+            return is_on;
+            }
+
+        /// @brief Запуск профилирования.
+        ///
+        /// @param L    - состояние Lua (nullptr - без учета памяти и вложенных
+        /// вызовов).
+        /// @param mode - режим (@ref MODE).
+        void start( lua_State* L, MODE mode );
+
+        /// @brief Остановка профилирования (статистика сохраняется).
+        void stop();
+
+        MODE get_mode() const;
+
+        /// @brief Начало вызова функции Lua из C++.
+        ///
+        /// @return глубина стека для последующего вызова @ref leave.
+        size_t enter( const char* object_name, const char* function_name );
+
+        /// @brief Завершение вызова функции Lua из C++.
+        ///
+        /// Завершаются также вложенные вызовы, прерванные ошибкой Lua (при
+        /// ошибке события возврата для них не формируются).
+        ///
+        /// @param depth - значение, возвращенное @ref enter.
+        void leave( size_t depth );
+
+        /// @brief Получение статистики стека вызовов.
+        ///
+        /// @param path - стек вызовов, например "o1:evaluate;f@file.lua:10".
+        ///
+        /// @return nullptr - данный стек не вызывался.
+        const stat* get_stat( const char* path ) const;
+
+        /// @brief Сохранение статистики в виде свернутых стеков.
+        ///
+        /// @return количество записанных байт.
+        int save_as_folded( char* buff, int max_size ) const;
+
+        /// @brief Сохранение полной статистики в виде таблицы Lua.
+        ///
+        /// @return количество записанных байт.
+        int save_as_Lua_str( char* buff, int max_size ) const;
+
+        /// @brief Сброс статистики.
+        void clear();
+
+    private:
+        lua_profiler();
+
+        struct frame
+            {
+            size_t path_len;        ///< Длина пути до данного вызова.
+            u_long start_time;
+            u_long child_time;
+            unsigned long long alloc_self;
+            unsigned long long child_alloc;
+            bool   is_entry;        ///< Вызов из C++.
+            bool   is_skip_call;    ///< Событие вызова самой функции еще не
+                                    ///< получено.
+            };
+
+        void push_frame( const char* name, bool is_entry );
+        void pop_frame();
+
+        static void hook( lua_State* L, lua_Debug* ar );
+        static void* alloc( void* ud, void* ptr, size_t osize, size_t nsize );
+
+        static bool is_on;
+
+        MODE mode;
+        lua_State* L;
+        lua_Alloc prev_alloc;
+        void* prev_alloc_ud;
+
+        std::vector< frame > frames;
+        std::string path;           ///< Текущий стек вызовов.
+        std::map< std::string, stat > stats;
+
+        static auto_smart_ptr < lua_profiler > instance;
+    };
+//-----------------------------------------------------------------------------
+#define G_LUA_PROFILER lua_profiler::get_instance()
+//-----------------------------------------------------------------------------
+#endif // LUA_PROFILER_H
@@ -176,3 +176,45 @@ TEST( toLuapp, tolua_PAC_dev_i_wages_get_state00 )
 
     lua_close( L );
     }
+
+TEST( toLuapp, tolua_PAC_dev_fast_open )
+    {
+    lua_State* L = lua_open();
+    ASSERT_EQ( 1, tolua_PAC_dev_open( L ) );
+    ASSERT_EQ( 1, tolua_PAC_dev_fast_open( L ) );
+
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_DO, device::DST_DO_VIRT, "DO1", "Test DO", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_AO, device::DST_AO_VIRT, "AO1", "Test AO", "" );
+
+    ASSERT_EQ( 0, luaL_dostring( L,
+        "V1 = V( 'V1' ) DO1 = DO( 'DO1' ) AO1 = AO( 'AO1' )" ) );
+
+    EXPECT_EQ( 0, luaL_dostring( L,
+        "V1:on() assert( V1:get_state() == 1 )\n"
+        "V1:set_state( 0 ) assert( V1:get_state() == 0 )\n"
+        "assert( type( V1:is_opened() ) == 'boolean' )\n"
+        "assert( type( V1:is_closed() ) == 'boolean' )\n"
+        "DO1:on() assert( DO1:get_state() == 1 and DO1:is_active() )\n"
+        "DO1:instant_off() assert( DO1:get_state() == 0 )\n"
+        "AO1:set_value( 12.5 ) assert( AO1:get_value() == 12.5 )\n"
+        "AO1:off() assert( AO1:get_value() == 0 )" ) );
+    EXPECT_EQ( 0, DO( "DO1" )->get_state() );
+
+    //Некорректные вызовы - ошибка обертки tolua++.
+    EXPECT_NE( 0, luaL_dostring( L, "V1.on()" ) );
+    EXPECT_NE( 0, luaL_dostring( L, "DO1:set_state()" ) );
+    EXPECT_NE( 0, luaL_dostring( L, "AO1:set_value( {} )" ) );
+    EXPECT_NE( 0, luaL_dostring( L, "V1.get_state( DO1 )" ) );
+
+    //Вызов метода базового класса для объекта производного класса.
+    EXPECT_EQ( 0, luaL_dostring( L,
+        "i_DO_device.on( DEVICE( 2 ) )" ) );
+
+    lua_close( L );
+    G_DEVICE_MANAGER()->clear_io_devices();
+    }
@@ -5,3 +5,4 @@
 #include "PAC_dev.h"
 
 TOLUA_API int  tolua_PAC_dev_open( lua_State* tolua_S );
+int tolua_PAC_dev_fast_open( lua_State* L );
@@ -396,6 +396,67 @@ TEST( device_manager, clear_io_devices )
         G_DEVICE_MANAGER()->get_TE( "T1" ) );   //Search shouldn't find device.
     }
 
+TEST( device_manager, update_errors )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    EXPECT_FALSE( G_DEVICE_MANAGER()->is_errors_valid() );
+
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "V" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V2", "Test valve", "V" );
+    auto v2 = dynamic_cast<virtual_valve*>( G_DEVICE_MANAGER()->get_V( "V2" ) );
+    ASSERT_NE( nullptr, v2 );
+
+    G_DEVICE_MANAGER()->update_errors();
+    EXPECT_TRUE( G_DEVICE_MANAGER()->is_errors_valid() );
+    EXPECT_EQ( 0u, G_DEVICE_MANAGER()->get_errors_word( 0 ) );
+
+    v2->direct_set_state( valve::VALVE_STATE_EX::VX_ON_FB_ERR );
+    EXPECT_EQ( 0u, G_DEVICE_MANAGER()->get_errors_word( 0 ) );  //Snapshot.
+    G_DEVICE_MANAGER()->update_errors();
+    EXPECT_EQ( 1u << v2->get_serial_n(),
+        G_DEVICE_MANAGER()->get_errors_word( 0 ) );
+    EXPECT_EQ( 0u, G_DEVICE_MANAGER()->get_errors_word( 1 ) );  //Out of range.
+
+    G_DEVICE_MANAGER()->clear_io_devices();
+    EXPECT_FALSE( G_DEVICE_MANAGER()->is_errors_valid() );
+    }
+
+TEST( device_manager, get_changed_devices )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    EXPECT_TRUE( G_DEVICE_MANAGER()->get_changed_devices().empty() );
+
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "V" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V2", "Test valve", "V" );
+    auto v2 = dynamic_cast<virtual_valve*>( G_DEVICE_MANAGER()->get_V( "V2" ) );
+    ASSERT_NE( nullptr, v2 );
+    EXPECT_EQ( 2u, G_DEVICE_MANAGER()->get_devices_count() );
+
+    //Первое обновление - изменились все устройства.
+    G_DEVICE_MANAGER()->update_errors();
+    EXPECT_EQ( 2u, G_DEVICE_MANAGER()->get_changed_devices().size() );
+    G_DEVICE_MANAGER()->clear_changed_devices();
+    EXPECT_TRUE( G_DEVICE_MANAGER()->get_changed_devices().empty() );
+
+    G_DEVICE_MANAGER()->update_errors();
+    EXPECT_TRUE( G_DEVICE_MANAGER()->get_changed_devices().empty() );
+
+    //Изменения накапливаются до обработки.
+    v2->direct_set_state( valve::VALVE_STATE_EX::VX_ON_FB_ERR );
+    G_DEVICE_MANAGER()->update_errors();
+    G_DEVICE_MANAGER()->update_errors();
+    ASSERT_EQ( 1u, G_DEVICE_MANAGER()->get_changed_devices().size() );
+    EXPECT_EQ( v2->get_serial_n(),
+        G_DEVICE_MANAGER()->get_changed_devices()[ 0 ] );
+
+    G_DEVICE_MANAGER()->clear_io_devices();
+    EXPECT_TRUE( G_DEVICE_MANAGER()->get_changed_devices().empty() );
+    }
+
 TEST( dev_stub, get_pump_dt )
     {
     EXPECT_EQ( .0f, STUB()->get_pump_dt() );
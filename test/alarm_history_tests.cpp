@@ -0,0 +1,65 @@
+#include "alarm_history_tests.h"
+
+using namespace ::testing;
+
+TEST( alarm_history, add )
+    {
+    const char* FILE_NAME = "./alarm_history_test.bin";
+    remove( FILE_NAME );
+
+    const u_int CAPACITY = 4;
+    EXPECT_EQ( 0, G_ALARM_HISTORY->init( FILE_NAME, CAPACITY ) );
+    EXPECT_EQ( 0u, G_ALARM_HISTORY->get_count() );
+    EXPECT_EQ( nullptr, G_ALARM_HISTORY->get_record( 0 ) );
+
+    for ( u_int i = 0; i < CAPACITY + 2; i++ )
+        {
+        G_ALARM_HISTORY->add( alarm_history::S_ERROR, 1, 2, 0, i, -1 );
+        }
+
+    //Старые события перезаписаны.
+    ASSERT_EQ( CAPACITY, G_ALARM_HISTORY->get_count() );
+    EXPECT_EQ( 2u, G_ALARM_HISTORY->get_record( 0 )->object_n );
+    EXPECT_EQ( CAPACITY + 1, G_ALARM_HISTORY->get_record( CAPACITY - 1 )->object_n );
+    EXPECT_EQ( -1, G_ALARM_HISTORY->get_record( 0 )->value );
+    EXPECT_EQ( nullptr, G_ALARM_HISTORY->get_record( CAPACITY ) );
+
+    //История сохраняется.
+    EXPECT_EQ( 0, G_ALARM_HISTORY->init( FILE_NAME, CAPACITY ) );
+    ASSERT_EQ( CAPACITY, G_ALARM_HISTORY->get_count() );
+    EXPECT_EQ( 2u, G_ALARM_HISTORY->get_record( 0 )->object_n );
+
+    //Другой размер - история очищается.
+    EXPECT_EQ( 0, G_ALARM_HISTORY->init( FILE_NAME, CAPACITY * 2 ) );
+    EXPECT_EQ( 0u, G_ALARM_HISTORY->get_count() );
+
+    EXPECT_EQ( 0, G_ALARM_HISTORY->init( nullptr ) );
+    remove( FILE_NAME );
+    }
+
+TEST( alarm_history, save_as_Lua_str )
+    {
+    G_ALARM_HISTORY->init( nullptr );
+    G_ALARM_HISTORY->add( alarm_history::S_CRITICAL, 1, 3, 4, 5, 0 );
+    u_int_4 t = G_ALARM_HISTORY->get_record( 0 )->time;
+
+    const int BUFF_SIZE = 1000;
+    char buff[ BUFF_SIZE ] = { 0 };
+    int size = G_ALARM_HISTORY->save_as_Lua_str( buff, BUFF_SIZE, t, 0 );
+    EXPECT_EQ( (int)strlen( buff ), size );
+    EXPECT_NE( nullptr, strstr( buff, "source = 1, state = 1, class = 3, "
+        "subclass = 4, n = 5, value = 0 }" ) );
+    EXPECT_NE( nullptr, strstr( buff, "is_truncated = false" ) );
+
+    //Фильтр по времени.
+    G_ALARM_HISTORY->save_as_Lua_str( buff, BUFF_SIZE, t + 1, 0 );
+    EXPECT_EQ( nullptr, strstr( buff, "source =" ) );
+    G_ALARM_HISTORY->save_as_Lua_str( buff, BUFF_SIZE, 0, t - 1 );
+    EXPECT_EQ( nullptr, strstr( buff, "source =" ) );
+
+    //Не хватает места.
+    G_ALARM_HISTORY->save_as_Lua_str( buff, 100, 0, 0 );
+    EXPECT_NE( nullptr, strstr( buff, "is_truncated = true" ) );
+
+    G_ALARM_HISTORY->init( nullptr );
+    }
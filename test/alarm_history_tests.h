@@ -0,0 +1,4 @@
+#pragma once
+#include "includes.h"
+
+#include "alarm_history.h"
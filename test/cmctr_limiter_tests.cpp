@@ -0,0 +1,191 @@
+#include "cmctr_limiter_tests.h"
+
+using namespace ::testing;
+
+TEST( request_limiter, check )
+    {
+    request_limiter limiter;
+    u_int retry_after = 0;
+    const u_char SRV = 1;
+    u_char data[] = { 100, 1, 2 };
+
+    //Без ограничений.
+    for ( int i = 0; i < 10; i++ )
+        {
+        EXPECT_EQ( request_limiter::CHECK_OK,
+            limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+        }
+
+    limiter.set_rate_limit( SRV, 100, 0.5f, 2 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_GT( retry_after, 1000u );
+    EXPECT_LE( retry_after, 2001u );
+
+    //Ограничение для каждого клиента отдельное.
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 2, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( 0u, retry_after );
+
+    //Другая команда не ограничена.
+    u_char data2[] = { 101 };
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+
+    //Снятие ограничения.
+    limiter.set_rate_limit( SRV, 100, 0, 0 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    }
+
+TEST( request_limiter, check_other_service )
+    {
+    request_limiter limiter;
+    u_int retry_after = 0;
+    u_char data[] = { 100 };
+
+    limiter.set_rate_limit( 1, 100, 1000, 1 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, 1, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, 1, data, sizeof( data ), retry_after ) );
+
+    //Запросы к другому сервису (с тем же первым байтом) не ограничиваются.
+    for ( int i = 0; i < 10; i++ )
+        {
+        EXPECT_EQ( request_limiter::CHECK_OK,
+            limiter.check( 1, 2, data, sizeof( data ), retry_after ) );
+        }
+
+    //Токены пополняются со временем.
+    sleep_ms( retry_after + 5 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, 1, data, sizeof( data ), retry_after ) );
+
+    limiter.clear();
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, 1, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, 1, data, sizeof( data ), retry_after ) );
+    }
+
+bool is_counted_test_cmd( u_char cmd )
+    {
+    return cmd != 102;
+    }
+
+TEST( request_limiter, set_client_rate_limit )
+    {
+    request_limiter limiter;
+    u_int retry_after = 0;
+    const u_char SRV = 1;
+    u_char data[] = { 100 };
+    u_char data2[] = { 101 };
+    u_char not_counted[] = { 102 };
+
+    //Общее ведро клиента - для всех учитываемых команд.
+    limiter.set_client_rate_limit( SRV, 0.5f, 2, is_counted_test_cmd );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_GT( retry_after, 1000u );
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+
+    //Неучитываемая команда, другой клиент и другой сервис не ограничены.
+    for ( int i = 0; i < 10; i++ )
+        {
+        EXPECT_EQ( request_limiter::CHECK_OK, limiter.check(
+            1, SRV, not_counted, sizeof( not_counted ), retry_after ) );
+        }
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 2, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV + 1, data, sizeof( data ), retry_after ) );
+
+    //Снятие ограничения.
+    limiter.set_client_rate_limit( SRV, 0, 0 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    }
+
+TEST( request_limiter, set_client_rate_limit_with_cmd_limit )
+    {
+    request_limiter limiter;
+    u_int retry_after = 0;
+    const u_char SRV = 1;
+    u_char data[] = { 100 };
+    u_char data2[] = { 101 };
+
+    limiter.set_client_rate_limit( SRV, 0.5f, 3 );
+    limiter.set_rate_limit( SRV, 100, 0.5f, 1 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+
+    //Нет токенов в ведре команды - токен общего ведра не расходуется.
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+
+    limiter.clear();
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+    }
+
+TEST( request_limiter, save_response )
+    {
+    request_limiter limiter;
+    u_int retry_after = 0;
+    const u_char SRV = 1;
+    u_char data[] = { 100, 1, 2 };
+    u_char response[] = { 'a', 'b', 'c', 'd' };
+    u_int size = 0;
+
+    limiter.set_cache_time( SRV, 100, 10000 );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    EXPECT_EQ( nullptr, limiter.get_cached_response( 1, size ) );
+    limiter.save_response( 1, response, sizeof( response ) );
+
+    //Повторный запрос - сохраненный ответ.
+    EXPECT_EQ( request_limiter::CHECK_CACHED,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+    auto res = limiter.get_cached_response( 1, size );
+    ASSERT_NE( nullptr, res );
+    EXPECT_EQ( sizeof( response ), size );
+    EXPECT_EQ( 0, memcmp( response, res, size ) );
+
+    //Другой клиент.
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 2, SRV, data, sizeof( data ), retry_after ) );
+
+    //Другие данные запроса.
+    data[ 2 ] = 3;
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data, sizeof( data ), retry_after ) );
+
+    //Ответ на команду без времени хранения не сохраняется.
+    u_char data2[] = { 101 };
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+    limiter.save_response( 1, response, sizeof( response ) );
+    EXPECT_EQ( request_limiter::CHECK_OK,
+        limiter.check( 1, SRV, data2, sizeof( data2 ), retry_after ) );
+
+    limiter.remove_client( 1 );
+    EXPECT_EQ( nullptr, limiter.get_cached_response( 1, size ) );
+    }
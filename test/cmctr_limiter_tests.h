@@ -0,0 +1,3 @@
+#pragma once
+#include "includes.h"
+#include "cmctr_limiter.h"
@@ -0,0 +1,113 @@
+#include "cmctr_metrics_tests.h"
+
+using namespace ::testing;
+
+TEST( request_stat, add )
+    {
+    request_stat st;
+    EXPECT_EQ( 0u, st.requests_cnt );
+
+    st.add( 50, 10, 6, 1000, 100 );
+    st.add( 2000, 30, 6, 3000, 300 );
+    st.add( 200000, 20, 6, 0, 0 );
+
+    EXPECT_EQ( 3u, st.requests_cnt );
+    EXPECT_EQ( 202050u, st.handler_time_all );
+    EXPECT_EQ( 200000u, st.handler_time_max );
+    EXPECT_EQ( 60u, st.queue_delay_all );
+    EXPECT_EQ( 30u, st.queue_delay_max );
+    EXPECT_EQ( 18u, st.in_bytes );
+    EXPECT_EQ( 4000u, st.raw_bytes );
+    EXPECT_EQ( 400u, st.out_bytes );
+
+    EXPECT_EQ( 1u, st.handler_hist[ 0 ] );  // < 100 мкс.
+    EXPECT_EQ( 1u, st.handler_hist[ 3 ] );  // 1..5 мс.
+    EXPECT_EQ( 1u, st.handler_hist[ request_stat::C_HIST_SIZE - 1 ] );
+
+    st.clear();
+    EXPECT_EQ( 0u, st.requests_cnt );
+    EXPECT_EQ( 0u, st.handler_hist[ 0 ] );
+    }
+
+TEST( cmctr_metrics, start_request )
+    {
+    G_CMMCTR_METRICS->clear();
+    EXPECT_EQ( nullptr, G_CMMCTR_METRICS->get_service_stat( 1 ) );
+
+    G_CMMCTR_METRICS->start_request( 1, 25 );
+    G_CMMCTR_METRICS->add_command( 101, 10, 500, 50 );
+    G_CMMCTR_METRICS->end_request( 7, 50 );
+
+    auto srv = G_CMMCTR_METRICS->get_service_stat( 1 );
+    ASSERT_NE( nullptr, srv );
+    EXPECT_EQ( 1u, srv->requests_cnt );
+    EXPECT_EQ( 25u, srv->queue_delay_max );
+    EXPECT_EQ( 7u, srv->in_bytes );
+    EXPECT_EQ( 500u, srv->raw_bytes );
+    EXPECT_EQ( 50u, srv->out_bytes );
+
+    auto cmd = G_CMMCTR_METRICS->get_command_stat( 101 );
+    ASSERT_NE( nullptr, cmd );
+    EXPECT_EQ( 1u, cmd->requests_cnt );
+    EXPECT_EQ( 25u, cmd->queue_delay_max );
+    EXPECT_EQ( 500u, cmd->raw_bytes );
+    EXPECT_EQ( 50u, cmd->out_bytes );
+
+    //Запрос без команд - ответ не сжимается.
+    G_CMMCTR_METRICS->start_request( 1, 0 );
+    G_CMMCTR_METRICS->end_request( 7, 30 );
+    EXPECT_EQ( 2u, srv->requests_cnt );
+    EXPECT_EQ( 530u, srv->raw_bytes );
+    EXPECT_EQ( 80u, srv->out_bytes );
+
+    G_CMMCTR_METRICS->clear();
+    }
+
+TEST( cmctr_metrics, save_as_Lua_str )
+    {
+    G_CMMCTR_METRICS->clear();
+    G_CMMCTR_METRICS->start_request( 1, 0 );
+    G_CMMCTR_METRICS->add_command( 101, 10, 500, 50 );
+    G_CMMCTR_METRICS->end_request( 7, 50 );
+
+    const int BUFF_SIZE = 1000;
+    char buff[ BUFF_SIZE ] = { 0 };
+    auto res = G_CMMCTR_METRICS->save_as_Lua_str( buff, BUFF_SIZE );
+    EXPECT_EQ( strlen( buff ), ( size_t ) res );
+    EXPECT_NE( nullptr, strstr( buff, "services =" ) );
+    EXPECT_NE( nullptr, strstr( buff, "[ 101 ] = { cnt = 1, time_avg = 10," ) );
+
+    //Буфер недостаточного размера.
+    const int SMALL_BUFF_SIZE = 20;
+    char small_buff[ SMALL_BUFF_SIZE ] = { 0 };
+    res = G_CMMCTR_METRICS->save_as_Lua_str( small_buff, SMALL_BUFF_SIZE );
+    EXPECT_EQ( SMALL_BUFF_SIZE - 1, res );
+
+    G_CMMCTR_METRICS->print_to_log();
+    G_CMMCTR_METRICS->clear();
+    }
+
+TEST( device_communicator, CMD_GET_CMCTR_METRICS )
+    {
+    const int OUT_BUFF_SIZE = 1000;
+    unsigned char data[ 2 ] = { device_communicator::CMD_GET_CMCTR_METRICS, 1 };
+    unsigned char out_data[ OUT_BUFF_SIZE ] = { '\0' };
+
+    G_CMMCTR_METRICS->clear();
+    device_communicator::switch_off_compression();
+    auto res = G_DEVICE_CMMCTR->write_devices_states_service( 2, data,
+        out_data );
+    device_communicator::switch_on_compression();
+
+    EXPECT_EQ( strlen( ( char* ) out_data ) + 1, ( size_t ) res );
+    EXPECT_EQ( 0, strncmp( "metrics =", ( char* ) out_data, 9 ) );
+
+    //Выполнение команды учтено в статистике (после ее сброса).
+    auto cmd = G_CMMCTR_METRICS->get_command_stat(
+        device_communicator::CMD_GET_CMCTR_METRICS );
+    ASSERT_NE( nullptr, cmd );
+    EXPECT_EQ( 1u, cmd->requests_cnt );
+    EXPECT_EQ( ( u_long ) res, cmd->raw_bytes );
+
+    G_CMMCTR_METRICS->clear();
+    }
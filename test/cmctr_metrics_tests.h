@@ -0,0 +1,4 @@
+#pragma once
+#include "includes.h"
+#include "cmctr_metrics.h"
+#include "g_device.h"
@@ -0,0 +1,206 @@
+#include "g_errors_tests.h"
+
+using namespace ::testing;
+
+class test_error : public base_error
+    {
+    public:
+        int save_as_Lua_str( char *str ) override
+            {
+            if ( AS_NORMAL == error_state )
+                {
+                str[ 0 ] = 0;
+                return 0;
+                }
+
+            return sprintf( str, "\t{ state=%d },\n", error_state );
+            }
+
+        void evaluate( bool& /*is_new_state*/ ) override
+            {
+            evaluate_cnt++;
+            }
+
+        void print() const override
+            {
+            }
+
+        unsigned char get_object_type() const override
+            {
+            return 250;
+            }
+
+        unsigned int get_object_n() const override
+            {
+            return 1;
+            }
+
+        int set_cmd( int cmd, int /*object_alarm_number*/ ) override
+            {
+            error_state = cmd == C_CMD_ACCEPT ? AS_NORMAL : AS_ALARM;
+            return 0;
+            }
+
+        int evaluate_cnt = 0;
+    };
+
+TEST( errors_manager, save_changes_as_Lua_str )
+    {
+    test_error err;
+    G_ERRORS_MANAGER->add_error( &err );
+
+    const int BUFF_SIZE = 10000;
+    char buff[ BUFF_SIZE ] = { 0 };
+    bool is_full = true;
+
+    u_int_4 id = G_ERRORS_MANAGER->get_journal_id();
+    EXPECT_EQ( 0, G_ERRORS_MANAGER->save_changes_as_Lua_str(
+        buff, id, is_full ) );
+    EXPECT_FALSE( is_full );
+
+    //Новая ошибка.
+    G_ERRORS_MANAGER->set_cmd( base_error::C_CMD_SUPPRESS, 250, 1, 0 );
+    EXPECT_EQ( id + 1, G_ERRORS_MANAGER->get_journal_id() );
+    G_ERRORS_MANAGER->save_changes_as_Lua_str( buff, id, is_full );
+    EXPECT_FALSE( is_full );
+    EXPECT_STREQ( "\t{ id_type = 250, id_n = 1, alarms =\n\t{\n"
+        "\t{ state=1 },\n\t} },\n", buff );
+
+    //Ошибка подтверждена - пустой список ошибок объекта.
+    id = G_ERRORS_MANAGER->get_journal_id();
+    G_ERRORS_MANAGER->set_cmd( base_error::C_CMD_ACCEPT, 250, 1, 0 );
+    G_ERRORS_MANAGER->save_changes_as_Lua_str( buff, id, is_full );
+    EXPECT_FALSE( is_full );
+    EXPECT_STREQ( "\t{ id_type = 250, id_n = 1, alarms =\n\t{\n\t} },\n",
+        buff );
+
+    //Несколько изменений одного объекта - одна запись.
+    id = G_ERRORS_MANAGER->get_journal_id();
+    G_ERRORS_MANAGER->set_cmd( base_error::C_CMD_SUPPRESS, 250, 1, 0 );
+    G_ERRORS_MANAGER->set_cmd( base_error::C_CMD_SUPPRESS, 250, 1, 0 );
+    G_ERRORS_MANAGER->save_changes_as_Lua_str( buff, id, is_full );
+    EXPECT_FALSE( is_full );
+    EXPECT_STREQ( "\t{ id_type = 250, id_n = 1, alarms =\n\t{\n"
+        "\t{ state=1 },\n\t} },\n", buff );
+
+    //Неизвестный номер - полный список.
+    G_ERRORS_MANAGER->save_changes_as_Lua_str( buff,
+        G_ERRORS_MANAGER->get_journal_id() + 1, is_full );
+    EXPECT_TRUE( is_full );
+    EXPECT_NE( nullptr, strstr( buff, "id_type = 250, id_n = 1" ) );
+
+    //Записи журнала перезаписаны - полный список.
+    id = G_ERRORS_MANAGER->get_journal_id();
+    for ( int i = 0; i < 300; i++ )
+        {
+        G_ERRORS_MANAGER->set_cmd( base_error::C_CMD_SUPPRESS, 250, 1, 0 );
+        }
+    G_ERRORS_MANAGER->save_changes_as_Lua_str( buff, id, is_full );
+    EXPECT_TRUE( is_full );
+
+    EXPECT_EQ( 0, G_ERRORS_MANAGER->remove_error( &err ) );
+    EXPECT_EQ( 1, G_ERRORS_MANAGER->remove_error( &err ) );
+    }
+
+TEST( errors_manager, remove_dev_errors )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "V" );
+
+    const int BUFF_SIZE = 10000;
+    char buff[ BUFF_SIZE ] = { 0 };
+    bool is_full = false;
+
+    u_int_4 id = G_ERRORS_MANAGER->get_journal_id();
+    G_DEVICE_MANAGER()->clear_io_devices();
+    EXPECT_NE( id, G_ERRORS_MANAGER->get_journal_id() );
+    G_ERRORS_MANAGER->save_changes_as_Lua_str( buff, id, is_full );
+    EXPECT_TRUE( is_full );
+    }
+
+TEST( errors_manager, evaluate )
+    {
+    auto mngr = G_ERRORS_MANAGER;
+    auto dev_mngr = G_DEVICE_MANAGER();
+    dev_mngr->clear_io_devices();
+    dev_mngr->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "V" );
+    dev_mngr->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V2", "Test valve", "V" );
+    dev_mngr->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V3", "Test valve", "V" );
+    auto v2 = dynamic_cast<virtual_valve*>( dev_mngr->get_V( "V2" ) );
+    ASSERT_NE( nullptr, v2 );
+
+    //Изменения состояний устройств не отслеживаются - обновляются все
+    //ошибки.
+    mngr->evaluate();
+    auto all_cnt = mngr->get_evaluated_count();
+    ASSERT_GE( all_cnt, 3u );
+
+    //Первое обновление - изменились все устройства.
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( all_cnt, mngr->get_evaluated_count() );
+
+    //Устройства не изменились - их ошибки не обновляются.
+    auto polled_cnt = all_cnt - 3;
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt, mngr->get_evaluated_count() );
+
+    //Ошибка устройства.
+    auto id = mngr->get_journal_id();
+    v2->direct_set_state( valve::VALVE_STATE_EX::VX_ON_FB_ERR );
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+    EXPECT_EQ( id + 1, mngr->get_journal_id() );
+
+    //Активная ошибка обновляется, пока не вернется в норму.
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+    EXPECT_EQ( id + 1, mngr->get_journal_id() );
+
+    //Устройство вернулось в норму, ошибка не подтверждена.
+    v2->direct_set_state( valve::VALVE_STATE_EX::VX_OFF_FB_OK );
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+    EXPECT_EQ( id + 2, mngr->get_journal_id() );
+
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+
+    //Подтверждение - ошибка обновляется последний раз.
+    mngr->set_cmd( base_error::C_CMD_ACCEPT, device::DT_V,
+        v2->get_serial_n(), 0 );
+    EXPECT_EQ( id + 3, mngr->get_journal_id() );
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt, mngr->get_evaluated_count() );
+    EXPECT_EQ( id + 3, mngr->get_journal_id() );
+
+    //Ошибки, не связанные с устройствами, обновляются каждый раз.
+    test_error err;
+    mngr->add_error( &err );
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+    EXPECT_EQ( 1, err.evaluate_cnt );
+
+    dev_mngr->update_errors();
+    mngr->evaluate();
+    EXPECT_EQ( polled_cnt + 1, mngr->get_evaluated_count() );
+    EXPECT_EQ( 2, err.evaluate_cnt );
+
+    mngr->remove_error( &err );
+    dev_mngr->clear_io_devices();
+    }
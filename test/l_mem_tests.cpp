@@ -0,0 +1,83 @@
+#include "l_mem_tests.h"
+
+using namespace ::testing;
+
+#ifdef LINUX_OS
+
+class test_mapped_SRAM
+    {
+    public:
+        static mapped_SRAM* create( const char *file_name, u_int total_size,
+            u_int start_pos )
+            {
+            return new mapped_SRAM( file_name, total_size, start_pos,
+                start_pos + total_size - 1 );
+            }
+
+        static void remove( mapped_SRAM *mem )
+            {
+            delete mem;
+            }
+    };
+
+TEST( mapped_SRAM, read_write )
+    {
+    char file_name[] = "/tmp/ptusa_nvram_XXXXXX";
+    int f = mkstemp( file_name );
+    ASSERT_GE( f, 0 );
+    close( f );
+
+    const u_int SIZE = 16;
+    auto mem = test_mapped_SRAM::create( file_name, SIZE, SIZE );
+    NV_memory *nv = mem;
+
+    char buff[ SIZE ] = "test data";
+    EXPECT_EQ( (int)SIZE, nv->write( buff, SIZE, 0 ) );
+    EXPECT_EQ( 0, mem->sync() );
+
+    char res[ SIZE ] = { 0 };
+    EXPECT_EQ( (int)SIZE, nv->read( res, SIZE, 0 ) );
+    EXPECT_STREQ( buff, res );
+
+    //Выход за пределы памяти.
+    EXPECT_EQ( -1, nv->read( res, SIZE, 1 ) );
+    EXPECT_EQ( -1, nv->write( buff, SIZE, 1 ) );
+
+    //Данные сохраняются в файле (по смещению начального адреса).
+    char new_buff[ SIZE ] = "new data";
+    nv->write( new_buff, SIZE, 0 );
+    test_mapped_SRAM::remove( mem );
+
+    f = open( file_name, O_RDONLY );
+    ASSERT_GE( f, 0 );
+    memset( res, 0, SIZE );
+    EXPECT_EQ( (ssize_t)SIZE, pread( f, res, SIZE, SIZE ) );
+    EXPECT_STREQ( new_buff, res );
+    close( f );
+
+    mem = test_mapped_SRAM::create( file_name, SIZE, SIZE );
+    nv = mem;
+    memset( res, 0, SIZE );
+    EXPECT_EQ( (int)SIZE, nv->read( res, SIZE, 0 ) );
+    EXPECT_STREQ( new_buff, res );
+    test_mapped_SRAM::remove( mem );
+
+    unlink( file_name );
+    }
+
+TEST( mapped_SRAM, open_error )
+    {
+    const u_int SIZE = 16;
+    auto mem = test_mapped_SRAM::create( "/nonexistent_dir/nvram.txt", SIZE,
+        0 );
+    NV_memory *nv = mem;
+
+    char buff[ SIZE ] = { 0 };
+    EXPECT_EQ( -1, nv->read( buff, SIZE, 0 ) );
+    EXPECT_EQ( -1, nv->write( buff, SIZE, 0 ) );
+    EXPECT_EQ( 0, mem->sync() );
+
+    test_mapped_SRAM::remove( mem );
+    }
+
+#endif
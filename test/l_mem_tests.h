@@ -0,0 +1,9 @@
+#pragma once
+#include "includes.h"
+
+#ifdef LINUX_OS
+#include "l_mem.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
@@ -42,5 +42,88 @@ TEST( tcp_communicator_linux, checkBuff )
 
     EXPECT_FALSE( res );
     }
+
+TEST( tcp_communicator_linux, sendallv )
+    {
+    int sv[ 2 ];
+    ASSERT_EQ( 0, socketpair( AF_UNIX, SOCK_STREAM, 0, sv ) );
+
+    u_char header[] = { 's', 1, 2 };
+    u_char data1[] = "data";
+    u_char data2[] = "segment";
+    iovec iov[] = {
+        { header, sizeof( header ) },
+        { data1, sizeof( data1 ) - 1 },
+        { data2, sizeof( data2 ) - 1 } };
+
+    auto res = tcp_communicator_linux::sendallv( sv[ 0 ], iov, 3, 0, 50000,
+        "127.0.0.1", "test", nullptr );
+    EXPECT_GT( res, 0 );
+
+    u_char buff[ 100 ] = { 0 };
+    auto size = recv( sv[ 1 ], buff, sizeof( buff ), 0 );
+    EXPECT_EQ( 14, size );
+    EXPECT_EQ( 0, memcmp( "s\x01\x02" "datasegment", buff, 14 ) );
+
+    close( sv[ 0 ] );
+    close( sv[ 1 ] );
+    }
+
+TEST( tcp_communicator_linux, sendallv_zerocopy )
+    {
+#ifdef SO_ZEROCOPY
+    int listener = socket( AF_INET, SOCK_STREAM, 0 );
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl( INADDR_LOOPBACK );
+    socklen_t addr_len = sizeof( addr );
+    ASSERT_EQ( 0, bind( listener, ( sockaddr* ) &addr, addr_len ) );
+    ASSERT_EQ( 0, listen( listener, 1 ) );
+    ASSERT_EQ( 0, getsockname( listener, ( sockaddr* ) &addr, &addr_len ) );
+
+    int client = socket( AF_INET, SOCK_STREAM, 0 );
+    ASSERT_EQ( 0, connect( client, ( sockaddr* ) &addr, addr_len ) );
+    int server = accept( listener, nullptr, nullptr );
+    ASSERT_GE( server, 0 );
+
+    int one = 1;
+    if ( setsockopt( server, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof( one ) ) )
+        {
+        close( server );
+        close( client );
+        close( listener );
+        return; // MSG_ZEROCOPY не поддерживается.
+        }
+
+    std::vector< u_char > data( 32 * 1024 );
+    for ( size_t i = 0; i < data.size(); i++ ) data[ i ] = i % 251;
+    u_char header[] = { 's', 1, 2 };
+    iovec iov[] = {
+        { header, sizeof( header ) },
+        { data.data(), data.size() } };
+
+    u_int zerocopy_cnt = 0;
+    auto res = tcp_communicator_linux::sendallv( server, iov, 2, 0, 50000,
+        "127.0.0.1", "test", nullptr, &zerocopy_cnt );
+    EXPECT_GT( res, 0 );
+    EXPECT_GT( zerocopy_cnt, 0u );
+
+    std::vector< u_char > buff( sizeof( header ) + data.size() );
+    size_t size = 0;
+    while ( size < buff.size() )
+        {
+        auto n = recv( client, buff.data() + size, buff.size() - size, 0 );
+        ASSERT_GT( n, 0 );
+        size += n;
+        }
+    EXPECT_EQ( 0, memcmp( header, buff.data(), sizeof( header ) ) );
+    EXPECT_EQ( 0, memcmp( data.data(), buff.data() + sizeof( header ),
+        data.size() ) );
+
+    close( server );
+    close( client );
+    close( listener );
+#endif // SO_ZEROCOPY
+    }
     
 #endif
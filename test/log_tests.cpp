@@ -0,0 +1,98 @@
+#include "log_tests.h"
+
+#include <string>
+#include <vector>
+
+using namespace ::testing;
+
+class test_sink_log : public i_log
+    {
+    public:
+        test_sink_log( std::vector< std::string >& messages ) :
+            messages( messages )
+            {
+            }
+
+        void write_log( PRIORITIES priority ) override
+            {
+            messages.push_back( std::to_string( priority ) + " " + msg );
+            times.push_back( msg_time );
+            }
+
+        std::vector< std::time_t > times;
+
+    private:
+        std::vector< std::string >& messages;
+    };
+
+TEST( deferred_log, write_log )
+    {
+    std::vector< std::string > messages;
+    deferred_log lg( new test_sink_log( messages ) );
+
+    lg.info( "Message %d.", 1 );
+    lg.error( "Message %d.", 2 );
+    EXPECT_TRUE( messages.empty() );
+    EXPECT_EQ( 2u, lg.get_queued_count() );
+
+    lg.evaluate();
+    EXPECT_EQ( 0u, lg.get_queued_count() );
+    ASSERT_EQ( 2u, messages.size() );
+    EXPECT_EQ( "6 Message 1.", messages[ 0 ] );
+    EXPECT_EQ( "3 Message 2.", messages[ 1 ] );
+
+    //Передается время записи сообщения в буфер.
+    auto sink = new test_sink_log( messages );
+    deferred_log lg2( sink );
+    auto t = std::time( nullptr );
+    lg2.info( "Message 3." );
+    lg2.evaluate();
+    ASSERT_EQ( 1u, sink->times.size() );
+    EXPECT_LE( t, sink->times[ 0 ] );
+    EXPECT_GE( t + 1, sink->times[ 0 ] );
+    EXPECT_EQ( 0, sink->msg_time );
+
+    //Критические сообщения записываются сразу, после отложенных.
+    lg2.info( "Message 4." );
+    lg2.critical( "Message 5." );
+    EXPECT_EQ( 0u, lg2.get_queued_count() );
+    ASSERT_EQ( 5u, messages.size() );
+    EXPECT_EQ( "6 Message 4.", messages[ 3 ] );
+    EXPECT_EQ( "2 Message 5.", messages[ 4 ] );
+    EXPECT_NE( 0, sink->times[ 2 ] );
+    messages.resize( 2 );
+
+    //Сообщение максимальной длины записывается полностью.
+    std::string long_msg( i_log::C_BUFF_SIZE - 1, 'a' );
+    lg.write_log( i_log::P_INFO, long_msg.c_str() );
+    lg.flush();
+    ASSERT_EQ( 3u, messages.size() );
+    EXPECT_EQ( "6 " + long_msg, messages[ 2 ] );
+    }
+
+TEST( deferred_log, overflow )
+    {
+    std::vector< std::string > messages;
+    deferred_log lg( new test_sink_log( messages ) );
+
+    //Буфер переполняется - сообщения отбрасываются.
+    std::string msg( 1000, 'a' );
+    const unsigned long CNT = 2 * deferred_log::C_RING_SIZE / 1000;
+    for ( unsigned long i = 0; i < CNT; i++ )
+        {
+        lg.write_log( i_log::P_INFO, msg.c_str() );
+        }
+    EXPECT_GT( lg.get_dropped_count(), 0u );
+    EXPECT_EQ( CNT, lg.get_queued_count() + lg.get_dropped_count() );
+
+    //Количество отброшенных сообщений выводится после записи буфера.
+    lg.flush();
+    ASSERT_EQ( 0u, lg.get_queued_count() );
+    EXPECT_EQ( CNT - lg.get_dropped_count() + 1, messages.size() );
+    EXPECT_NE( std::string::npos, messages.back().find( "dropped" ) );
+
+    //После записи буфера сообщения снова принимаются.
+    lg.info( "Message." );
+    lg.evaluate();
+    EXPECT_EQ( "6 Message.", messages.back() );
+    }
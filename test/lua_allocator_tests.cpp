@@ -0,0 +1,100 @@
+#include "lua_allocator_tests.h"
+
+using namespace ::testing;
+
+TEST( lua_allocator, alloc )
+    {
+    lua_allocator a;
+    EXPECT_EQ( 0u, a.get_live_bytes() );
+    EXPECT_EQ( 0u, a.get_reserved_bytes() );
+
+    // Малый блок - из пула.
+    auto p1 = lua_allocator::alloc( &a, nullptr, 0, 20 );
+    ASSERT_NE( nullptr, p1 );
+    memset( p1, 1, 20 );
+    EXPECT_EQ( 20u, a.get_live_bytes() );
+    EXPECT_EQ( (size_t) lua_allocator::C_PAGE_SIZE, a.get_reserved_bytes() );
+    EXPECT_EQ( 1u, a.get_class_stat( 1 ).used_cnt );
+    EXPECT_EQ( 1u, a.get_class_stat( 1 ).alloc_cnt );
+    EXPECT_EQ( (u_long) lua_allocator::C_PAGE_SIZE / 32 - 1,
+        a.get_class_stat( 1 ).free_cnt );
+
+    // Изменение размера в пределах класса - тот же блок.
+    auto p2 = lua_allocator::alloc( &a, p1, 20, 30 );
+    EXPECT_EQ( p1, p2 );
+    EXPECT_EQ( 30u, a.get_live_bytes() );
+
+    // Переход в другой класс - данные копируются.
+    auto p3 = lua_allocator::alloc( &a, p2, 30, 100 );
+    ASSERT_NE( nullptr, p3 );
+    EXPECT_EQ( 1, static_cast< char* >( p3 )[ 19 ] );
+    EXPECT_EQ( 100u, a.get_live_bytes() );
+    EXPECT_EQ( 0u, a.get_class_stat( 1 ).used_cnt );
+    EXPECT_EQ( 1u, a.get_class_stat( 6 ).used_cnt );
+
+    // Большой блок.
+    auto p4 = lua_allocator::alloc( &a, p3, 100, 1000 );
+    ASSERT_NE( nullptr, p4 );
+    EXPECT_EQ( 1, static_cast< char* >( p4 )[ 19 ] );
+    EXPECT_EQ( 1000u, a.get_live_bytes() );
+    EXPECT_EQ( 1u, a.get_big_blocks_cnt() );
+
+    auto p5 = lua_allocator::alloc( &a, p4, 1000, 2000 );
+    ASSERT_NE( nullptr, p5 );
+    EXPECT_EQ( 2000u, a.get_live_bytes() );
+    EXPECT_EQ( 2000u, a.get_peak_bytes() );
+
+    EXPECT_EQ( nullptr, lua_allocator::alloc( &a, p5, 2000, 0 ) );
+    EXPECT_EQ( 0u, a.get_live_bytes() );
+    EXPECT_EQ( 0u, a.get_big_blocks_cnt() );
+    EXPECT_EQ( 2000u, a.get_peak_bytes() );
+    }
+
+TEST( lua_allocator, reuse )
+    {
+    lua_allocator a;
+
+    // Освобожденный блок используется повторно.
+    auto p1 = lua_allocator::alloc( &a, nullptr, 0, 64 );
+    lua_allocator::alloc( &a, p1, 64, 0 );
+    auto p2 = lua_allocator::alloc( &a, nullptr, 0, 50 );
+    EXPECT_EQ( p1, p2 );
+    lua_allocator::alloc( &a, p2, 50, 0 );
+
+    // Новая страница выделяется только при исчерпании свободных блоков.
+    const int CNT = lua_allocator::C_PAGE_SIZE /
+        lua_allocator::C_MAX_SMALL_SIZE + 1;
+    std::vector< void* > blocks;
+    for ( int i = 0; i < CNT; i++ )
+        {
+        blocks.push_back( lua_allocator::alloc( &a, nullptr, 0,
+            lua_allocator::C_MAX_SMALL_SIZE ) );
+        }
+    // Страница для класса 64 и две страницы для класса 256.
+    EXPECT_EQ( 3u * lua_allocator::C_PAGE_SIZE, a.get_reserved_bytes() );
+
+    for ( auto p : blocks )
+        {
+        lua_allocator::alloc( &a, p, lua_allocator::C_MAX_SMALL_SIZE, 0 );
+        }
+    EXPECT_EQ( 0u, a.get_live_bytes() );
+    EXPECT_EQ( 3u * lua_allocator::C_PAGE_SIZE, a.get_reserved_bytes() );
+    EXPECT_EQ( 0u, a.get_class_stat( lua_allocator::C_CLASS_CNT - 1 ).used_cnt );
+    }
+
+TEST( lua_allocator, save_as_Lua_str )
+    {
+    lua_allocator a;
+    auto p = lua_allocator::alloc( &a, nullptr, 0, 10 );
+
+    char buff[ 2000 ] = { 0 };
+    auto size = a.save_as_Lua_str( buff, sizeof( buff ) );
+    EXPECT_EQ( (int) strlen( buff ), size );
+    EXPECT_NE( nullptr, strstr( buff, "live = 10," ) );
+    EXPECT_NE( nullptr, strstr( buff, "[ 16 ] = { used = 1," ) );
+
+    size = a.save_as_Lua_str( buff, 10 );
+    EXPECT_EQ( 9, size );
+
+    lua_allocator::alloc( &a, p, 10, 0 );
+    }
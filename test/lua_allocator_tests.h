@@ -0,0 +1,3 @@
+#pragma once
+#include "includes.h"
+#include "lua_allocator.h"
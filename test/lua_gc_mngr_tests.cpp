@@ -0,0 +1,93 @@
+#include "lua_gc_mngr_tests.h"
+
+using namespace ::testing;
+
+TEST( lua_gc_manager, get_step_size )
+    {
+    auto gc = G_LUA_GC_MANAGER;
+    gc->set_step_limits( 20, 1000 );
+
+    // Нет запаса времени - шаг не меньше минимального.
+    auto step = gc->get_step_size( 0 );
+    EXPECT_GE( step, 20u );
+    EXPECT_LE( step, 1000u );
+
+    // Большой запас времени - шаг ограничен максимальным.
+    EXPECT_EQ( 1000u, gc->get_step_size( 100000000 ) );
+
+    // Шаг растет вместе с запасом времени.
+    EXPECT_LE( gc->get_step_size( 100 ), gc->get_step_size( 10000 ) );
+
+    gc->set_step_limits( 10, 10 );
+    EXPECT_EQ( 10u, gc->get_step_size( 0 ) );
+    EXPECT_EQ( 10u, gc->get_step_size( 100000000 ) );
+
+    gc->set_step_limits( 0, 0 );
+    EXPECT_EQ( 1u, gc->get_step_size( 0 ) );
+
+    gc->set_step_limits( lua_gc_manager::C_DEFAULT_MIN_STEP,
+        lua_gc_manager::C_DEFAULT_MAX_STEP );
+    }
+
+TEST( lua_gc_manager, evaluate )
+    {
+    auto gc = G_LUA_GC_MANAGER;
+    gc->clear_stat();
+    gc->evaluate( nullptr, get_millisec() );
+    EXPECT_EQ( 0u, gc->get_avg_gc_time() );
+
+    auto L = luaL_newstate();
+    luaL_openlibs( L );
+
+    const char* GARBAGE =
+        "local t = {} for i = 1, 1000 do t[ i ] = { i, tostring( i ) } end";
+    for ( int i = 0; i < 10; i++ )
+        {
+        luaL_dostring( L, GARBAGE );
+        gc->evaluate( L, get_millisec() );
+        }
+    EXPECT_GT( gc->get_alloc_rate(), 0.f );
+    EXPECT_GT( gc->get_step_time_per_kb(), 0.f );
+    EXPECT_GE( gc->get_max_gc_time(), gc->get_last_gc_time() );
+    EXPECT_GE( gc->get_max_gc_time(), gc->get_avg_gc_time() );
+    EXPECT_EQ( 0u, gc->get_full_collect_cnt() );
+
+    // Превышен предел памяти, запас времени большой - полная сборка.
+    gc->set_memory_limit( 1 );
+    luaL_dostring( L, GARBAGE );
+    gc->evaluate( L, get_millisec() );
+    EXPECT_EQ( 1u, gc->get_full_collect_cnt() );
+
+    // Превышен предел памяти, запаса времени нет - только шаг.
+    gc->set_cycle_time( 1 );
+    luaL_dostring( L, GARBAGE );
+    gc->evaluate( L, get_millisec() - 10 );
+    EXPECT_EQ( 1u, gc->get_full_collect_cnt() );
+
+    // Запас времени большой, но интервал после полной сборки не истек.
+    gc->set_cycle_time( lua_gc_manager::C_DEFAULT_CYCLE_TIME );
+    luaL_dostring( L, GARBAGE );
+    gc->evaluate( L, get_millisec() );
+    EXPECT_EQ( 1u, gc->get_full_collect_cnt() );
+
+    gc->set_full_collect_interval( 0 );
+    gc->evaluate( L, get_millisec() );
+    EXPECT_EQ( 2u, gc->get_full_collect_cnt() );
+
+    // Превышение устранено - новое превышение, сборка без ожидания.
+    gc->set_full_collect_interval(
+        lua_gc_manager::C_DEFAULT_FULL_COLLECT_INTERVAL );
+    gc->set_memory_limit( 100000 );
+    gc->evaluate( L, get_millisec() );
+    gc->set_memory_limit( 1 );
+    gc->evaluate( L, get_millisec() );
+    EXPECT_EQ( 3u, gc->get_full_collect_cnt() );
+
+    gc->set_memory_limit( 0 );
+    gc->set_cycle_time( lua_gc_manager::C_DEFAULT_CYCLE_TIME );
+    gc->print_to_log();
+    gc->clear_stat();
+    EXPECT_EQ( 0u, gc->get_full_collect_cnt() );
+
+    lua_close( L );
+    }
@@ -0,0 +1,151 @@
+#include "lua_hot_reload_tests.h"
+
+using namespace ::testing;
+
+static void write_script( const char* path, const char* text )
+    {
+    FILE* f = fopen( path, "w" );
+    ASSERT_NE( nullptr, f );
+    fputs( text, f );
+    fclose( f );
+    }
+
+static void reload( const char* path )
+    {
+    auto hr = G_LUA_HOT_RELOAD;
+    EXPECT_EQ( 0, hr->start( path ) );
+    EXPECT_EQ( lua_hot_reload::S_LOAD, hr->get_state() );
+
+    for ( int i = 0; i < 100 && ( lua_hot_reload::S_LOAD == hr->get_state() ||
+        lua_hot_reload::S_DIFF == hr->get_state() ); i++ )
+        {
+        hr->evaluate();
+        }
+    }
+
+TEST( lua_hot_reload, start )
+    {
+    auto hr = G_LUA_HOT_RELOAD;
+    G_LUA_MANAGER->set_Lua( nullptr );
+
+    EXPECT_EQ( 1, hr->start( "hot_reload_test.lua" ) );
+    EXPECT_EQ( lua_hot_reload::S_ERROR, hr->get_state() );
+
+    char buff[ 500 ] = { 0 };
+    auto size = hr->save_as_Lua_str( buff, sizeof( buff ) );
+    EXPECT_EQ( strlen( buff ), static_cast< size_t >( size ) );
+    EXPECT_NE( nullptr, strstr( buff, "state = 4" ) );
+    }
+
+TEST( lua_hot_reload, evaluate )
+    {
+    const char* PATH = "hot_reload_test.lua";
+    lua_manager::switch_off_bytecode_cache();
+
+    lua_State* L = lua_open();
+    luaL_openlibs( L );
+    G_LUA_MANAGER->set_Lua( L );
+
+    write_script( PATH,
+        "obj = obj or {}\n"
+        "obj.counter = 5\n"
+        "function obj:get() return 1 end\n"
+        "function obj:same() return self.counter end\n"
+        "function g() return 1 end\n" );
+    ASSERT_EQ( 0, luaL_dofile( L, PATH ) );
+
+    // Изменена одна функция и добавлена новая, состояние объекта
+    // сохраняется.
+    write_script( PATH,
+        "obj = obj or {}\n"
+        "obj.counter = 0\n"
+        "function obj:get() return 2 end\n"
+        "function obj:same() return self.counter end\n"
+        "function g() return 1 end\n"
+        "local o = obj\n"
+        "function obj:get_counter() return o.counter end\n" );
+
+    auto hr = G_LUA_HOT_RELOAD;
+    hr->set_budget( 1000000 );
+    reload( PATH );
+    ASSERT_EQ( lua_hot_reload::S_DONE, hr->get_state() );
+    EXPECT_EQ( 2u, hr->get_changed_cnt() );
+    EXPECT_EQ( 2u, hr->get_unchanged_cnt() );
+    EXPECT_GE( hr->get_latency(), hr->get_max_step_time() );
+    EXPECT_EQ( 0, lua_gettop( L ) );
+
+    EXPECT_EQ( 0, luaL_dostring( L,
+        "assert( obj.counter == 5 )\n"
+        "assert( obj:get() == 2 )\n"
+        "obj.counter = 7\n"
+        "assert( obj:get_counter() == 7 )" ) );
+
+    char buff[ 500 ] = { 0 };
+    hr->save_as_Lua_str( buff, sizeof( buff ) );
+    EXPECT_NE( nullptr, strstr( buff, "\"obj:get\"" ) );
+    EXPECT_NE( nullptr, strstr( buff, "\"obj:get_counter\"" ) );
+    EXPECT_EQ( nullptr, strstr( buff, "\"obj:same\"" ) );
+
+    // Ошибка в скрипте - функции не заменяются.
+    write_script( PATH, "function obj:get() return 3 end\n error( 'test' )\n" );
+    reload( PATH );
+    EXPECT_EQ( lua_hot_reload::S_ERROR, hr->get_state() );
+    EXPECT_EQ( 0, luaL_dostring( L, "assert( obj:get() == 2 )" ) );
+    EXPECT_EQ( 0, lua_gettop( L ) );
+
+    hr->set_budget( lua_hot_reload::C_DEFAULT_BUDGET );
+    G_LUA_MANAGER->free_Lua();
+    lua_manager::switch_on_bytecode_cache();
+    remove( PATH );
+    }
+
+TEST( lua_hot_reload, inserted_lines )
+    {
+    const char* PATH = "hot_reload_test.lua";
+    lua_manager::switch_off_bytecode_cache();
+
+    lua_State* L = lua_open();
+    luaL_openlibs( L );
+    G_LUA_MANAGER->set_Lua( L );
+
+    write_script( PATH,
+        "obj = obj or {}\n"
+        "function obj:get() return 1 end\n"
+        "function obj:check( v )\n"
+        "    local f = function() return v end\n"
+        "    assert( f() )\n"
+        "end\n" );
+    ASSERT_EQ( 0, luaL_dofile( L, PATH ) );
+
+    // Вставлены строки - номера строк функций изменились, сами функции -
+    // нет.
+    write_script( PATH,
+        "-- Комментарий.\n"
+        "\n"
+        "obj = obj or {}\n"
+        "function obj:get() return 1 end\n"
+        "\n"
+        "function obj:check( v )\n"
+        "    local f = function() return v end\n"
+        "\n"
+        "    assert( f() )\n"
+        "end\n" );
+
+    // Компиляция, выполнение скрипта и сравнение функций - в разных циклах.
+    auto hr = G_LUA_HOT_RELOAD;
+    EXPECT_EQ( 0, hr->start( PATH ) );
+    hr->evaluate();
+    EXPECT_EQ( lua_hot_reload::S_LOAD, hr->get_state() );
+    hr->evaluate();
+    EXPECT_EQ( lua_hot_reload::S_DIFF, hr->get_state() );
+    EXPECT_EQ( 0u, hr->get_unchanged_cnt() );
+    hr->evaluate();
+    ASSERT_EQ( lua_hot_reload::S_DONE, hr->get_state() );
+    EXPECT_EQ( 0u, hr->get_changed_cnt() );
+    EXPECT_EQ( 2u, hr->get_unchanged_cnt() );
+    EXPECT_EQ( 0, lua_gettop( L ) );
+
+    G_LUA_MANAGER->free_Lua();
+    lua_manager::switch_on_bytecode_cache();
+    remove( PATH );
+    }
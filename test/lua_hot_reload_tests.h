@@ -0,0 +1,4 @@
+#pragma once
+#include "includes.h"
+#include "lua_hot_reload.h"
+#include "lua_manager.h"
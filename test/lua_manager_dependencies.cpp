@@ -14,16 +14,21 @@ void LuaManagerTest::SetUp()
 	lua_hooks.push_back(subhook_new((void *) luaL_loadstring,       (void *) mock_luaL_loadstring,      SUBHOOK_64BIT_OFFSET));
 	lua_hooks.push_back(subhook_new((void *) tolua_tousertype,      (void *) mock_tolua_tousertype,     SUBHOOK_64BIT_OFFSET));
 	lua_hooks.push_back(subhook_new((void *) luaL_loadfile,         (void *) mock_luaL_loadfile,        SUBHOOK_64BIT_OFFSET));
-	lua_hooks.push_back(subhook_new((void *) luaL_newstate,         (void *) mock_luaL_newstate,        SUBHOOK_64BIT_OFFSET));
+	lua_hooks.push_back(subhook_new((void *) lua_newstate,          (void *) mock_lua_newstate,         SUBHOOK_64BIT_OFFSET));
+	lua_hooks.push_back(subhook_new((void *) lua_atpanic,           (void *) mock_lua_atpanic,          SUBHOOK_64BIT_OFFSET));
 	lua_hooks.push_back(subhook_new((void *) lua_gc,                (void *) mock_lua_gc,               SUBHOOK_64BIT_OFFSET));
 	lua_hooks.push_back(subhook_new((void *) luaL_openlibs,         (void *) mock_luaL_openlibs,        SUBHOOK_64BIT_OFFSET));
 	lua_hooks.push_back(subhook_new((void *) tolua_PAC_dev_open,    (void *) mock_tolua_PAC_dev_open,   SUBHOOK_64BIT_OFFSET));
+	lua_hooks.push_back(subhook_new((void *) tolua_PAC_dev_fast_open, (void *) mock_tolua_PAC_dev_fast_open, SUBHOOK_64BIT_OFFSET));
 	lua_hooks.push_back(subhook_new((void *) tolua_IOT_dev_open,    (void *) mock_tolua_IOT_dev_open,   SUBHOOK_64BIT_OFFSET));
 
 	lua_hooks.push_back(subhook_new((void *) check_file,            (void *) mock_check_file,           SUBHOOK_64BIT_OFFSET));
     lua_hooks.push_back(subhook_new((void *) G_TECH_OBJECT_MNGR,    (void *) mock_G_TECH_OBJECT_MNGR,   SUBHOOK_64BIT_OFFSET));
     lua_hooks.push_back(subhook_new((void *) lua_tolstring,         (void *) mock_lua_tolstring,        SUBHOOK_64BIT_OFFSET));
     lua_hooks.push_back(subhook_new((void *) lua_settop,            (void *) mock_lua_settop,           SUBHOOK_64BIT_OFFSET));
+    lua_hooks.push_back(subhook_new((void *) lua_rawgeti,           (void *) mock_lua_rawgeti,          SUBHOOK_64BIT_OFFSET));
+    lua_hooks.push_back(subhook_new((void *) luaL_ref,              (void *) mock_luaL_ref,             SUBHOOK_64BIT_OFFSET));
+    lua_hooks.push_back(subhook_new((void *) luaL_unref,            (void *) mock_luaL_unref,           SUBHOOK_64BIT_OFFSET));
 
 	// Install hooks
 	for (size_t i = 0; i < lua_hooks.size(); i++) {
@@ -50,6 +55,16 @@ void set_lua_pcall_success_calls_before_failure(int val)
     lua_pcall_state = val;
 }
 
+void set_lua_getfield_counter(int val)
+{
+    lua_getfield_counter = val;
+}
+
+int get_lua_getfield_counter()
+{
+    return lua_getfield_counter;
+}
+
 /****************** MOCKED (HOOKED) FUNCTIONS *****************/
 
 void mock_lua_pushcclosure(lua_State *L, lua_CFunction fn, int n)
@@ -66,7 +81,9 @@ int mock_lua_type(lua_State* L, int idx)
 }
 
 void mock_lua_getfield(lua_State *L, int idx, const char *k)
-{}
+{
+    lua_getfield_counter++;
+}
 
 void mock_lua_remove(lua_State *L, int idx)
 {}
@@ -104,11 +121,16 @@ int	mock_luaL_loadfile(lua_State *L, const char *filename)
 	return 0;
 }
 
-lua_State* mock_luaL_newstate(void)
+lua_State* mock_lua_newstate(lua_Alloc f, void *ud)
 {
     return new lua_State;
 }
 
+lua_CFunction mock_lua_atpanic(lua_State *L, lua_CFunction panicf)
+{
+    return nullptr;
+}
+
 int	mock_lua_gc(lua_State *L, int what, int data)
 {
 	return 0;
@@ -127,6 +149,11 @@ int	mock_tolua_IOT_dev_open(lua_State* tolua_S)
 	return 0;
 }
 
+int	mock_tolua_PAC_dev_fast_open(lua_State* L)
+{
+	return 0;
+}
+
 int	mock_tolua_OPC_UA_open(lua_State* tolua_S)
 {
 	return 0;
@@ -149,7 +176,7 @@ tech_object_manager * mock_G_TECH_OBJECT_MNGR()
 	return mock_tech_object_manager::get_instance();
 }
 
-lua_State * mock_luaL_newstate_failure(void)
+lua_State * mock_lua_newstate_failure(lua_Alloc f, void *ud)
 {
     return NULL;
 }
@@ -173,6 +200,18 @@ const char * mock_lua_tolstring(lua_State * L, int idx, size_t * len)
 void mock_lua_settop(lua_State * L, int idx)
 {}
 
+void mock_lua_rawgeti(lua_State * L, int idx, int n)
+{}
+
+int mock_luaL_ref(lua_State * L, int t)
+{
+    static int ref = 0;
+    return ++ref;
+}
+
+void mock_luaL_unref(lua_State * L, int t, int ref)
+{}
+
 int mock_check_file_failure(const char * file_name, char * err_str)
 {
     strcpy(err_str, "mock_check_file_failure called");
@@ -21,8 +21,11 @@ protected:
 
 static int file_counter = 0;
 static int lua_pcall_state = 0;
+static int lua_getfield_counter = 0;
 void set_file_counter(int val);
 void set_lua_pcall_success_calls_before_failure(int val);
+void set_lua_getfield_counter(int val);
+int  get_lua_getfield_counter();
 
 // general mocks of hooked functions
 void        mock_lua_pushcclosure(lua_State *L, lua_CFunction fn, int n);
@@ -37,20 +40,25 @@ const char* mock_tolua_tostring(lua_State* L, int narg, const char* def);
 lua_Number  mock_tolua_tonumber(lua_State* L, int narg, lua_Number def);
 void*       mock_tolua_tousertype(lua_State* L, int narg, void* def);
 int         mock_luaL_loadfile(lua_State *L, const char *filename);
-lua_State*  mock_luaL_newstate (void);
+lua_State*  mock_lua_newstate(lua_Alloc f, void *ud);
+lua_CFunction mock_lua_atpanic(lua_State *L, lua_CFunction panicf);
 int         mock_lua_gc(lua_State *L, int what, int data);
 void        mock_luaL_openlibs(lua_State *L);
 int         mock_tolua_PAC_dev_open(lua_State* tolua_S);
 int         mock_tolua_IOT_dev_open(lua_State* tolua_S);
+int         mock_tolua_PAC_dev_fast_open(lua_State* L);
 int         mock_tolua_OPC_UA_open(lua_State* tolua_S);
 void        mock_lua_close(lua_State *L);
 int         mock_check_file(const char* file_name, char* err_str);
 tech_object_manager* mock_G_TECH_OBJECT_MNGR();
 const char* mock_lua_tolstring(lua_State *L, int idx, size_t *len);
 void        mock_lua_settop(lua_State *L, int idx);
+void        mock_lua_rawgeti(lua_State *L, int idx, int n);
+int         mock_luaL_ref(lua_State *L, int t);
+void        mock_luaL_unref(lua_State *L, int t, int ref);
 
 // special mocks of hooked functions
-lua_State*  mock_luaL_newstate_failure(void);
+lua_State*  mock_lua_newstate_failure(lua_Alloc f, void *ud);
 int         mock_luaL_loadfile_failure(lua_State *L, const char *filename);
 int         mock_luaL_loadfile_failure_2(lua_State *L, const char *filename);
 int         mock_check_file_failure(const char* file_name, char* err_str);
@@ -29,7 +29,8 @@ TEST(lua_manager_test, get_instance)
 	int init(lua_State* L, const char* script_name, const char* dir = "", const char* sys_dir = "");
 
 	HOOKED:
-	LUALIB_API lua_State *(luaL_newstate) (void)
+	LUA_API lua_State *(lua_newstate) (lua_Alloc f, void *ud)
+	LUA_API lua_CFunction (lua_atpanic) (lua_State *L, lua_CFunction panicf)
 	LUA_API int lua_gc (lua_State *L, int what, int data)
 	LUALIB_API void luaL_openlibs (lua_State *L)
 	LUALIB_API int (luaL_loadstring) (lua_State *L, const char *s)
@@ -37,6 +38,7 @@ TEST(lua_manager_test, get_instance)
 	LUALIB_API int luaL_loadfile (lua_State *L, const char *filename)
 	TOLUA_API int tolua_PAC_dev_open (lua_State* tolua_S)
 	TOLUA_API int tolua_IOT_dev_open (lua_State* tolua_S)
+	int tolua_PAC_dev_fast_open (lua_State* L)
     LUA_API void lua_close (lua_State *L)
     LUA_API const char *lua_tolstring (lua_State *L, int idx, size_t *len)
     LUA_API void lua_settop (lua_State *L, int idx)
@@ -86,7 +88,7 @@ TEST_F(LuaManagerTest, init_creating_lua_context_failure)
 {
     lua_State *s = NULL;
     subhook_t hook_lua_create_context =
-        subhook_new((void *) luaL_newstate, (void *) mock_luaL_newstate_failure, SUBHOOK_64BIT_OFFSET);
+        subhook_new((void *) lua_newstate, (void *) mock_lua_newstate_failure, SUBHOOK_64BIT_OFFSET);
     subhook_install(hook_lua_create_context);
 
     EXPECT_EQ(1, G_LUA_MANAGER->init(NULL, "", "", ""));
@@ -645,7 +647,7 @@ TEST_F(LuaManagerTest, reload_script_lua_state_null_failure)
     // set lua_state to NULL
     lua_State *s = NULL;
     subhook_t hook_lua_create_context =
-        subhook_new((void *)luaL_newstate, (void *)mock_luaL_newstate_failure, SUBHOOK_64BIT_OFFSET);
+        subhook_new((void *)lua_newstate, (void *)mock_lua_newstate_failure, SUBHOOK_64BIT_OFFSET);
     subhook_install(hook_lua_create_context);
 
     EXPECT_EQ(1, G_LUA_MANAGER->init(NULL, "", "", ""));
@@ -753,3 +755,156 @@ TEST( lua_manager, error_trace )
     EXPECT_NE( 0, G_LUA_MANAGER->void_exec_lua_method( "t", "no_exist3", "error_trace" ) );
     G_LUA_MANAGER->free_Lua();
     }
+
+/*
+    TEST METHOD DEFENITION:
+    void clear_functions_cache();
+    size_t get_functions_cache_size() const;
+
+    HOOKED:
+    LUA_API void lua_getfield (lua_State *L, int idx, const char *k)
+    LUA_API void lua_rawgeti (lua_State *L, int idx, int n)
+    LUALIB_API int luaL_ref (lua_State *L, int t)
+    LUALIB_API void luaL_unref (lua_State *L, int t, int ref)
+*/
+
+TEST_F(LuaManagerTest, exec_lua_method_functions_cache)
+{
+    G_LUA_MANAGER->clear_functions_cache();
+    set_lua_getfield_counter(0);
+
+    EXPECT_EQ(0, G_LUA_MANAGER->void_exec_lua_method(
+                 "test_lua_object_str",
+                 "test_lua_func_str",
+                 "test_lua_c_func_str"));
+    EXPECT_EQ(2, get_lua_getfield_counter());
+    EXPECT_EQ(1u, G_LUA_MANAGER->get_functions_cache_size());
+
+    // Second call uses cached object and function.
+    EXPECT_EQ(0, G_LUA_MANAGER->void_exec_lua_method(
+                 "test_lua_object_str",
+                 "test_lua_func_str",
+                 "test_lua_c_func_str"));
+    EXPECT_EQ(2, get_lua_getfield_counter());
+    EXPECT_EQ(1u, G_LUA_MANAGER->get_functions_cache_size());
+
+    G_LUA_MANAGER->clear_functions_cache();
+    EXPECT_EQ(0u, G_LUA_MANAGER->get_functions_cache_size());
+}
+
+TEST( lua_manager, functions_cache )
+    {
+    auto L = lua_open();
+    G_LUA_MANAGER->set_Lua( L );
+
+    EXPECT_EQ( 0, luaL_dostring( L,
+        "t = { f = function( self ) return 1 end }\n"
+        "function g() return 10 end" ) );
+    auto top = lua_gettop( L );
+
+    EXPECT_EQ( 1, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+    EXPECT_EQ( 10, G_LUA_MANAGER->int_no_param_exec_lua_method( "", "g", "" ) );
+    EXPECT_EQ( 2u, G_LUA_MANAGER->get_functions_cache_size() );
+    EXPECT_TRUE( G_LUA_MANAGER->is_exist_lua_function( "t", "f" ) );
+    EXPECT_EQ( 2u, G_LUA_MANAGER->get_functions_cache_size() );
+
+    // Not existing object and function are not cached, stack stays balanced.
+    EXPECT_EQ( 1, G_LUA_MANAGER->void_exec_lua_method( "no_obj", "f", "" ) );
+    EXPECT_EQ( 1, G_LUA_MANAGER->void_exec_lua_method( "t", "no_f", "" ) );
+    EXPECT_FALSE( G_LUA_MANAGER->is_exist_lua_function( "t", "no_f" ) );
+    EXPECT_EQ( 2u, G_LUA_MANAGER->get_functions_cache_size() );
+    EXPECT_EQ( top, lua_gettop( L ) );
+
+    // Reassigned functions and objects are used after exec_Lua_str.
+    EXPECT_EQ( 0, G_LUA_MANAGER->exec_Lua_str(
+        "t.f = function( self ) return 2 end", "" ) );
+    EXPECT_EQ( 0u, G_LUA_MANAGER->get_functions_cache_size() );
+    EXPECT_EQ( 2, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+    EXPECT_EQ( 0, G_LUA_MANAGER->exec_Lua_str(
+        "t.no_f = function( self ) return 4 end", "" ) );
+    EXPECT_EQ( 4, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "no_f", "" ) );
+    EXPECT_EQ( 0, G_LUA_MANAGER->exec_Lua_str(
+        "function g() return 20 end", "" ) );
+    EXPECT_EQ( 20, G_LUA_MANAGER->int_no_param_exec_lua_method( "", "g", "" ) );
+    EXPECT_EQ( 0, G_LUA_MANAGER->exec_Lua_str(
+        "t = { f = function( self ) return 5 end }", "" ) );
+    EXPECT_EQ( 5, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+
+    // Direct assignment bypassing lua_manager requires clearing the cache.
+    EXPECT_EQ( 0, luaL_dostring( L, "t.f = function( self ) return 6 end" ) );
+    G_LUA_MANAGER->clear_functions_cache();
+    EXPECT_EQ( 6, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+
+    lua_manager::switch_off_functions_cache();
+    EXPECT_EQ( 0, luaL_dostring( L, "t.f = function( self ) return 3 end" ) );
+    EXPECT_EQ( 3, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+    lua_manager::switch_on_functions_cache();
+
+    EXPECT_EQ( top, lua_gettop( L ) );
+    G_LUA_MANAGER->free_Lua();
+    }
+
+TEST( lua_manager, load_file_bytecode_cache )
+    {
+    auto L = lua_open();
+    G_LUA_MANAGER->set_Lua( L );
+
+    const char* path = "test_bytecode_cache.lua";
+    const char* cache_path = "test_bytecode_cache.lua.luac";
+    remove( cache_path );
+
+    auto f = fopen( path, "w" );
+    ASSERT_NE( nullptr, f );
+    fputs( "#!/usr/bin/lua\nbc_value = 1\n", f );
+    fclose( f );
+
+    // Первая загрузка - компиляция исходного текста и сохранение байт-кода.
+    EXPECT_EQ( 0, G_LUA_MANAGER->load_file( path ) );
+    EXPECT_EQ( 0, lua_pcall( L, 0, 0, 0 ) );
+    f = fopen( cache_path, "rb" );
+    ASSERT_NE( nullptr, f );
+    fclose( f );
+
+    // Повторная загрузка - из сохраненного байт-кода.
+    EXPECT_EQ( 0, luaL_dostring( L, "bc_value = 0" ) );
+    EXPECT_EQ( 0, G_LUA_MANAGER->load_file( path ) );
+    EXPECT_EQ( 0, lua_pcall( L, 0, 0, 0 ) );
+    lua_getglobal( L, "bc_value" );
+    EXPECT_EQ( 1, lua_tointeger( L, -1 ) );
+    lua_pop( L, 1 );
+
+    // Исходный текст изменен - байт-код не используется.
+    f = fopen( path, "w" );
+    ASSERT_NE( nullptr, f );
+    fputs( "bc_value = 2\n", f );
+    fclose( f );
+    EXPECT_EQ( 0, G_LUA_MANAGER->load_file( path ) );
+    EXPECT_EQ( 0, lua_pcall( L, 0, 0, 0 ) );
+    lua_getglobal( L, "bc_value" );
+    EXPECT_EQ( 2, lua_tointeger( L, -1 ) );
+    lua_pop( L, 1 );
+
+    // Поврежденный кэш - загрузка исходного текста.
+    f = fopen( cache_path, "wb" );
+    ASSERT_NE( nullptr, f );
+    fputs( "PBC1", f );
+    fclose( f );
+    EXPECT_EQ( 0, G_LUA_MANAGER->load_file( path ) );
+    lua_pop( L, 1 );
+
+    // Ошибка в скрипте.
+    f = fopen( path, "w" );
+    ASSERT_NE( nullptr, f );
+    fputs( "bc_value = \n", f );
+    fclose( f );
+    EXPECT_NE( 0, G_LUA_MANAGER->load_file( path ) );
+    lua_pop( L, 1 );
+
+    // Нет файла.
+    EXPECT_NE( 0, G_LUA_MANAGER->load_file( "no_file.lua" ) );
+    lua_pop( L, 1 );
+
+    remove( path );
+    remove( cache_path );
+    G_LUA_MANAGER->free_Lua();
+    }
@@ -0,0 +1,102 @@
+#include "lua_profiler_tests.h"
+
+using namespace ::testing;
+
+TEST( lua_profiler, enter_leave )
+    {
+    auto p = G_LUA_PROFILER;
+    p->clear();
+    p->start( nullptr, lua_profiler::M_CALLS );
+    EXPECT_TRUE( lua_profiler::is_active() );
+    EXPECT_EQ( lua_profiler::M_CALLS, p->get_mode() );
+
+    auto depth = p->enter( "o1", "evaluate" );
+    EXPECT_EQ( 0u, depth );
+    auto depth2 = p->enter( "o2", "is_check_mode" );
+    EXPECT_EQ( 1u, depth2 );
+    p->leave( depth2 );
+    p->leave( depth );
+
+    depth = p->enter( "", "cip_in_evaluate" );
+    p->leave( depth );
+
+    auto st = p->get_stat( "o1:evaluate" );
+    ASSERT_NE( nullptr, st );
+    EXPECT_EQ( 1u, st->calls );
+    EXPECT_GE( st->time_all, st->time_self );
+
+    auto st2 = p->get_stat( "o1:evaluate;o2:is_check_mode" );
+    ASSERT_NE( nullptr, st2 );
+    EXPECT_EQ( 1u, st2->calls );
+    EXPECT_GE( st->time_all, st2->time_all );
+
+    EXPECT_NE( nullptr, p->get_stat( ":cip_in_evaluate" ) );
+    EXPECT_EQ( nullptr, p->get_stat( "o2:is_check_mode" ) );
+
+    // Прерванный ошибкой вложенный вызов завершается вместе с внешним.
+    depth = p->enter( "o1", "evaluate" );
+    p->enter( "o2", "is_check_mode" );
+    p->leave( depth );
+    EXPECT_EQ( 2u, st->calls );
+    EXPECT_EQ( 2u, st2->calls );
+
+    char buff[ 500 ] = { 0 };
+    auto size = p->save_as_folded( buff, sizeof( buff ) );
+    EXPECT_EQ( (int) strlen( buff ), size );
+    EXPECT_NE( nullptr, strstr( buff, "o1:evaluate;o2:is_check_mode " ) );
+    EXPECT_NE( nullptr, strstr( buff, ":cip_in_evaluate " ) );
+
+    // Недостаточный размер буфера.
+    size = p->save_as_folded( buff, 10 );
+    EXPECT_EQ( 9, size );
+
+    size = p->save_as_Lua_str( buff, sizeof( buff ) );
+    EXPECT_EQ( (int) strlen( buff ), size );
+    EXPECT_NE( nullptr, strstr( buff,
+        "[ \"o1:evaluate;o2:is_check_mode\" ] = { calls = 2, time_all = " ) );
+    EXPECT_NE( nullptr, strstr( buff, "[ \":cip_in_evaluate\" ] = { calls = 1," ) );
+    EXPECT_NE( nullptr, strstr( buff, "alloc_all = 0, alloc_self = 0 }" ) );
+
+    size = p->save_as_Lua_str( buff, 10 );
+    EXPECT_EQ( 9, size );
+
+    p->stop();
+    EXPECT_FALSE( lua_profiler::is_active() );
+    EXPECT_EQ( lua_profiler::M_OFF, p->get_mode() );
+
+    p->clear();
+    EXPECT_EQ( nullptr, p->get_stat( "o1:evaluate" ) );
+    }
+
+TEST( lua_profiler, lua_calls )
+    {
+    auto L = lua_open();
+    luaL_openlibs( L );
+    G_LUA_MANAGER->set_Lua( L );
+    auto p = G_LUA_PROFILER;
+    p->clear();
+
+    EXPECT_EQ( 0, luaL_dostring( L,
+        "function make_table() return { 1, 2, 3 } end\n"
+        "t = { f = function( self ) return #make_table() end }" ) );
+
+    p->start( L, lua_profiler::M_FULL );
+    EXPECT_EQ( 3, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+    EXPECT_EQ( 3, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+    p->stop();
+
+    // После остановки вызовы не учитываются.
+    EXPECT_EQ( 3, G_LUA_MANAGER->int_no_param_exec_lua_method( "t", "f", "" ) );
+
+    auto st = p->get_stat( "t:f" );
+    ASSERT_NE( nullptr, st );
+    EXPECT_EQ( 2u, st->calls );
+    EXPECT_GT( st->alloc_all, 0u );
+
+    char buff[ 1000 ] = { 0 };
+    p->save_as_folded( buff, sizeof( buff ) );
+    EXPECT_NE( nullptr, strstr( buff, "t:f;make_table@" ) );
+
+    p->clear();
+    G_LUA_MANAGER->free_Lua();
+    }
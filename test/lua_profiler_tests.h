@@ -0,0 +1,4 @@
+#pragma once
+#include "includes.h"
+#include "lua_profiler.h"
+#include "lua_manager.h"
@@ -26,6 +26,14 @@ class test_params_manager
 		params_manager::instance = prev_pointer;
 	}
 
+	/// Замена памяти параметров (память должна существовать дольше
+	/// менеджера параметров).
+	static void set_params_memory( params_manager* p, i_memory* mem )
+	{
+		delete p->params_mem;
+		p->params_mem = new memory_range( mem, 0, mem->get_size() );
+	}
+
 private:
 	static params_manager* prev_pointer;
 };
\ No newline at end of file
@@ -23,4 +23,40 @@ class test_tcp_communicator
     {
         tcp_communicator::instance = NULL;
     }
+
+    static void set_service(tcp_communicator* p, u_char srv_id,
+        tcp_communicator::srv_ptr fk)
+    {
+        p->services[srv_id] = fk;
+    }
+
+    static long exec_service(tcp_communicator* p, int skt)
+    {
+        return p->exec_service(skt);
+    }
+
+    static u_char* get_buf(tcp_communicator* p)
+    {
+        return p->buf;
+    }
+
+    static u_int get_in_buffer_count(tcp_communicator* p)
+    {
+        return p->in_buffer_count;
+    }
+
+    static u_int get_segments_count(tcp_communicator* p)
+    {
+        return static_cast<u_int>(p->segments.size());
+    }
+
+    static u_int get_segments_size(tcp_communicator* p)
+    {
+        return p->get_segments_size();
+    }
+
+    static const u_char* get_segment_data(tcp_communicator* p, u_int idx)
+    {
+        return p->segments[idx].data;
+    }
 };
\ No newline at end of file
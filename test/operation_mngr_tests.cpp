@@ -106,6 +106,40 @@ TEST( action, is_empty )
 	EXPECT_EQ( false, a1.is_empty() );
 	}
 
+/// @brief Действие с доступом к скомпилированным устройствам.
+class test_action : public action
+	{
+	public:
+		using action::action;
+		using action::get_all_devices;
+	};
+
+TEST( action, get_all_devices )
+	{
+	test_action a1( "action", 2 );
+	virtual_valve v1( "TEST1_V1" );
+	virtual_valve v2( "TEST1_V2" );
+	virtual_valve v3( "TEST1_V3" );
+	a1.add_dev( &v3, action::MAIN_GROUP + 1, action::MAIN_SUBGROUP );
+	a1.add_dev( &v2, action::MAIN_GROUP, action::MAIN_SUBGROUP + 1 );
+
+	auto span = a1.get_all_devices();
+	std::vector< device* > devs( span.begin(), span.end() );
+	std::vector< device* > REF_DEVS = { &v2, &v3 };
+	EXPECT_EQ( REF_DEVS, devs );
+
+	//Добавление после обращения к устройствам.
+	a1.add_dev( &v1 );
+	span = a1.get_all_devices();
+	devs.assign( span.begin(), span.end() );
+	REF_DEVS = { &v1, &v2, &v3 };
+	EXPECT_EQ( REF_DEVS, devs );
+
+	a1.clear_dev();
+	EXPECT_EQ( true, a1.is_empty() );
+	EXPECT_TRUE( a1.get_all_devices().empty() );
+	}
+
 
 TEST( open_seat_action, evaluate )
 	{
@@ -466,6 +500,54 @@ TEST( operation_state, to_next_step )
 	}
 
 
+TEST( operation_manager, get_next_evaluated_operation )
+	{
+	tech_object test_tank( "Танк1", 1, 1, "T", 10, 10, 10, 10, 10, 10 );
+	auto mngr = test_tank.get_modes_manager();
+	auto op1 = mngr->add_operation( "Test operation #1" );
+	auto op2 = mngr->add_operation( "Test operation #2" );
+	mngr->add_operation( "Test operation #3" );
+
+	//Все операции в простое без действий - ничего не выполняется.
+	EXPECT_FALSE( op1->is_evaluation_needed() );
+	EXPECT_EQ( 0u, mngr->get_next_evaluated_operation( 0 ) );
+
+	//Операция в простое с действиями (ожидание сигналов) выполняется.
+	virtual_valve V1( "V1" );
+	auto idle_step = op2->add_step( "Idle", -1, -1, operation::IDLE );
+	( *idle_step )[ step::A_ON ]->add_dev( &V1 );
+	EXPECT_TRUE( op2->is_evaluation_needed() );
+	EXPECT_EQ( 2u, mngr->get_next_evaluated_operation( 0 ) );
+	EXPECT_EQ( 0u, mngr->get_next_evaluated_operation( 2 ) );
+
+	op1->start();
+	EXPECT_TRUE( op1->is_evaluation_needed() );
+	EXPECT_EQ( 1u, mngr->get_next_evaluated_operation( 0 ) );
+	EXPECT_EQ( 2u, mngr->get_next_evaluated_operation( 1 ) );
+	EXPECT_EQ( 0u, mngr->get_next_evaluated_operation( 2 ) );
+
+	op1->switch_off();
+	EXPECT_FALSE( op1->is_evaluation_needed() );
+	EXPECT_EQ( 2u, mngr->get_next_evaluated_operation( 0 ) );
+
+	//Устройства добавлены к действию после обновления списка.
+	auto op3 = ( *mngr )[ 3 ];
+	auto idle_step3 = op3->add_step( "Idle", -1, -1, operation::IDLE );
+	EXPECT_EQ( 0u, mngr->get_next_evaluated_operation( 2 ) );
+	( *idle_step3 )[ step::A_ON ]->add_dev( &V1 );
+	EXPECT_EQ( 3u, mngr->get_next_evaluated_operation( 2 ) );
+	( *idle_step3 )[ step::A_ON ]->clear_dev();
+	EXPECT_EQ( 0u, mngr->get_next_evaluated_operation( 2 ) );
+
+	//Включение и отключение шага в простое.
+	op1->add_step( "Idle", -1, -1, operation::IDLE );
+	EXPECT_EQ( 2u, mngr->get_next_evaluated_operation( 0 ) );
+	op1->to_step( 1 );
+	EXPECT_EQ( 1u, mngr->get_next_evaluated_operation( 0 ) );
+	op1->turn_off_active_step();
+	EXPECT_EQ( 2u, mngr->get_next_evaluated_operation( 0 ) );
+	}
+
 TEST( operation, operator_at )
 	{
 	char* res = 0;
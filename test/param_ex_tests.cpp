@@ -0,0 +1,195 @@
+#include "param_ex_tests.h"
+
+using namespace ::testing;
+
+class test_flush_params_manager : public params_manager
+    {
+    public:
+        test_flush_params_manager() : params_manager()
+            {
+            }
+    };
+
+/// Память параметров в оперативной памяти (для проверки записанных данных).
+class test_params_memory : public i_memory
+    {
+    public:
+        test_params_memory() : data( params_manager::C_TOTAL_PARAMS_SIZE, 0 )
+            {
+            }
+
+        int read( void *buf, u_int count, u_int start_pos ) override
+            {
+            memcpy( buf, data.data() + start_pos, count );
+            return count;
+            }
+
+        int write( void *buf, u_int count, u_int start_pos ) override
+            {
+            memcpy( data.data() + start_pos, buf, count );
+            return count;
+            }
+
+        u_int get_size() const override
+            {
+            return data.size();
+            }
+
+        std::vector< char > data;
+    };
+
+TEST( params_manager, flush )
+    {
+    test_flush_params_manager par_mngr;
+    const int BLOCK = params_manager::C_DIRTY_BLOCK_SIZE;
+
+    EXPECT_EQ( 0u, par_mngr.get_dirty_ranges_count() );
+    EXPECT_EQ( 0u, par_mngr.flush() );
+
+    //Изменения в одном блоке объединяются.
+    par_mngr.save( 0, 4 );
+    par_mngr.save( 4, 4 );
+    EXPECT_EQ( 1u, par_mngr.get_dirty_ranges_count() );
+
+    //Соседние блоки объединяются в один диапазон.
+    par_mngr.save( BLOCK - 2, 4 );
+    EXPECT_EQ( 1u, par_mngr.get_dirty_ranges_count() );
+
+    par_mngr.save( 10 * BLOCK, 4 );
+    EXPECT_EQ( 2u, par_mngr.get_dirty_ranges_count() );
+
+    EXPECT_EQ( 2u, par_mngr.flush() );
+    EXPECT_EQ( 0u, par_mngr.get_dirty_ranges_count() );
+
+    //Много разрозненных изменений - одна запись.
+    for ( int i = 0; i <= params_manager::C_MAX_FLUSH_WRITES; i++ )
+        {
+        par_mngr.save( 2 * i * BLOCK, 4 );
+        }
+    EXPECT_EQ( params_manager::C_MAX_FLUSH_WRITES + 1u,
+        par_mngr.get_dirty_ranges_count() );
+    EXPECT_EQ( 1u, par_mngr.flush() );
+
+    //Запись всех параметров.
+    par_mngr.save();
+    EXPECT_EQ( 1u, par_mngr.get_dirty_ranges_count() );
+
+    //Без отложенной записи изменения записываются сразу.
+    par_mngr.set_flush_interval( 0 );
+    EXPECT_EQ( 0u, par_mngr.get_dirty_ranges_count() );
+    par_mngr.save( 0, 4 );
+    EXPECT_EQ( 0u, par_mngr.get_dirty_ranges_count() );
+    }
+
+TEST( params_manager, evaluate )
+    {
+    test_params_memory mem;
+    test_flush_params_manager par_mngr;
+    test_params_manager::set_params_memory( &par_mngr, &mem );
+    par_mngr.set_flush_interval( 100000 );
+
+    int start_pos = 0;
+    auto p = par_mngr.get_params_data( 4, start_pos );
+    ASSERT_NE( nullptr, p );
+    memcpy( p, "ABCD", 4 );
+
+    par_mngr.save( start_pos, 4 );
+    par_mngr.evaluate();    //Интервал не прошел.
+    EXPECT_EQ( 1u, par_mngr.get_dirty_ranges_count() );
+    EXPECT_EQ( 0, mem.data[ start_pos ] );
+
+    par_mngr.set_flush_interval( 1 );
+    sleep_ms( 2 );
+    par_mngr.evaluate();
+    EXPECT_EQ( 0u, par_mngr.get_dirty_ranges_count() );
+    EXPECT_EQ( 0, memcmp( "ABCD", mem.data.data() + start_pos, 4 ) );
+    }
+
+TEST( params_manager, flush_on_destroy )
+    {
+    test_params_memory mem;
+    auto par_mngr = new test_flush_params_manager();
+    test_params_manager::set_params_memory( par_mngr, &mem );
+    par_mngr->set_flush_interval( 100000 );
+
+    int start_pos = 0;
+    auto p = par_mngr->get_params_data( 100, start_pos );
+    ASSERT_NE( nullptr, p );
+    memcpy( p + 96, "WXYZ", 4 );
+    par_mngr->save( start_pos + 96, 4 );
+    EXPECT_EQ( 0, mem.data[ start_pos + 96 ] );
+
+    //Незаписанные изменения записываются при завершении работы.
+    delete par_mngr;
+    EXPECT_EQ( 0, memcmp( "WXYZ", mem.data.data() + start_pos + 96, 4 ) );
+    }
+
+/// Побитный расчет контрольной суммы (как до табличного расчета).
+static u_int_2 solve_CRC_bitwise( const char* data, int size, u_int project_id )
+    {
+    u_int_2 CRC = 65535;
+    const char* p = ( const char* ) &project_id;
+    for ( int i = 0; i < size + 2; i++ )
+        {
+        CRC = CRC ^ ( i < size ? data[ i ] : p[ i - size ] );
+        for ( int idx = 0; idx <= 7; idx++ )
+            {
+            char flag = CRC & 1;
+            CRC = CRC >> 1;
+            if ( flag ) CRC = CRC ^ 0x0A001;
+            }
+        }
+
+    return CRC;
+    }
+
+TEST( params_manager, solve_CRC )
+    {
+    test_flush_params_manager par_mngr;
+    const u_int PROJECT_ID = 1234;
+    par_mngr.init( PROJECT_ID );
+
+    int start_pos = 0;
+    char* data = par_mngr.get_params_data(
+        params_manager::C_TOTAL_PARAMS_SIZE, start_pos );
+    ASSERT_NE( nullptr, data );
+
+    EXPECT_EQ( solve_CRC_bitwise( data, params_manager::C_TOTAL_PARAMS_SIZE,
+        PROJECT_ID ), par_mngr.solve_CRC() );
+
+    for ( int i = 0; i < params_manager::C_TOTAL_PARAMS_SIZE; i++ )
+        {
+        data[ i ] = ( char ) ( i * 7 );
+        }
+    par_mngr.save();
+    EXPECT_EQ( solve_CRC_bitwise( data, params_manager::C_TOTAL_PARAMS_SIZE,
+        PROJECT_ID ), par_mngr.solve_CRC() );
+
+    //Изменение учитывается после сохранения.
+    data[ 100 ] = ( char ) 0xF0;
+    auto prev_CRC = par_mngr.solve_CRC();
+    EXPECT_NE( solve_CRC_bitwise( data, params_manager::C_TOTAL_PARAMS_SIZE,
+        PROJECT_ID ), prev_CRC );
+    par_mngr.save( start_pos + 100, 1 );
+    EXPECT_EQ( solve_CRC_bitwise( data, params_manager::C_TOTAL_PARAMS_SIZE,
+        PROJECT_ID ), par_mngr.solve_CRC() );
+    data[ params_manager::C_TOTAL_PARAMS_SIZE - 1 ] = 1;
+    par_mngr.save( params_manager::C_TOTAL_PARAMS_SIZE - 1, 1 );
+    EXPECT_EQ( solve_CRC_bitwise( data, params_manager::C_TOTAL_PARAMS_SIZE,
+        PROJECT_ID ), par_mngr.solve_CRC() );
+    }
+
+TEST( params_manager, restore_params_from_bin )
+    {
+    test_flush_params_manager par_mngr;
+
+    char buff[ 20 ] = { 0 };
+    EXPECT_EQ( 1, par_mngr.restore_params_from_bin( buff, 4 ) );  //Мало данных.
+    EXPECT_EQ( 1, par_mngr.restore_params_from_bin( buff, 10 ) ); //Нет сигнатуры.
+
+    u_int_4 signature = params_manager::C_BIN_BACKUP_SIGNATURE;
+    u_int_2 version = params_manager::C_BIN_BACKUP_VERSION;
+    memcpy( buff, &signature, sizeof( signature ) );
+    memcpy( buff + 4, &version, sizeof( version ) );
+    EXPECT_EQ( 1, par_mngr.restore_params_from_bin( buff, 8 ) );  //Неверная CRC.
+    }
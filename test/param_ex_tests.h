@@ -0,0 +1,4 @@
+#pragma once
+#include "includes.h"
+#include "param_ex.h"
+#include "mock_params_manager.h"
@@ -2,6 +2,9 @@
 #include <clocale>
 
 #include "g_device.h"
+#include "PAC_dev.h"
+#include "operation_mngr.h"
+#include "tech_def.h"
 #include "lua_manager.h"
 #include "log.h"
 
@@ -26,6 +29,9 @@ static void DoSetup( const benchmark::State& state )
         luaL_openlibs( L );         // Open standard libraries.
 
         G_LUA_MANAGER->init( L, "main.plua", "", "./sys/" );
+        G_LUA_MANAGER->exec_Lua_str(
+            "perf_object = { get_value = function( self, v ) return v end }",
+            "DoSetup" );
 
         device_communicator::switch_off_compression();
         auto res = G_DEVICE_CMMCTR->write_devices_states_service(
@@ -68,4 +74,179 @@ BENCHMARK_CAPTURE( write_devices_service, "no compression", false )->
 BENCHMARK_CAPTURE( write_devices_service, "with compression", true )->
     Setup( DoSetup )->Unit( benchmark::kMicrosecond );
 
+static void exec_lua_method( benchmark::State& state, bool use_cache )
+    {
+    if ( use_cache ) lua_manager::switch_on_functions_cache();
+    else lua_manager::switch_off_functions_cache();
+
+    for ( auto _ : state )
+        benchmark::DoNotOptimize( G_LUA_MANAGER->int_exec_lua_method(
+            "perf_object", "get_value", 1, "exec_lua_method" ) );
+
+    lua_manager::switch_on_functions_cache();
+    }
+
+BENCHMARK_CAPTURE( exec_lua_method, "no functions cache", false )->
+    Setup( DoSetup )->Unit( benchmark::kNanosecond );
+BENCHMARK_CAPTURE( exec_lua_method, "with functions cache", true )->
+    Setup( DoSetup )->Unit( benchmark::kNanosecond );
+
+static void lua_alloc( benchmark::State& state, bool use_pool )
+    {
+    //Скрипты описания демонстрационного проекта (рабочий каталог теста),
+    //как при инициализации (lua_manager::init).
+    const char* FILES[] =
+        {
+        "./sys/sys.io.lua",
+        "./sys/sys.devices.lua",
+        "./sys/sys.objects.lua",
+        "main.io.lua",
+        "main.objects.lua",
+        "main.modbus_srv.lua",
+        "main.profibus.lua",
+        "main.restrictions.lua",
+        };
+
+    lua_allocator allocator;
+    for ( auto _ : state )
+        {
+        auto l = use_pool ? lua_newstate( lua_allocator::alloc, &allocator ) :
+            luaL_newstate();
+        luaL_openlibs( l );
+        for ( auto file : FILES )
+            {
+            if ( luaL_dofile( l, file ) != 0 )
+                {
+                state.SkipWithError( lua_tostring( l, -1 ) );
+                break;
+                }
+            }
+        lua_gc( l, LUA_GCCOLLECT, 0 );
+        lua_close( l );
+        }
+
+    if ( use_pool )
+        {
+        state.counters.insert( {
+            { "Peak", allocator.get_peak_bytes() },
+            { "Reserved", allocator.get_reserved_bytes() } } );
+        }
+    }
+
+BENCHMARK_CAPTURE( lua_alloc, "default allocator", false )->
+    Setup( DoSetup )->Unit( benchmark::kMicrosecond );
+BENCHMARK_CAPTURE( lua_alloc, "pool allocator", true )->
+    Setup( DoSetup )->Unit( benchmark::kMicrosecond );
+
+static void lua_device_calls( benchmark::State& state, bool use_fast_methods )
+    {
+    static bool is_dev_added = false;
+    if ( !is_dev_added )
+        {
+        is_dev_added = true;
+        G_DEVICE_MANAGER()->add_io_device( device::DT_DO, device::DST_DO_VIRT,
+            "PERF_DO1", "Test DO", "" );
+        }
+
+    auto l = luaL_newstate();
+    luaL_openlibs( l );
+    tolua_PAC_dev_open( l );
+    if ( use_fast_methods ) tolua_PAC_dev_fast_open( l );
+
+    const int CALLS_CNT = 1000000;
+    luaL_dostring( l,
+        "function work( n )\n"
+        "    local dev = DO( 'PERF_DO1' )\n"
+        "    for i = 1, n, 4 do\n"
+        "        dev:on()\n"
+        "        dev:set_state( dev:get_state() )\n"
+        "        dev:off()\n"
+        "    end\n"
+        "end" );
+
+    for ( auto _ : state )
+        {
+        lua_getglobal( l, "work" );
+        lua_pushnumber( l, CALLS_CNT );
+        lua_pcall( l, 1, 0, 0 );
+        }
+    state.SetItemsProcessed( state.iterations() * CALLS_CNT );
+
+    lua_close( l );
+    }
+
+BENCHMARK_CAPTURE( lua_device_calls, "tolua++ methods", false )->
+    Setup( DoSetup )->Unit( benchmark::kMillisecond );
+BENCHMARK_CAPTURE( lua_device_calls, "fast methods", true )->
+    Setup( DoSetup )->Unit( benchmark::kMillisecond );
+
+static void steps_evaluate( benchmark::State& state )
+    {
+    const int STEPS_CNT = 1000;
+    const int STEP_DEVICES_CNT = 20;
+    const int DEVICES_CNT = 200;
+
+    std::vector< virtual_valve* > devices;
+    for ( int i = 0; i < DEVICES_CNT; i++ )
+        {
+        devices.push_back( new virtual_valve( "PERF_V" ) );
+        }
+
+    //Половина устройств шага включается, половина - выключается.
+    std::vector< step* > steps;
+    for ( int i = 0; i < STEPS_CNT; i++ )
+        {
+        auto s = new step( "Perf step", nullptr );
+        for ( int j = 0; j < STEP_DEVICES_CNT; j++ )
+            {
+            auto dev = devices[ ( i * STEP_DEVICES_CNT + j ) % DEVICES_CNT ];
+            ( *s )[ j % 2 ? step::A_OFF : step::A_ON ]->add_dev( dev );
+            }
+        steps.push_back( s );
+        }
+
+    for ( auto _ : state )
+        {
+        for ( auto s : steps )
+            {
+            s->evaluate();
+            }
+        }
+    state.SetItemsProcessed( state.iterations() * STEPS_CNT );
+
+    for ( auto s : steps ) delete s;
+    for ( auto dev : devices ) delete dev;
+    }
+
+BENCHMARK( steps_evaluate )->Setup( DoSetup )->Unit( benchmark::kMicrosecond );
+
+static void operation_state_evaluate( benchmark::State& state )
+    {
+    const int STEPS_CNT = 200;
+
+    tech_object tank( "PERF_TANK", 1, 1, "T", 10, 10, 10, 10, 10, 10 );
+    tank.get_modes_manager()->add_operation( "Perf operation" );
+    auto operation = ( *tank.get_modes_manager() )[ 1 ];
+    auto run_state = ( *operation )[ operation::RUN ];
+
+    //Все шаги включены параллельно.
+    for ( int i = 0; i < STEPS_CNT; i++ )
+        {
+        run_state->add_step( "Perf step", -1, 0 );
+        }
+    for ( int i = 1; i <= STEPS_CNT; i++ )
+        {
+        run_state->on_extra_step( i );
+        }
+
+    for ( auto _ : state )
+        {
+        run_state->evaluate();
+        }
+    state.SetItemsProcessed( state.iterations() * STEPS_CNT );
+    }
+
+BENCHMARK( operation_state_evaluate )->Setup( DoSetup )->
+    Unit( benchmark::kMicrosecond );
+
 BENCHMARK_MAIN();
@@ -2,6 +2,7 @@
 
 #include "prj_mngr_tests.h"
 #include "lua_manager.h"
+#include "g_device.h"
 
 extern const char* FILES[ FILE_CNT ];
 
@@ -117,6 +118,14 @@ Usage:
       --sys_path arg       Sys path
       --path arg           Path
       --extra_paths arg    Extra paths
+      --no_bytecode_cache  Do not use Lua bytecode cache
+      --cycle_time_ms arg  Main cycle time for Lua GC budget, ms
+      --lua_mem_limit arg  Lua memory limit (full GC when exceeded), KB
+      --hot_reload_us arg  Lua hot reload step time budget, us
+      --save_delay_ms arg  Params write-behind delay (0 - off), ms
+      --client_limit arg   Client read rate limit <rate>:<burst>
+      --cmd_limit arg      Read command rate limit <cmd>:<rate>:<burst>
+      --cmd_cache arg      Read command cache time <cmd>:<ms>
       --sleep_time_ms arg  Sleep time, ms (default: 2)
 )";
 
@@ -141,5 +150,33 @@ Resetting params (command line parameter "rcrc").
     res = G_PROJECT_MANAGER->proc_main_params( argv_path.size(), argv_path.data() );
     ASSERT_EQ( 0, res );
 
+    // Default read limits are set.
+    auto& limiter = tcp_communicator::get_limiter();
+    u_int retry_after = 0;
+    u_char get_devices[] = { device_communicator::CMD_GET_DEVICES };
+    for ( int i = 0; i < device_communicator::C_GET_DEVICES_BURST; i++ )
+        {
+        EXPECT_EQ( request_limiter::CHECK_OK,
+            limiter.check( 1, device_communicator::C_SERVICE_N,
+            get_devices, sizeof( get_devices ), retry_after ) );
+        }
+    EXPECT_EQ( request_limiter::CHECK_BUSY,
+        limiter.check( 1, device_communicator::C_SERVICE_N,
+        get_devices, sizeof( get_devices ), retry_after ) );
+
+    // Limits can be switched off by the parameters.
+    std::array<const char*, 6> argv_limits{ "ptusa_main.exe",
+        "--client_limit", "0", "--cmd_limit", "100:0", "main.plua" };
+    res = G_PROJECT_MANAGER->proc_main_params( argv_limits.size(),
+        argv_limits.data() );
+    ASSERT_EQ( 0, res );
+    for ( int i = 0; i < 2 * device_communicator::C_CLIENT_READ_BURST; i++ )
+        {
+        EXPECT_EQ( request_limiter::CHECK_OK,
+            limiter.check( 1, device_communicator::C_SERVICE_N,
+            get_devices, sizeof( get_devices ), retry_after ) );
+        }
+    limiter.clear();
+
     G_LUA_MANAGER->free_Lua();
     }
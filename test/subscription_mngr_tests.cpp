@@ -0,0 +1,240 @@
+#include "subscription_mngr_tests.h"
+
+using namespace ::testing;
+
+TEST( subscription_manager, is_match )
+    {
+    EXPECT_TRUE( subscription_manager::is_match( "*", "V1" ) );
+    EXPECT_TRUE( subscription_manager::is_match( "V*", "V1" ) );
+    EXPECT_TRUE( subscription_manager::is_match( "V?", "V1" ) );
+    EXPECT_TRUE( subscription_manager::is_match( "*1", "TANK1V1" ) );
+    EXPECT_TRUE( subscription_manager::is_match( "T*V*", "TANK1V1" ) );
+    EXPECT_TRUE( subscription_manager::is_match( "V1", "V1" ) );
+
+    EXPECT_FALSE( subscription_manager::is_match( "V?", "V10" ) );
+    EXPECT_FALSE( subscription_manager::is_match( "M*", "V1" ) );
+    EXPECT_FALSE( subscription_manager::is_match( "V1", "V" ) );
+    EXPECT_FALSE( subscription_manager::is_match( "", "V1" ) );
+    }
+
+TEST( subscription_manager, subscribe )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V2", "Test valve", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_AO, device::DST_AO_VIRT, "AO1", "Test AO", "" );
+
+    auto mngr = G_SUBSCRIPTION_MANAGER;
+    mngr->clear();
+
+    auto id = mngr->subscribe( 1, "V*", subscription_manager::C_ANY_TYPE,
+        0, 0 );
+    EXPECT_GT( id, 0 );
+    EXPECT_EQ( 2, mngr->get_devices_count( id ) );
+
+    const int BUFF_SIZE = 100;
+    char buff[ BUFF_SIZE ] = { 0 };
+    mngr->save_devices( id, buff, BUFF_SIZE );
+    char expected[ BUFF_SIZE ] = { 0 };
+    snprintf( expected, BUFF_SIZE, "sub_id=%d; devices={'V1','V2',}\n", id );
+    EXPECT_STREQ( expected, buff );
+
+    auto id_ao = mngr->subscribe( 1, "", device::DT_AO, 0, 0 );
+    EXPECT_EQ( 1, mngr->get_devices_count( id_ao ) );
+    EXPECT_EQ( 2u, mngr->get_subscriptions_count() );
+
+    //Удалять можно только свои подписки.
+    EXPECT_EQ( 1, mngr->unsubscribe( 2, id ) );
+    EXPECT_EQ( 0, mngr->unsubscribe( 1, id ) );
+    EXPECT_EQ( -1, mngr->get_devices_count( id ) );
+
+    mngr->subscribe( 2, "*", subscription_manager::C_ANY_TYPE, 0, 0 );
+    EXPECT_EQ( 2u, mngr->get_subscriptions_count() );
+    subscription_manager::on_socket_close( 1 );
+    EXPECT_EQ( 1u, mngr->get_subscriptions_count() );
+
+    mngr->clear();
+    for ( int i = 0; i < subscription_manager::C_MAX_SUBSCRIPTIONS; i++ )
+        {
+        mngr->subscribe( 1, "*", subscription_manager::C_ANY_TYPE, 0, 0 );
+        }
+    EXPECT_EQ( -1,
+        mngr->subscribe( 1, "*", subscription_manager::C_ANY_TYPE, 0, 0 ) );
+
+    mngr->clear();
+    G_DEVICE_MANAGER()->clear_io_devices();
+    }
+
+TEST( subscription_manager, save_changes )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_AO, device::DST_AO_VIRT, "AO1", "Test AO", "" );
+    auto V1 = V( "V1" );
+    auto AO1 = AO( "AO1" );
+
+    auto mngr = G_SUBSCRIPTION_MANAGER;
+    mngr->clear();
+    auto id = mngr->subscribe( 1, "*", subscription_manager::C_ANY_TYPE,
+        0, 0.5f );
+
+    const int BUFF_SIZE = 100;
+    u_char buff[ BUFF_SIZE ] = { 0 };
+
+    //Первая передача - все устройства.
+    auto size = mngr->save_changes( id, buff, BUFF_SIZE );
+    EXPECT_EQ( subscription_manager::C_HEADER_SIZE +
+        2 * subscription_manager::C_RECORD_SIZE, size );
+    u_int_2 count = 0;
+    memcpy( &count, buff + 2, sizeof( count ) );
+    EXPECT_EQ( 2, count );
+
+    //Изменений нет.
+    EXPECT_EQ( 0, mngr->save_changes( id, buff, BUFF_SIZE ) );
+
+    //Изменение в пределах зоны нечувствительности.
+    AO1->set_value( 0.3f );
+    EXPECT_EQ( 0, mngr->save_changes( id, buff, BUFF_SIZE ) );
+
+    //Изменение вне зоны нечувствительности.
+    AO1->set_value( 1.f );
+    size = mngr->save_changes( id, buff, BUFF_SIZE );
+    EXPECT_EQ( subscription_manager::C_HEADER_SIZE +
+        subscription_manager::C_RECORD_SIZE, size );
+    u_int_2 idx = 0;
+    float value = 0;
+    memcpy( &idx, buff + subscription_manager::C_HEADER_SIZE, sizeof( idx ) );
+    memcpy( &value, buff + subscription_manager::C_HEADER_SIZE + 6,
+        sizeof( value ) );
+    EXPECT_EQ( 1, idx );
+    EXPECT_EQ( 1.f, value );
+
+    //Изменение состояния передается всегда.
+    V1->on();
+    size = mngr->save_changes( id, buff, BUFF_SIZE );
+    EXPECT_EQ( subscription_manager::C_HEADER_SIZE +
+        subscription_manager::C_RECORD_SIZE, size );
+    int_4 state = 0;
+    memcpy( &idx, buff + subscription_manager::C_HEADER_SIZE, sizeof( idx ) );
+    memcpy( &state, buff + subscription_manager::C_HEADER_SIZE + 2,
+        sizeof( state ) );
+    EXPECT_EQ( 0, idx );
+    EXPECT_EQ( 1, state );
+
+    mngr->clear();
+    G_DEVICE_MANAGER()->clear_io_devices();
+    }
+
+TEST( subscription_manager, save_changes_resume )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V2", "Test valve", "" );
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V3", "Test valve", "" );
+
+    auto mngr = G_SUBSCRIPTION_MANAGER;
+    mngr->clear();
+    auto id = mngr->subscribe( 1, "*", subscription_manager::C_ANY_TYPE,
+        0, 0 );
+
+    //Пакет вмещает только одно устройство - остальные передаются в
+    //следующих пакетах.
+    const int BUFF_SIZE = subscription_manager::C_HEADER_SIZE +
+        subscription_manager::C_RECORD_SIZE;
+    u_char buff[ BUFF_SIZE ] = { 0 };
+    for ( u_int_2 i = 0; i < 3; i++ )
+        {
+        EXPECT_EQ( BUFF_SIZE, mngr->save_changes( id, buff, BUFF_SIZE ) );
+        u_int_2 idx = 0;
+        memcpy( &idx, buff + subscription_manager::C_HEADER_SIZE,
+            sizeof( idx ) );
+        EXPECT_EQ( i, idx );
+        }
+    EXPECT_EQ( 0, mngr->save_changes( id, buff, BUFF_SIZE ) );
+
+    //Проверка продолжается с устройства, следующего за переданным.
+    V( "V1" )->on();
+    V( "V3" )->on();
+    EXPECT_EQ( BUFF_SIZE, mngr->save_changes( id, buff, BUFF_SIZE ) );
+    EXPECT_EQ( BUFF_SIZE, mngr->save_changes( id, buff, BUFF_SIZE ) );
+    EXPECT_EQ( 0, mngr->save_changes( id, buff, BUFF_SIZE ) );
+
+    mngr->clear();
+    G_DEVICE_MANAGER()->clear_io_devices();
+    }
+
+TEST( subscription_manager, on_devices_clear )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "" );
+
+    auto tcp_mock = new mock_tcp_communicator();
+    test_tcp_communicator::replaceEntity( tcp_mock );
+
+    auto mngr = G_SUBSCRIPTION_MANAGER;
+    mngr->clear();
+    auto id = mngr->subscribe( 1, "*", subscription_manager::C_ANY_TYPE,
+        0, 0 );
+    EXPECT_EQ( 1, mngr->get_devices_count( id ) );
+
+    //Номера устройств недействительны - подписка отменяется.
+    G_DEVICE_MANAGER()->clear_io_devices();
+    EXPECT_EQ( 0, mngr->get_devices_count( id ) );
+    const int BUFF_SIZE = 100;
+    u_char buff[ BUFF_SIZE ] = { 0 };
+    EXPECT_EQ( 0, mngr->save_changes( id, buff, BUFF_SIZE ) );
+
+    //Сокет не найден - подписка удаляется.
+    mngr->evaluate();
+    EXPECT_EQ( 0u, mngr->get_subscriptions_count() );
+
+    test_tcp_communicator::removeObject();
+    }
+
+TEST( subscription_manager, subscription_service )
+    {
+    G_DEVICE_MANAGER()->clear_io_devices();
+    G_DEVICE_MANAGER()->add_io_device(
+        device::DT_V, device::DST_V_VIRT, "V1", "Test valve", "" );
+
+    auto tcp_mock = new mock_tcp_communicator();
+    test_tcp_communicator::replaceEntity( tcp_mock );
+
+    auto mngr = G_SUBSCRIPTION_MANAGER;
+    mngr->clear();
+
+    u_char data[ 20 ] = { 0 };
+    u_char out[ 100 ] = { 0 };
+    data[ 0 ] = subscription_manager::CMD_SUBSCRIBE;
+    u_int_2 interval = 100;
+    float deadband = 1.f;
+    memcpy( data + 1, &interval, sizeof( interval ) );
+    memcpy( data + 3, &deadband, sizeof( deadband ) );
+    data[ 7 ] = subscription_manager::C_ANY_TYPE;
+    strcpy( ( char* ) data + 8, "V1" );
+
+    auto res = subscription_manager::subscription_service( 11, data, out );
+    EXPECT_EQ( strlen( ( char* ) out ) + 1, ( size_t ) res );
+    EXPECT_EQ( 1u, mngr->get_subscriptions_count() );
+
+    //Некорректный запрос.
+    res = subscription_manager::subscription_service( 3, data, out );
+    EXPECT_STREQ( "sub_id=-1\n", ( char* ) out );
+
+    data[ 0 ] = subscription_manager::CMD_UNSUBSCRIBE_ALL;
+    res = subscription_manager::subscription_service( 1, data, out );
+    EXPECT_EQ( 2, res );
+    EXPECT_EQ( 0u, mngr->get_subscriptions_count() );
+
+    test_tcp_communicator::removeObject();
+    G_DEVICE_MANAGER()->clear_io_devices();
+    }
@@ -0,0 +1,5 @@
+#pragma once
+#include "includes.h"
+#include "subscription_mngr.h"
+#include "PAC_dev.h"
+#include "mock_tcp_communicator.h"
@@ -0,0 +1,69 @@
+#include "tcp_cmctr_tests.h"
+
+using namespace ::testing;
+
+namespace
+    {
+    const u_char SRV = 3;
+    const u_char CMD = 10;
+
+    /// Ответ больше буфера коммуникатора: данные в буфере и сегмент.
+    std::vector< u_char > big_segment( tcp_communicator::BUFSIZE, 'S' );
+    int service_calls = 0;
+
+    long int big_response_service( long int, u_char*, u_char* outdata )
+        {
+        service_calls++;
+        outdata[ 0 ] = 'B';
+        EXPECT_EQ( 0, G_CMMCTR->add_response_segment( big_segment.data(),
+            static_cast< u_int >( big_segment.size() ) ) );
+        return 1 + static_cast< long int >( big_segment.size() );
+        }
+
+    void write_request( u_char* buf )
+        {
+        buf[ 0 ] = 's';
+        buf[ 1 ] = SRV;
+        buf[ 2 ] = 1;
+        buf[ 3 ] = 1;
+        buf[ 4 ] = 0;
+        buf[ 5 ] = 1;
+        buf[ 6 ] = CMD;
+        }
+    }
+
+TEST( tcp_communicator, exec_service_cached_segments )
+    {
+    auto tcp_mock = new mock_tcp_communicator();
+    test_tcp_communicator::replaceEntity( tcp_mock );
+    test_tcp_communicator::set_service( tcp_mock, SRV, big_response_service );
+
+    auto& limiter = tcp_communicator::get_limiter();
+    limiter.clear();
+    limiter.set_cache_time( SRV, CMD, 10000 );
+    service_calls = 0;
+
+    const u_int SIZE = 1 + tcp_communicator::BUFSIZE;
+    auto buf = test_tcp_communicator::get_buf( tcp_mock );
+    write_request( buf );
+    EXPECT_EQ( SIZE, test_tcp_communicator::exec_service( tcp_mock, 1 ) );
+    EXPECT_EQ( 1, service_calls );
+    //В буфере заголовок и данные, записанные сервисом.
+    EXPECT_EQ( 6u, test_tcp_communicator::get_in_buffer_count( tcp_mock ) );
+    EXPECT_EQ( 1u, test_tcp_communicator::get_segments_count( tcp_mock ) );
+
+    //Повторный запрос - сохраненный ответ передается сегментом, без
+    //копирования в буфер.
+    write_request( buf );
+    EXPECT_EQ( SIZE, test_tcp_communicator::exec_service( tcp_mock, 1 ) );
+    EXPECT_EQ( 1, service_calls );
+    EXPECT_EQ( 5u, test_tcp_communicator::get_in_buffer_count( tcp_mock ) );
+    ASSERT_EQ( 1u, test_tcp_communicator::get_segments_count( tcp_mock ) );
+    EXPECT_EQ( SIZE, test_tcp_communicator::get_segments_size( tcp_mock ) );
+    auto data = test_tcp_communicator::get_segment_data( tcp_mock, 0 );
+    EXPECT_EQ( 'B', data[ 0 ] );
+    EXPECT_EQ( 0, memcmp( big_segment.data(), data + 1, big_segment.size() ) );
+
+    limiter.clear();
+    test_tcp_communicator::removeObject();
+    }
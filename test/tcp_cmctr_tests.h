@@ -0,0 +1,4 @@
+#pragma once
+#include "includes.h"
+#include "tcp_cmctr.h"
+#include "mock_tcp_communicator.h"
@@ -38,11 +38,11 @@ TEST( tech_object, lua_get_run_step_after_pause )
     ASSERT_EQ( 0, tank->lua_get_run_step_after_pause( OPER_N1 ) );
 
     ASSERT_EQ( 0,
-        luaL_dostring( L,
+        G_LUA_MANAGER->exec_Lua_str(
         "function o1:get_run_step_after_pause( m )\n"
         "    if m == 1 then return 2\n"
         "    else return 1 end\n"
-        "end" ) );
+        "end", "" ) );
     //Метод есть, должны быть возвращены определённые числа.
     ASSERT_EQ( STEP_N2, tank->lua_get_run_step_after_pause( OPER_N1 ) );
     ASSERT_EQ( STEP_N1, tank->lua_get_run_step_after_pause( OPER_N2 ) );
@@ -151,6 +151,48 @@ TEST( tech_object, lua_check_function )
     //корректно и вернуть 0.
     auto res = tank1.lua_check_function( "no_function", "test call", 1, true );
     ASSERT_EQ( 0, res );
+    EXPECT_EQ( 0, lua_gettop( L ) );
+
+    G_LUA_MANAGER->free_Lua();
+    }
+
+TEST( tech_object, is_lua_hook_exist )
+    {
+    lua_State* L = lua_open();
+    ASSERT_EQ( 1, tolua_PAC_dev_open( L ) );
+    G_LUA_MANAGER->set_Lua( L );
+
+    tech_object tank1( "TANK", 1, 1, "TANK1", 10, 1, 10, 10, 10, 10 );
+
+    //Нет объекта в Lua.
+    EXPECT_FALSE( tank1.is_lua_hook_exist( tech_object::LH_CHECK_ON_START ) );
+    EXPECT_EQ( 0, tank1.lua_check_on_start( 1 ) );
+
+    ASSERT_EQ( 0, luaL_dostring( L,
+        "TANK1 = {}\n"
+        "function TANK1:check_on_start( mode ) return mode + 1 end\n"
+        "function TANK1:user_check_operation_on( mode ) return 10 end" ) );
+
+    //Функции изменены в обход lua_manager - наличие прежнее.
+    EXPECT_FALSE( tank1.is_lua_hook_exist( tech_object::LH_CHECK_ON_START ) );
+    //Функции объекта изменены (как при перезагрузке скрипта).
+    G_LUA_MANAGER->clear_functions_cache();
+
+    EXPECT_TRUE( tank1.is_lua_hook_exist( tech_object::LH_CHECK_ON_START ) );
+    EXPECT_FALSE( tank1.is_lua_hook_exist( tech_object::LH_CHECK_ON_STOP ) );
+    EXPECT_FALSE( tank1.is_lua_hook_exist( tech_object::LH_CHECK_ON_MODE ) );
+    EXPECT_TRUE( tank1.is_lua_hook_exist(
+        tech_object::LH_USER_CHECK_OPERATION_ON ) );
+
+    EXPECT_EQ( 2, tank1.lua_check_on_start( 1 ) );
+    EXPECT_EQ( 0, tank1.lua_check_on_stop( 1 ) );
+
+    //Функция определена после инициализации (командой сервера).
+    ASSERT_EQ( 0, G_LUA_MANAGER->exec_Lua_str(
+        "function TANK1:check_on_stop( mode ) return mode + 2 end", "" ) );
+    EXPECT_TRUE( tank1.is_lua_hook_exist( tech_object::LH_CHECK_ON_STOP ) );
+    EXPECT_EQ( 3, tank1.lua_check_on_stop( 1 ) );
+    EXPECT_EQ( 0, lua_gettop( L ) );
 
     G_LUA_MANAGER->free_Lua();
     }
@@ -396,3 +438,46 @@ values=
 
 	G_LUA_MANAGER->free_Lua();
     }
+
+class test_tech_object_manager : public tech_object_manager
+    {
+    public:
+        test_tech_object_manager() = default;
+    };
+
+TEST( tech_object_manager, restore_params_from_bin )
+    {
+    test_tech_object_manager mngr;
+    tech_object tank1( "TANK", 1, 1, "TANK1", 2, 1, 3, 2, 2, 1 );
+    tech_object tank2( "TANK", 2, 1, "TANK2", 2, 1, 3, 2, 2, 1 );
+    mngr.add_tech_object( &tank1 );
+    mngr.add_tech_object( &tank2 );
+
+    tank1.par_float.save( 1, 1.5f );
+    tank1.rt_par_float[ 2 ] = 2.5f;
+    tank2.par_uint.save( 2, 7 );
+    tank2.rt_par_uint[ 1 ] = 9;
+
+    const int BUFF_SIZE = 200;
+    char buff[ BUFF_SIZE ] = { 0 };
+    //Наборы по 5 байт заголовка, значения - по 4 байта.
+    const int SIZE = 2 * ( 4 * 5 + ( 3 + 2 + 2 + 1 ) * 4 );
+    EXPECT_EQ( SIZE, mngr.save_params_as_bin( buff, BUFF_SIZE ) );
+    EXPECT_EQ( -1, mngr.save_params_as_bin( buff, SIZE - 1 ) );
+    EXPECT_EQ( SIZE, mngr.save_params_as_bin( buff, BUFF_SIZE ) );
+
+    tank1.par_float.reset_to_0();
+    tank1.rt_par_float.reset_to_0();
+    tank2.par_uint.reset_to_0();
+    tank2.rt_par_uint.reset_to_0();
+
+    //Неполные данные - параметры не изменяются.
+    EXPECT_EQ( 1, mngr.restore_params_from_bin( buff, SIZE - 1 ) );
+    EXPECT_EQ( 0.f, tank1.par_float[ 1 ] );
+
+    EXPECT_EQ( 0, mngr.restore_params_from_bin( buff, SIZE ) );
+    EXPECT_EQ( 1.5f, tank1.par_float[ 1 ] );
+    EXPECT_EQ( 2.5f, tank1.rt_par_float[ 2 ] );
+    EXPECT_EQ( 7u, tank2.par_uint[ 2 ] );
+    EXPECT_EQ( 9u, tank2.rt_par_uint[ 1 ] );
+    }